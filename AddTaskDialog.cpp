@@ -6,12 +6,9 @@
 #include <QDialogButtonBox>
 #include <QFormLayout>
 #include <QVBoxLayout>
-#include <QSqlQuery>
-#include <QSqlError>
-#include <QDebug>
 #include <QMessageBox>
 
-AddTaskDialog::AddTaskDialog(QWidget *parent) : QDialog(parent)
+AddTaskDialog::AddTaskDialog(const StatusRegistry &statuses, QWidget *parent) : QDialog(parent)
 {
     setWindowTitle(tr("Добавить новую задачу"));
     m_descriptionEdit = new QLineEdit(this);
@@ -21,14 +18,10 @@ AddTaskDialog::AddTaskDialog(QWidget *parent) : QDialog(parent)
     // Show a light placeholder to indicate default name when left empty
     m_descriptionEdit->setPlaceholderText(tr("Новая задача"));
 
-    // Загрузить статусы из БД
-    QSqlQuery query;
-    if (query.exec("SELECT name FROM STATUS")) {
-        while (query.next())
-            m_statusComboBox->addItem(query.value(0).toString());
-    } else {
-        qWarning() << "Failed to query STATUS list:" << query.lastError().text();
-    }
+    // Статусы приходят готовым справочником — диалог не обращается к БД из GUI-потока.
+    // id статуса хранится в данных пункта, выбор и поиск идут по нему, а не по тексту.
+    for (const StatusRegistry::Entry &entry : statuses.entries())
+        m_statusComboBox->addItem(entry.name, entry.id);
 
     QFormLayout *formLayout = new QFormLayout;
     formLayout->addRow(tr("Задание:"), m_descriptionEdit);
@@ -50,7 +43,7 @@ AddTaskDialog::AddTaskDialog(QWidget *parent) : QDialog(parent)
     setMinimumHeight(320);
 
     // По умолчанию выбираем статус "Запланировано", если он есть
-    int idx = m_statusComboBox->findText(QStringLiteral("Запланировано"));
+    int idx = m_statusComboBox->findData(statuses.id(StatusRegistry::plannedName()));
     if (idx != -1)
         m_statusComboBox->setCurrentIndex(idx);
 }
@@ -70,14 +63,20 @@ QString AddTaskDialog::getSelectedStatus() const
     return m_statusComboBox->currentText();
 }
 
-void AddTaskDialog::setTaskData(const QString &description, const QString &details, const QString &status)
+int AddTaskDialog::getSelectedStatusId() const
+{
+    const QVariant id = m_statusComboBox->currentData();
+    return id.isValid() ? id.toInt() : -1;
+}
+
+void AddTaskDialog::setTaskData(const QString &description, const QString &details, int statusId)
 {
     // Устанавливаем текст в поле ввода
     m_descriptionEdit->setText(description);
     m_detailsEdit->setPlainText(details);
 
     // Находим и устанавливаем нужный статус в выпадающем списке
-    int index = m_statusComboBox->findText(status);
+    int index = m_statusComboBox->findData(statusId);
     if (index != -1)
     { // -1 означает, что текст не найден
         m_statusComboBox->setCurrentIndex(index);
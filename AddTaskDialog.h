@@ -3,6 +3,9 @@
 
 #include <QDialog>
 #include <QObject>
+#include <QStringList>
+
+#include "StatusRegistry.h"
 
 // Forward declarations: чтобы ускорить компиляцию
 class QLineEdit;
@@ -14,11 +17,13 @@ class AddTaskDialog : public QDialog
     Q_OBJECT
 
 public:
-    explicit AddTaskDialog(QWidget *parent = nullptr);
+    // statuses — справочник STATUS в памяти (загружается потоком БД); статусы выбираются по id
+    explicit AddTaskDialog(const StatusRegistry &statuses, QWidget *parent = nullptr);
     QString getTaskDescription() const;
     QString getTaskDetails() const;
     QString getSelectedStatus() const;
-    void setTaskData(const QString &description, const QString &details, const QString &status);
+    int getSelectedStatusId() const; // -1, если справочник пуст
+    void setTaskData(const QString &description, const QString &details, int statusId);
 
 public slots:
     void accept() override;
@@ -0,0 +1,94 @@
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QLoggingCategory>
+#include <QTextStream>
+#include "TaskBenchmark.h"
+
+namespace {
+// "10000", "10k", "1M" → число задач; 0 — не разобрано
+qint64 parseCount(QString text)
+{
+    text = text.trimmed().toLower();
+    qint64 multiplier = 1;
+    if (text.endsWith(QLatin1Char('k'))) {
+        multiplier = 1000;
+        text.chop(1);
+    } else if (text.endsWith(QLatin1Char('m'))) {
+        multiplier = 1000000;
+        text.chop(1);
+    }
+    bool ok = false;
+    const qint64 value = text.toLongLong(&ok);
+    return (ok && value > 0) ? value * multiplier : 0;
+}
+}
+
+// Бенчмарки без окна: QApplication нужен для замера отрисовки, платформа по умолчанию —
+// offscreen, так что запуск работает и на Linux без дисплея (CI)
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("SelfImprovementBench"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Benchmarks on a synthetic tracker.db; JSON report to stdout or --output"));
+    parser.addHelpOption();
+    const QCommandLineOption tasksOption(QStringLiteral("tasks"), QStringLiteral("Number of tasks: 10k, 100k, 1M, ..."),
+                                         QStringLiteral("n"), QStringLiteral("100k"));
+    const QCommandLineOption seedOption(QStringLiteral("seed"), QStringLiteral("Generator seed."),
+                                        QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption dbOption(QStringLiteral("db"), QStringLiteral("Database file (default: temp dir, per size and seed)."),
+                                      QStringLiteral("path"));
+    const QCommandLineOption outputOption(QStringLiteral("output"), QStringLiteral("JSON report file."), QStringLiteral("path"));
+    const QCommandLineOption repeatOption(QStringLiteral("repeat"), QStringLiteral("Iterations per read benchmark."),
+                                          QStringLiteral("n"), QStringLiteral("5"));
+    const QCommandLineOption writeOpsOption(QStringLiteral("write-ops"), QStringLiteral("Tasks per write benchmark."),
+                                            QStringLiteral("n"), QStringLiteral("200"));
+    const QCommandLineOption pageSizeOption(QStringLiteral("page-size"), QStringLiteral("Rows per page."),
+                                            QStringLiteral("n"), QStringLiteral("50"));
+    const QCommandLineOption profileOption(QStringLiteral("profile"), QStringLiteral("Storage profile: balanced, durable, fast."),
+                                           QStringLiteral("name"));
+    const QCommandLineOption regenerateOption(QStringLiteral("regenerate"), QStringLiteral("Rebuild the database even if it exists."));
+    const QCommandLineOption verboseOption(QStringLiteral("verbose"), QStringLiteral("Keep debug logging."));
+    parser.addOptions({ tasksOption, seedOption, dbOption, outputOption, repeatOption, writeOpsOption,
+                        pageSizeOption, profileOption, regenerateOption, verboseOption });
+    parser.process(app);
+
+    QTextStream err(stderr);
+    TaskBenchmark::Options options;
+    bool seedOk = false;
+    bool repeatOk = false;
+    bool writeOpsOk = false;
+    bool pageSizeOk = false;
+    options.tasks = parseCount(parser.value(tasksOption));
+    options.seed = parser.value(seedOption).toULongLong(&seedOk);
+    options.repeat = parser.value(repeatOption).toInt(&repeatOk);
+    options.writeOps = parser.value(writeOpsOption).toInt(&writeOpsOk);
+    options.pageSize = parser.value(pageSizeOption).toInt(&pageSizeOk);
+    if (options.tasks <= 0 || !seedOk || !repeatOk || options.repeat < 1 || !writeOpsOk || options.writeOps < 1
+        || !pageSizeOk || options.pageSize < 1) {
+        err << "error: --tasks, --seed, --repeat, --write-ops and --page-size must be positive numbers" << Qt::endl;
+        return 2;
+    }
+    options.dbPath = parser.value(dbOption);
+    options.outputPath = parser.value(outputOption);
+    options.regenerate = parser.isSet(regenerateOption);
+    options.profile = StorageProfile::fromEnvironment();
+    if (parser.isSet(profileOption)) {
+        bool known = false;
+        options.profile = StorageProfile::byName(parser.value(profileOption), &known);
+        if (!known) {
+            err << "error: unknown profile " << parser.value(profileOption) << Qt::endl;
+            return 2;
+        }
+    }
+    // Отладочный лог репозитория (время схемы и т.п.) смешался бы с результатами
+    if (!parser.isSet(verboseOption))
+        QLoggingCategory::setFilterRules(QStringLiteral("*.debug=false"));
+
+    TaskBenchmark benchmark(options, err);
+    return benchmark.run();
+}
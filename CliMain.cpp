@@ -0,0 +1,27 @@
+#include <QCoreApplication>
+#include <QTextStream>
+#include "TaskCli.h"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Консольная точка входа: QCoreApplication без виджетов и платформенного плагина
+int main(int argc, char *argv[])
+{
+#ifdef _WIN32
+    // Вывод — UTF-8 (в отличие от GUI-сборки, где консоль только для отладки)
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+
+    QCoreApplication app(argc, argv);
+    // То же имя, что у GUI: общий каталог AppData и, значит, общий tracker.db
+    QCoreApplication::setApplicationName(QStringLiteral("SelfImprovementApp"));
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    TaskCli cli(out, err);
+    return cli.run(app.arguments().mid(1));
+}
@@ -0,0 +1,515 @@
+#include "DatabaseWorker.h"
+#include "Trace.h"
+
+#include "TimestampFormat.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTimer>
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+// Пауза в записях, после которой писатель переносит WAL в основной файл, мс
+constexpr int CheckpointIdleMs = 1000;
+// Сколько правка ждёт в журнале, прежде чем пачка будет зафиксирована, мс
+constexpr int WriteBehindMs = 300;
+// Размер пачки, при котором журнал фиксируется, не дожидаясь таймера
+constexpr int WriteBehindMaxBatch = 100;
+// Первое обслуживание после открытия (не мешает загрузке первой страницы) и период, мс
+constexpr int MaintenanceFirstMs = 30 * 1000;
+constexpr int MaintenanceIntervalMs = 60 * 1000;
+// Пауза между порциями обслуживания: очередь потока (страницы, правки) успевает выполниться, мс
+constexpr int MaintenanceStepMs = 20;
+// Порции: задач корзины за один DELETE, "Описаний" за одно сжатие и страниц за один incremental_vacuum
+constexpr int PurgeChunkRows = 500;
+constexpr int CompactChunkRows = 50;
+constexpr int VacuumChunkPages = 256;
+constexpr int DefaultTrashDays = 30;
+// Пауза после события файла: фиксация пишет WAL несколькими вызовами — сверяем один раз, мс
+constexpr int ExternalChangeDelayMs = 150;
+constexpr qint64 DayMs = 24 * 60 * 60 * 1000LL;
+
+int trashDaysFromEnvironment()
+{
+    bool ok = false;
+    const int days = qEnvironmentVariableIntValue("TRACKER_TRASH_DAYS", &ok);
+    return (ok && days >= 0) ? days : DefaultTrashDays;
+}
+}
+
+DatabaseWorker::DatabaseWorker(const QString &connectionName, ConnectionRole role,
+                               const std::atomic<quint64> *latestPage, const std::atomic<quint64> *blockEpoch,
+                               QObject *parent)
+    : QObject(parent)
+    , m_latestPage(latestPage)
+    , m_blockEpoch(blockEpoch)
+    , m_connectionName(connectionName)
+    , m_role(role)
+    , m_profile(StorageProfile::fromEnvironment())
+    , m_checkpointTimer(new QTimer(this)) // дочерний объект — переезжает в поток вместе с исполнителем
+    , m_flushTimer(new QTimer(this))
+    , m_maintenanceTimer(new QTimer(this))
+    , m_trashDays(trashDaysFromEnvironment())
+    , m_changeTimer(new QTimer(this))
+{
+    m_checkpointTimer->setSingleShot(true);
+    m_checkpointTimer->setInterval(CheckpointIdleMs);
+    connect(m_checkpointTimer, &QTimer::timeout, this, &DatabaseWorker::checkpoint);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(WriteBehindMs);
+    connect(m_flushTimer, &QTimer::timeout, this, &DatabaseWorker::flushWrites);
+    m_maintenanceTimer->setSingleShot(true);
+    connect(m_maintenanceTimer, &QTimer::timeout, this, &DatabaseWorker::maintenanceStep);
+    m_changeTimer->setSingleShot(true);
+    m_changeTimer->setInterval(ExternalChangeDelayMs);
+    connect(m_changeTimer, &QTimer::timeout, this, &DatabaseWorker::checkExternalChange);
+}
+
+DatabaseWorker::~DatabaseWorker() = default;
+
+void DatabaseWorker::open(const QString &path)
+{
+    // Соединение создаётся здесь, а не в конструкторе: QSqlDatabase привязано к потоку создания
+    m_repository = std::make_unique<TaskRepository>(m_connectionName);
+    if (!m_repository->open(path, m_role, m_profile)) {
+        emit opened(false, m_repository->lastError(), StatusRegistry());
+        return;
+    }
+    // Схему приводит писатель; читатели открываются после него и только читают справочник
+    const bool ready = (m_role == ConnectionRole::Reader) ? m_repository->reloadStatuses() : m_repository->initSchema();
+    if (!ready) {
+        emit opened(false, m_repository->lastError(), StatusRegistry());
+        return;
+    }
+    if (m_role == ConnectionRole::Writer) {
+        m_maintenanceTimer->start(MaintenanceFirstMs);
+        m_path = path;
+        m_dataVersion = m_repository->dataVersion();
+        watchFiles();
+    }
+    emit opened(true, QString(), m_repository->statuses());
+}
+
+void DatabaseWorker::fetchPage(const PageRequest &request)
+{
+    // Схлопывание: если за этим запросом в очереди уже стоит более новый, пропускаем его,
+    // а начатое чтение прерываем, как только появится новый запрос.
+    if (!m_repository || isStale(request.generation))
+        return;
+
+    const quint64 generation = request.generation;
+    PageResult result = m_repository->fetchPage(request, [this, generation]() { return isStale(generation); });
+    if (result.cancelled)
+        return;
+    if (result.ok && !m_repository->statusesCover(*result.page) && m_repository->reloadStatuses())
+        emit statusesChanged(m_repository->statuses());
+    emit pageReady(result);
+}
+
+void DatabaseWorker::fetchBlock(const PageRequest &request)
+{
+    // Блоки не схлопываются между собой (лента загружает несколько подряд), но все блоки
+    // прошлой сортировки/поиска пропускаются и прерываются.
+    const quint64 epoch = request.generation;
+    auto isStaleBlock = [this, epoch]() { return m_blockEpoch->load(std::memory_order_relaxed) != epoch; };
+    if (!m_repository || isStaleBlock())
+        return;
+
+    PageResult result = m_repository->fetchBlock(request, isStaleBlock);
+    if (result.cancelled)
+        return;
+    if (result.ok && !m_repository->statusesCover(*result.page) && m_repository->reloadStatuses())
+        emit statusesChanged(m_repository->statuses());
+    emit blockReady(result);
+}
+
+void DatabaseWorker::fetchDetails(int id)
+{
+    if (!m_repository) {
+        emit detailsReady(id, QString(), false, QStringLiteral("База данных не открыта"));
+        return;
+    }
+    bool ok = false;
+    const QString details = m_repository->loadDetails(id, &ok);
+    emit detailsReady(id, details, ok, ok ? QString() : m_repository->lastError());
+}
+
+void DatabaseWorker::addTask(const TaskRecord &task, int provisionalId)
+{
+    enqueueWrite(WriteResult::Added, task, {}, provisionalId);
+}
+
+void DatabaseWorker::updateTask(const TaskRecord &task)
+{
+    enqueueWrite(WriteResult::Updated, task);
+}
+
+void DatabaseWorker::setTasksStatus(const QVector<int> &ids, int statusId)
+{
+    TaskRecord task;
+    task.statusId = statusId;
+    enqueueWrite(WriteResult::StatusChanged, task, ids);
+}
+
+void DatabaseWorker::softDeleteTasks(const QVector<int> &ids)
+{
+    enqueueWrite(WriteResult::SoftDeleted, TaskRecord(), ids);
+}
+
+void DatabaseWorker::restoreTasks(const QVector<int> &ids)
+{
+    enqueueWrite(WriteResult::Restored, TaskRecord(), ids);
+}
+
+void DatabaseWorker::hardDeleteTasks(const QVector<int> &ids)
+{
+    enqueueWrite(WriteResult::HardDeleted, TaskRecord(), ids);
+}
+
+void DatabaseWorker::enqueueWrite(WriteResult::Kind kind, const TaskRecord &task, const QVector<int> &ids,
+                                  int provisionalId)
+{
+    m_journal.append(PendingWrite{ kind, task, ids, provisionalId });
+    if (m_journal.size() >= WriteBehindMaxBatch)
+        flushWrites();
+    else if (!m_flushTimer->isActive())
+        m_flushTimer->start(); // без перезапуска: при непрерывных правках первая ждёт не дольше WriteBehindMs
+}
+
+bool DatabaseWorker::applyWrite(const PendingWrite &write, WriteResult &result)
+{
+    result.kind = write.kind;
+    result.task = write.task;
+    result.ids = write.ids;
+    result.provisionalId = write.provisionalId;
+    switch (write.kind) {
+        case WriteResult::Added: return m_repository->insertTask(result.task);
+        case WriteResult::Updated: return m_repository->updateTask(result.task);
+        case WriteResult::SoftDeleted: return m_repository->softDeleteTasks(write.ids, &result.affected);
+        case WriteResult::HardDeleted: return m_repository->hardDeleteTasks(write.ids, &result.affected);
+        case WriteResult::StatusChanged: return m_repository->setTasksStatus(write.ids, write.task.statusId, &result.affected);
+        case WriteResult::Restored: return m_repository->restoreTasks(write.ids, &result.affected);
+    }
+    return false;
+}
+
+void DatabaseWorker::flushWrites()
+{
+    m_flushTimer->stop();
+    if (m_journal.isEmpty())
+        return;
+    const QVector<PendingWrite> journal = std::move(m_journal);
+    m_journal.clear();
+    TraceSpan span("db.flushWrites");
+    span.setRows(journal.size());
+
+    // Одна транзакция на пачку — одна синхронизация WAL вместо одной на правку. Правка может
+    // состоять из нескольких операторов (вставка/правка и сжатое описание, заполнение
+    // temp.bulk_ids), поэтому каждая идёт под своей точкой сохранения: при ошибке откатывается
+    // только она, остальные правки пачки остаются. Ошибки вроде SQLITE_FULL/IOERR/BUSY/NOMEM
+    // SQLite может обработать откатом всей транзакции — тогда точки сохранения уже нет,
+    // пачка прерывается и неудачными считаются все её правки (и уже применённые тоже).
+    QString batchError;
+    if (!m_repository)
+        batchError = QStringLiteral("База данных не открыта");
+    else if (!m_repository->database().transaction())
+        batchError = m_repository->database().lastError().text();
+
+    QVector<WriteResult> results(journal.size());
+    int attempted = 0; // правки, переданные applyWrite() (у них уже заполнен результат)
+    for (int i = 0; i < journal.size() && batchError.isEmpty(); ++i) {
+        WriteResult &result = results[i];
+        QSqlQuery savepoint(m_repository->database());
+        if (!savepoint.exec(QStringLiteral("SAVEPOINT write_entry"))) {
+            batchError = savepoint.lastError().text();
+            break;
+        }
+        attempted = i + 1;
+        const bool applied = applyWrite(journal[i], result);
+        if (applied && savepoint.exec(QStringLiteral("RELEASE write_entry"))) {
+            result.ok = true;
+            continue;
+        }
+        result.error = applied ? savepoint.lastError().text() : m_repository->lastError();
+        // ROLLBACK TO оставляет точку на стеке — снимаем её RELEASE. Неудача означает, что
+        // транзакции пачки больше нет.
+        if (!savepoint.exec(QStringLiteral("ROLLBACK TO write_entry"))
+            || !savepoint.exec(QStringLiteral("RELEASE write_entry"))) {
+            batchError = QStringLiteral("Транзакция пачки прервана: %1").arg(result.error);
+        }
+    }
+    if (batchError.isEmpty() && !m_repository->database().commit())
+        batchError = m_repository->database().lastError().text();
+    if (!batchError.isEmpty()) {
+        // Не сохранилась ни одна правка пачки
+        if (m_repository)
+            m_repository->database().rollback();
+        for (int i = 0; i < journal.size(); ++i) {
+            WriteResult &result = results[i];
+            if (i >= attempted) {
+                result.kind = journal[i].kind;
+                result.task = journal[i].task;
+                result.ids = journal[i].ids;
+                result.provisionalId = journal[i].provisionalId;
+            }
+            result.ok = false;
+            if (result.error.isEmpty())
+                result.error = batchError;
+        }
+    }
+    if (!batchError.isEmpty())
+        qWarning() << "Failed to flush" << journal.size() << "writes:" << batchError;
+
+    scheduleCheckpoint();
+    int failed = 0;
+    for (const WriteResult &result : results) {
+        if (!result.ok)
+            ++failed;
+        emit taskWritten(result);
+    }
+    emit writesFlushed(int(results.size()), failed);
+}
+
+void DatabaseWorker::verifyCounters()
+{
+    // Сверка видит таблицу вместе с ещё не зафиксированными правками
+    flushWrites();
+    bool repaired = false;
+    if (m_repository && m_repository->verifyCounters(&repaired) && repaired) {
+        scheduleCheckpoint();
+        emit countersRepaired();
+    }
+}
+
+void DatabaseWorker::importTasks(const QString &path, const std::atomic<bool> *cancel)
+{
+    if (!m_repository) {
+        ImportResult result;
+        result.error = QStringLiteral("База данных не открыта");
+        emit importFinished(result);
+        return;
+    }
+    flushWrites(); // импорт идёт своей транзакцией — журнал правок фиксируется до неё
+    TaskImporter importer(*m_repository);
+    importer.setCancelCheck([cancel]() { return cancel->load(std::memory_order_relaxed); });
+    importer.setProgressCallback([this](qint64 rows, qint64 bytesRead, qint64 totalBytes) {
+        emit importProgress(rows, bytesRead, totalBytes);
+    });
+    const ImportResult result = importer.importFile(path);
+    scheduleCheckpoint();
+    emit importFinished(result);
+}
+
+void DatabaseWorker::exportTasks(const QString &path, const PageRequest &request, const std::atomic<bool> *cancel)
+{
+    if (!m_repository) {
+        ExportResult result;
+        result.error = QStringLiteral("База данных не открыта");
+        emit exportFinished(result);
+        return;
+    }
+    TaskExporter exporter(*m_repository);
+    exporter.setCancelCheck([cancel]() { return cancel->load(std::memory_order_relaxed); });
+    exporter.setProgressCallback([this](qint64 rows, qint64 expectedRows) {
+        emit exportProgress(rows, expectedRows);
+    });
+    emit exportFinished(exporter.exportToFile(path, request));
+}
+
+void DatabaseWorker::backupDatabase(const QString &dir, int keep, qint64 minAgeMs, const std::atomic<bool> *cancel)
+{
+    BackupResult result;
+    if (!m_repository) {
+        result.error = QStringLiteral("База данных не открыта");
+        emit backupFinished(result);
+        return;
+    }
+    if (minAgeMs > 0) {
+        const QDateTime last = TaskBackup::lastBackupTime(dir);
+        if (last.isValid() && last.msecsTo(QDateTime::currentDateTime()) < minAgeMs) {
+            result.ok = true;
+            result.skipped = true;
+            emit backupFinished(result);
+            return;
+        }
+    }
+    TaskBackup backup(*m_repository);
+    backup.setCancelCheck([cancel]() { return cancel->load(std::memory_order_relaxed); });
+    backup.setProgressCallback([this](qint64 pages, qint64 totalPages) {
+        emit backupProgress(pages, totalPages);
+    });
+    emit backupFinished(backup.backupToDirectory(dir, keep));
+}
+
+void DatabaseWorker::emptyTrash()
+{
+    if (!m_repository || m_role != ConnectionRole::Writer)
+        return;
+    startMaintenance(std::numeric_limits<qint64>::max());
+    m_maintenanceTimer->start(0);
+}
+
+void DatabaseWorker::close()
+{
+    // Правки из журнала фиксируются до закрытия: выход из приложения их не теряет
+    flushWrites();
+    m_checkpointTimer->stop();
+    m_maintenanceTimer->stop();
+    m_changeTimer->stop();
+    delete m_fileWatcher;
+    m_fileWatcher = nullptr;
+    // Писатель переносит остаток WAL в базу и обнуляет журнал: следующий запуск начинает с пустого
+    if (m_repository && m_role == ConnectionRole::Writer)
+        m_repository->checkpoint(true);
+    m_repository.reset();
+}
+
+void DatabaseWorker::scheduleCheckpoint()
+{
+    if (m_role == ConnectionRole::Writer)
+        m_checkpointTimer->start(); // перезапуск: пока записи идут подряд, checkpoint откладывается
+}
+
+void DatabaseWorker::checkpoint()
+{
+    // PASSIVE не ждёт читателей: страницы, которые они ещё видят, перенесутся в следующий раз
+    int walPages = 0;
+    if (m_repository && !m_repository->checkpoint(false, &walPages))
+        scheduleCheckpoint();
+    else if (walPages > m_profile.checkpointPages)
+        qDebug() << "WAL checkpoint:" << walPages << "pages";
+}
+
+void DatabaseWorker::startMaintenance(qint64 purgeBefore)
+{
+    // Новый проход (или продолжение текущего с более поздней границей): сначала корзина
+    m_maintenanceActive = true;
+    m_purgeBefore = std::max(m_purgeBefore, purgeBefore);
+    m_compactPhase = false;
+    m_vacuumPhase = false;
+}
+
+void DatabaseWorker::maintenanceStep()
+{
+    if (!m_repository || m_role != ConnectionRole::Writer)
+        return;
+    // Плановый запуск: граница — срок хранения корзины
+    if (!m_maintenanceActive)
+        startMaintenance(m_trashDays > 0 ? TimestampFormat::now() - m_trashDays * DayMs : 0);
+
+    if (!m_compactPhase && !m_vacuumPhase && m_purgeBefore > 0) {
+        // Удалённые правками журнала задачи тоже попадают под очистку
+        flushWrites();
+        int rows = 0;
+        {
+            TraceSpan span("db.purgeTrash");
+            rows = m_repository->purgeTrash(m_purgeBefore, PurgeChunkRows);
+            span.setRows(std::max(rows, 0));
+        }
+        if (rows > 0) {
+            m_purgedRows += rows;
+            scheduleCheckpoint();
+        }
+        if (rows == PurgeChunkRows) {
+            m_maintenanceTimer->start(MaintenanceStepMs);
+            return;
+        }
+        m_purgeBefore = 0;
+    }
+    if (!m_vacuumPhase) {
+        // Сжатие удаляет из таблицы длинные тексты — освободившиеся страницы вернёт vacuum ниже
+        m_compactPhase = true;
+        int rows = 0;
+        {
+            TraceSpan span("db.compactDetails");
+            rows = m_repository->compactDetails(CompactChunkRows);
+            span.setRows(std::max(rows, 0));
+        }
+        if (rows > 0)
+            scheduleCheckpoint();
+        if (rows == CompactChunkRows) {
+            m_maintenanceTimer->start(MaintenanceStepMs);
+            return;
+        }
+        m_compactPhase = false;
+        m_vacuumPhase = true;
+    }
+
+    if (m_vacuumPhase && m_repository->autoVacuumMode() == 2) { // INCREMENTAL
+        int freePages = 0;
+        bool ok = false;
+        {
+            TraceSpan span("db.incrementalVacuum");
+            ok = m_repository->incrementalVacuum(VacuumChunkPages, &freePages);
+        }
+        if (ok && freePages > 0) {
+            m_maintenanceTimer->start(MaintenanceStepMs);
+            return;
+        }
+    }
+
+    // Проход завершён
+    m_maintenanceActive = false;
+    m_compactPhase = false;
+    m_vacuumPhase = false;
+    const int purged = m_purgedRows;
+    m_purgedRows = 0;
+    m_maintenanceTimer->start(MaintenanceIntervalMs);
+    if (purged > 0) {
+        qDebug() << "Trash purged:" << purged << "tasks";
+        emit trashPurged(purged);
+    }
+}
+
+void DatabaseWorker::watchFiles()
+{
+    if (!m_fileWatcher) {
+        m_fileWatcher = new QFileSystemWatcher(this);
+        // Событие только взводит таймер: пачка событий одной фиксации — одна сверка
+        connect(m_fileWatcher, &QFileSystemWatcher::fileChanged, this, [this]() {
+            watchFiles();
+            m_changeTimer->start();
+        });
+        // Каталог — чтобы заметить пересозданный WAL (наблюдение за удалённым файлом снимается)
+        connect(m_fileWatcher, &QFileSystemWatcher::directoryChanged, this, [this]() {
+            watchFiles();
+            m_changeTimer->start();
+        });
+    }
+    const QFileInfo info(m_path);
+    QStringList paths = { info.absolutePath(), info.absoluteFilePath() };
+    const QString wal = info.absoluteFilePath() + QStringLiteral("-wal");
+    if (QFileInfo::exists(wal))
+        paths.append(wal);
+    const QStringList watched = m_fileWatcher->files() + m_fileWatcher->directories();
+    for (const QString &path : paths) {
+        if (!watched.contains(path))
+            m_fileWatcher->addPath(path);
+    }
+}
+
+void DatabaseWorker::checkExternalChange()
+{
+    if (!m_repository)
+        return;
+    const int version = m_repository->dataVersion();
+    if (version < 0 || version == m_dataVersion)
+        return; // событие от собственных записей
+    m_dataVersion = version;
+    // Наши ещё не зафиксированные правки уходят в базу до перечитывания — иначе страница
+    // на мгновение показала бы их откат
+    flushWrites();
+    emit externalChange();
+}
+
+bool DatabaseWorker::isStale(quint64 generation) const
+{
+    return m_latestPage->load(std::memory_order_relaxed) != generation;
+}
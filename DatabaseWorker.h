@@ -0,0 +1,159 @@
+#ifndef DATABASEWORKER_H
+#define DATABASEWORKER_H
+
+#include "TaskRepository.h"
+#include "TaskImporter.h"
+#include "TaskExporter.h"
+#include "TaskBackup.h"
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+// Результат записи (добавление/изменение/удаление), отправляется обратно в GUI
+struct WriteResult {
+    enum Kind { Added, Updated, SoftDeleted, HardDeleted, StatusChanged, Restored };
+    Kind kind = Added;
+    bool ok = false;
+    QString error;
+    TaskRecord task; // для Added/Updated — с заполненными id, статусом и датами; StatusChanged — statusId
+    int provisionalId = -1; // Added: временный id (< -1) строки, показанной в таблице до фиксации
+    QVector<int> ids; // удаления, смена статуса, восстановление — набор id (одна операция на набор)
+    int affected = 0; // сколько строк набора изменено
+};
+Q_DECLARE_METATYPE(WriteResult)
+
+class QFileSystemWatcher;
+class QTimer;
+
+// Исполнитель запросов к БД. Живёт в отдельном потоке (см. TaskDataService) и владеет
+// собственным соединением — GUI-поток с базой напрямую не работает.
+// Писатель (ConnectionRole::Writer) один: приводит схему, выполняет все записи и checkpoint'ы
+// WAL; читатели выполняют только выборки.
+//
+// Правки (добавление/изменение/удаление, массовые операции) пишутся с отложенной фиксацией (write-behind): они
+// копятся в журнале в памяти и уходят одной транзакцией — через WriteBehindMs после первой
+// правки, сразу при WriteBehindMaxBatch правках, а также перед импортом, сверкой счётчиков,
+// экспортом и закрытием. Результат каждой правки — taskWritten(), итог пачки — writesFlushed().
+//
+// Обслуживание (только писатель): раз в MaintenanceIntervalMs корзина очищается от задач старше
+// TRACKER_TRASH_DAYS дней (по умолчанию 30, 0 — не очищать), длинные "Описания", записанные
+// мимо репозитория (импорт, синхронизация), сжимаются (TaskRepository::compactDetails()), затем
+// свободные страницы возвращаются файлу (auto_vacuum = INCREMENTAL). Работа идёт короткими порциями через таймер:
+// между ними поток успевает выполнить запросы и фиксацию правок, долгих пауз нет.
+//
+// Изменения из других процессов (второе окно, консоль, скрипты): писатель следит за файлами
+// базы и WAL (QFileSystemWatcher — без опроса, в простое ни запросов, ни CPU); после события
+// сверяет PRAGMA data_version своего соединения — он меняется только от чужих фиксаций, так
+// что собственные записи не вызывают лишних перечитываний — и сообщает externalChange().
+class DatabaseWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    // latestPage — номер последнего запроса страницы; всё, что старше, считается устаревшим.
+    // blockEpoch — текущее поколение блоков ленты (меняется при смене сортировки/поиска).
+    DatabaseWorker(const QString &connectionName, ConnectionRole role,
+                   const std::atomic<quint64> *latestPage, const std::atomic<quint64> *blockEpoch,
+                   QObject *parent = nullptr);
+    ~DatabaseWorker() override;
+
+public slots:
+    void open(const QString &path);
+    void fetchPage(const PageRequest &request);
+    void fetchBlock(const PageRequest &request);
+    // Полный текст "Описания" задачи (в странице может быть только его начало); итог — detailsReady()
+    void fetchDetails(int id);
+    // provisionalId возвращается в WriteResult — по нему GUI находит свою временную строку
+    void addTask(const TaskRecord &task, int provisionalId = -1);
+    void updateTask(const TaskRecord &task);
+    // Массовые операции над выделением (одно UPDATE/DELETE на набор id, см. TaskRepository)
+    void setTasksStatus(const QVector<int> &ids, int statusId);
+    void softDeleteTasks(const QVector<int> &ids);
+    void restoreTasks(const QVector<int> &ids);
+    void hardDeleteTasks(const QVector<int> &ids);
+    // Зафиксировать журнал правок сейчас (одна транзакция)
+    void flushWrites();
+    void verifyCounters();
+    // Импорт из файла; cancel — флаг отмены, который выставляет GUI (см. TaskDataService)
+    void importTasks(const QString &path, const std::atomic<bool> *cancel);
+    // Выгрузка списка в порядке request (сортировка/поиск) в файл
+    void exportTasks(const QString &path, const PageRequest &request, const std::atomic<bool> *cancel);
+    // Очистить всю корзину (теми же порциями, что и фоновое обслуживание)
+    void emptyTrash();
+    // Резервная копия в dir (см. TaskBackup), хранится keep последних. minAgeMs > 0 — плановая:
+    // пропускается, если последняя копия в каталоге моложе
+    void backupDatabase(const QString &dir, int keep, qint64 minAgeMs, const std::atomic<bool> *cancel);
+    void close();
+
+signals:
+    void opened(bool ok, const QString &error, const StatusRegistry &statuses);
+    // STATUS изменился (на странице встретился незнакомый статус) — справочник перечитан
+    void statusesChanged(const StatusRegistry &statuses);
+    void pageReady(const PageResult &result);
+    void blockReady(const PageResult &result);
+    void detailsReady(int id, const QString &details, bool ok, const QString &error);
+    void taskWritten(const WriteResult &result);
+    // Пачка правок зафиксирована (или откатилась): written — всего, failed — с ошибкой
+    void writesFlushed(int written, int failed);
+    void countersRepaired();
+    // Обслуживание удалило rows задач из корзины
+    void trashPurged(int rows);
+    // Базу изменило другое соединение (процесс) — показанные данные нужно перечитать
+    void externalChange();
+    void importProgress(qint64 rows, qint64 bytesRead, qint64 totalBytes);
+    void importFinished(const ImportResult &result);
+    void exportProgress(qint64 rows, qint64 expectedRows);
+    void exportFinished(const ExportResult &result);
+    void backupProgress(qint64 pages, qint64 totalPages);
+    void backupFinished(const BackupResult &result);
+
+private:
+    struct PendingWrite {
+        WriteResult::Kind kind;
+        TaskRecord task; // для StatusChanged — только statusId
+        QVector<int> ids;
+        int provisionalId = -1;
+    };
+
+    bool isStale(quint64 generation) const;
+    void enqueueWrite(WriteResult::Kind kind, const TaskRecord &task, const QVector<int> &ids = {},
+                      int provisionalId = -1);
+    bool applyWrite(const PendingWrite &write, WriteResult &result);
+    // После записи: checkpoint — когда записи стихнут (не задерживает следующую фиксацию)
+    void scheduleCheckpoint();
+    void checkpoint();
+    // Обслуживание: очистка корзины до purgeBefore (мс от эпохи), сжатие длинных "Описаний",
+    // затем incremental vacuum
+    void startMaintenance(qint64 purgeBefore);
+    void maintenanceStep();
+    // Наблюдение за файлами базы: событие файла → (пауза) → сверка data_version
+    void watchFiles();
+    void checkExternalChange();
+
+    const std::atomic<quint64> *m_latestPage;
+    const std::atomic<quint64> *m_blockEpoch;
+    QString m_connectionName;
+    ConnectionRole m_role;
+    StorageProfile m_profile;
+    QTimer *m_checkpointTimer;
+    QTimer *m_flushTimer;
+    QTimer *m_maintenanceTimer;
+    int m_trashDays;
+    bool m_maintenanceActive = false;
+    bool m_compactPhase = false; // корзина очищена, идёт сжатие "Описаний"
+    bool m_vacuumPhase = false;  // "Описания" сжаты, идёт возврат страниц
+    qint64 m_purgeBefore = 0;    // 0 — очистка не нужна
+    int m_purgedRows = 0;        // удалено за текущий проход
+    QString m_path;
+    QFileSystemWatcher *m_fileWatcher = nullptr; // создаётся в open(): в потоке исполнителя
+    QTimer *m_changeTimer;
+    int m_dataVersion = -1;
+    QVector<PendingWrite> m_journal;
+    std::unique_ptr<TaskRepository> m_repository;
+};
+
+#endif // DATABASEWORKER_H
@@ -1,5 +1,14 @@
 #include "MainWindow.h"
 #include "AddTaskDialog.h"
+#include "TaskTableModel.h"
+#include "TaskPage.h"
+#include "TaskDataService.h"
+#include "SearchHighlightDelegate.h"
+#include "StatusColorDelegate.h"
+#include "TaskTableView.h"
+#include "TaskScrollModel.h"
+#include "PerfOverlay.h"
+#include "Trace.h"
 
 #include <QMenu>
 #include <QMenuBar>
@@ -11,23 +20,37 @@
 #include <QDebug>
 #include <QStyledItemDelegate>
 #include <QPainter>
-#include <QSqlQuery>
-#include <QSqlQueryModel>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QPushButton>
 #include <QLabel>
 #include <QComboBox>
-#include <QSqlRecord>
-#include <QSqlError>
-#include <QSqlRelationalTableModel>
-#include <QSqlRelationalDelegate>
 #include <QToolBar>
 #include <QMessageBox>
-#include <QDateTime>
-#include <QStandardPaths>
+#include <QLineEdit>
+#include <QTimer>
+#include <QPair>
+#include <QCheckBox>
+#include <QScrollBar>
+#include <QFileDialog>
+#include <QProgressDialog>
+#include <QDateEdit>
 #include <QDir>
 
+#include <algorithm>
+#include <utility>
+
+namespace {
+// Пауза в наборе, после которой уходит поисковый запрос
+constexpr int SearchDebounceMs = 250;
+// Сколько строк страницы измерять при подборе ширины столбцов
+constexpr int ColumnSampleRows = 32;
+// Столбец "Задание" не шире этой доли таблицы — остальное место у растягиваемого "Описания"
+constexpr double MaxDescColumnShare = 0.4;
+// Запас к ширине текста: поля ячейки и стрелка сортировки
+constexpr int ColumnPadding = 24;
+}
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
 {
@@ -35,7 +58,7 @@ MainWindow::MainWindow(QWidget *parent)
     resize(800, 600);
     setWindowTitle("Self Improvement Tracker v1.1.0");
 
-    tableView = new QTableView(this);
+    tableView = new TaskTableView(this);
     // We'll embed the table into a central widget that also contains pagination controls
     QWidget *central = new QWidget(this);
     QVBoxLayout *centralLayout = new QVBoxLayout(central);
@@ -62,9 +85,43 @@ MainWindow::MainWindow(QWidget *parent)
     m_addTaskButton->setStyleSheet("QPushButton{background-color:#3a86ff;color:white;border-radius:4px;padding:6px 12px;} QPushButton:hover{background-color:#2f6fe0;}");
     connect(m_addTaskButton, &QPushButton::clicked, this, &MainWindow::onAddTask);
     pLay->addWidget(m_addTaskButton);
+    m_searchEdit = new QLineEdit(m_paginationWidget);
+    m_searchEdit->setPlaceholderText(tr("Поиск…"));
+    m_searchEdit->setClearButtonEnabled(true);
+    m_searchEdit->setToolTip(tr("Поиск по заданию и описанию (Ctrl+F)"));
+    m_searchEdit->setMinimumWidth(200);
+    pLay->addWidget(m_searchEdit);
+    m_dateFilterCombo = new QComboBox(m_paginationWidget);
+    m_dateFilterCombo->addItem(tr("Все даты"), -1);
+    m_dateFilterCombo->addItem(tr("Создано"), int(TaskTableModel::COL_CREATION_DT));
+    m_dateFilterCombo->addItem(tr("Выполнено"), int(TaskTableModel::COL_COMPLETION_DT));
+    m_dateFilterCombo->setToolTip(tr("Фильтр по дате"));
+    m_dateFromEdit = new QDateEdit(QDate::currentDate().addMonths(-1), m_paginationWidget);
+    m_dateToEdit = new QDateEdit(QDate::currentDate(), m_paginationWidget);
+    for (QDateEdit *edit : { m_dateFromEdit, m_dateToEdit }) {
+        edit->setCalendarPopup(true);
+        edit->setDisplayFormat(QStringLiteral("yyyy-MM-dd"));
+        edit->setEnabled(false);
+    }
+    m_dateFromEdit->setToolTip(tr("С даты (включительно)"));
+    m_dateToEdit->setToolTip(tr("По дату (включительно)"));
+    pLay->addWidget(m_dateFilterCombo);
+    pLay->addWidget(m_dateFromEdit);
+    pLay->addWidget(m_dateToEdit);
     pLay->addStretch();
-    pLay->addWidget(new QLabel(tr("Показывать по:"), m_paginationWidget));
+    m_pageSizeLabel = new QLabel(tr("Показывать по:"), m_paginationWidget);
+    pLay->addWidget(m_pageSizeLabel);
     pLay->addWidget(m_pageSizeCombo);
+    m_scrollModeCheck = new QCheckBox(tr("Лента"), m_paginationWidget);
+    m_scrollModeCheck->setToolTip(tr("Непрерывная прокрутка вместо страниц"));
+    pLay->addWidget(m_scrollModeCheck);
+    m_trashCheck = new QCheckBox(tr("Корзина"), m_paginationWidget);
+    m_trashCheck->setToolTip(tr("Показать удалённые задачи: восстановить или удалить полностью"));
+    pLay->addWidget(m_trashCheck);
+    m_selectionLabel = new QLabel(m_paginationWidget);
+    m_selectionLabel->setToolTip(tr("Выделение сохраняется при листании; Esc — снять"));
+    m_selectionLabel->hide();
+    pLay->addWidget(m_selectionLabel);
     pLay->addWidget(m_pageInfoLabel);
     centralLayout->addWidget(m_paginationWidget);
 
@@ -76,139 +133,223 @@ MainWindow::MainWindow(QWidget *parent)
 
     setCentralWidget(central);
 
-    // Delegate to color the status column based on status text
-    class StatusColorDelegate : public QStyledItemDelegate {
-    public:
-        using QStyledItemDelegate::QStyledItemDelegate;
-        void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override {
-            if (index.column() != MainWindow::COL_STATUS) {
-                QStyledItemDelegate::paint(painter, option, index);
-                return;
-            }
-
-            // If the row is selected, keep default selection rendering
-            if (option.state & QStyle::State_Selected) {
-                QStyledItemDelegate::paint(painter, option, index);
-                return;
-            }
-
-            QString status = index.data(Qt::DisplayRole).toString();
-            QColor color(Qt::white);
-            if (status == QStringLiteral("Запланировано")) color = QColor(200,200,200); // gray
-            else if (status == QStringLiteral("В процессе")) color = QColor(100,150,255); // blue
-            else if (status == QStringLiteral("Сделано")) color = QColor(180,255,180); // green
-            else if (status == QStringLiteral("Отменено")) color = QColor(255,180,180); // red
-            else if (status == QStringLiteral("Отложено")) color = QColor(255,200,120); // orange
-
-            painter->save();
-            painter->fillRect(option.rect, color);
-            painter->setFont(option.font);
-            QFontMetrics fm(option.font);
-            QString elided = fm.elidedText(status, Qt::ElideRight, option.rect.width() - 8);
-            painter->setPen(Qt::black);
-            painter->drawText(option.rect.adjusted(4, 0, -4, 0), Qt::AlignVCenter | Qt::AlignLeft, elided);
-            painter->restore();
-        }
-    };
-    // view model for paginated display
-    m_viewModel = new QSqlQueryModel(this);
+    // view model for paginated display (columnar, see TaskTableModel)
+    m_viewModel = new TaskTableModel(this);
+    // лента: блоки подгружаются по мере прокрутки (см. TaskScrollModel)
+    m_scrollModel = new TaskScrollModel(this);
+    m_scrollMode = false;
+    m_trashMode = false;
     // Initialize page size from the combo box so the initial view uses the selected value (default "10").
     m_pageSize = m_pageSizeCombo->currentText().toInt();
     m_currentPage = 0;
+    m_totalPages = 1;
+    m_firstId = -1;
+    m_lastId = -1;
+    m_baseIsFirst = true;
+    m_pendingSteps = 0;
+    m_refreshAfterFlush = false;
+    m_reloadBlocksAfterFlush = false;
+    m_restoringSelection = false;
+    m_detailsTaskId = -1;
+    m_nextProvisionalId = -2;
 
     // connect pagination UI
     connect(m_prevPageButton, &QPushButton::clicked, this, [this]() {
-        if (m_currentPage > 0) { --m_currentPage; refreshView(); }
+        if (m_currentPage > 0) { --m_currentPage; navigatePages(-1); }
     });
     connect(m_nextPageButton, &QPushButton::clicked, this, [this]() {
-        ++m_currentPage; refreshView();
+        if (m_currentPage + 1 < m_totalPages) { ++m_currentPage; navigatePages(+1); }
     });
     connect(m_pageSizeCombo, &QComboBox::currentTextChanged, this, [this](const QString &text){
         m_pageSize = text.toInt();
         m_currentPage = 0;
-        refreshView();
+        refreshView(PageSeek::First);
     });
 
+    // Поиск по мере набора: каждое нажатие лишь перезапускает таймер, запрос уходит после паузы
+    m_searchTimer = new QTimer(this);
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(SearchDebounceMs);
+    connect(m_searchEdit, &QLineEdit::textChanged, m_searchTimer, qOverload<>(&QTimer::start));
+    connect(m_searchTimer, &QTimer::timeout, this, &MainWindow::onSearchTextChanged);
+    // Enter — искать сразу, не дожидаясь паузы
+    connect(m_searchEdit, &QLineEdit::returnPressed, this, [this]() {
+        m_searchTimer->stop();
+        onSearchTextChanged();
+    });
+    connect(m_dateFilterCombo, qOverload<int>(&QComboBox::currentIndexChanged), this, &MainWindow::onDateFilterChanged);
+    connect(m_dateFromEdit, &QDateEdit::dateChanged, this, &MainWindow::onDateFilterChanged);
+    connect(m_dateToEdit, &QDateEdit::dateChanged, this, &MainWindow::onDateFilterChanged);
+    QAction *findAction = new QAction(this);
+    findAction->setShortcut(QKeySequence::Find);
+    connect(findAction, &QAction::triggered, this, [this]() {
+        m_searchEdit->setFocus();
+        m_searchEdit->selectAll();
+    });
+    addAction(findAction);
+
     // --- Меню "Файл" ---
     QAction *exitAction = new QAction(tr("В&ыход"), this);
     exitAction->setShortcut(tr("Ctrl+Q"));
     exitAction->setStatusTip(tr("Выйти из приложения"));
     connect(exitAction, &QAction::triggered, qApp, &QApplication::quit);
 
-    QMenu *fileMenu = menuBar()->addMenu(tr("&Файл"));
-    fileMenu->addAction(exitAction);
-
-    // Инициализация соединения с БД
-    initDB();
-
-    // Узнаем ID статуса "Сделано" один раз при запуске
-    m_statusDoneId = -1; // Значение по умолчанию, если не найдем
-    QSqlQuery statusQuery(m_db);
-    statusQuery.prepare("SELECT id FROM STATUS WHERE name = :name");
-    statusQuery.bindValue(":name", QStringLiteral("Сделано"));
-    if (statusQuery.exec() && statusQuery.next())
-    {
-        m_statusDoneId = statusQuery.value(0).toInt();
-    }
-    else
-    {
-        qWarning() << "CRITICAL: Could not find 'Сделано' status ID! Date logic will fail.";
-    }
-
-    // --- Настройка модели данных (RelationalTableModel) ---
-    // Используем реляционную модель, чтобы автоматически подтягивать текстовые статусы вместо ID
-    m_model = new QSqlRelationalTableModel(this, m_db);
-
-    m_model->setTable("TASK");
-
-    // Устанавливаем связь: столбец 4 ('status_id') в таблице TASK
-    // ссылается на столбец 'id' в таблице STATUS, а отображать нужно поле 'name'.
-        m_model->setRelation(MainWindow::COL_STATUS, QSqlRelation("STATUS", "id", "name"));
+    m_importAction = new QAction(tr("&Импорт…"), this);
+    m_importAction->setStatusTip(tr("Импортировать задачи из CSV или NDJSON"));
+    connect(m_importAction, &QAction::triggered, this, &MainWindow::onImportTasks);
+    m_importProgress = nullptr;
+
+    m_exportAction = new QAction(tr("&Экспорт…"), this);
+    m_exportAction->setStatusTip(tr("Выгрузить список задач в CSV, JSON или NDJSON"));
+    connect(m_exportAction, &QAction::triggered, this, &MainWindow::onExportTasks);
+    m_exportProgress = nullptr;
+
+    // Копии снимаются и по расписанию (TRACKER_BACKUP_HOURS, см. TaskDataService); восстановление —
+    // консольной командой restore-backup при закрытом приложении
+    m_backupAction = new QAction(tr("&Резервная копия"), this);
+    m_backupAction->setStatusTip(tr("Сохранить сжатую копию базы в каталог резервных копий"));
+    connect(m_backupAction, &QAction::triggered, this, [this]() {
+        m_backupAction->setEnabled(false);
+        m_data->backupNow();
+        statusBar()->showMessage(tr("Резервная копия…"));
+    });
 
-    // Устанавливаем понятные заголовки столбцов
-        m_model->setHeaderData(MainWindow::COL_DESC, Qt::Horizontal, tr("Задание"));
-        m_model->setHeaderData(MainWindow::COL_DETAILS, Qt::Horizontal, tr("Описание"));
-        m_model->setHeaderData(MainWindow::COL_CREATION_DT, Qt::Horizontal, tr("Дата создания"));
-        m_model->setHeaderData(MainWindow::COL_COMPLETION_DT, Qt::Horizontal, tr("Дата выполнения"));
-        m_model->setHeaderData(MainWindow::COL_STATUS, Qt::Horizontal, tr("Статус"));
+    // Корзина очищается и в фоне (задачи старше TRACKER_TRASH_DAYS дней, см. DatabaseWorker)
+    m_emptyTrashAction = new QAction(tr("О&чистить корзину…"), this);
+    m_emptyTrashAction->setStatusTip(tr("Удалить все задачи из корзины без возможности восстановления"));
+    connect(m_emptyTrashAction, &QAction::triggered, this, &MainWindow::onEmptyTrash);
 
-    // Фильтр Soft Delete: показываем только не удаленные задачи.
-    // Важно установить ДО вызова select().
-    m_model->setFilter("is_deleted = 0");
+    QMenu *fileMenu = menuBar()->addMenu(tr("&Файл"));
+    fileMenu->addAction(m_importAction);
+    fileMenu->addAction(m_exportAction);
+    fileMenu->addAction(m_backupAction);
+    fileMenu->addSeparator();
+    fileMenu->addAction(m_emptyTrashAction);
+    fileMenu->addSeparator();
+    fileMenu->addAction(exitAction);
 
-    // Загружаем данные из базы в модель
-    m_model->select();
+    // --- Меню "Вид": трассировка горячих путей (см. Trace) ---
+    // Панель включает трассировку на время показа; TRACKER_TRACE=1 включает её с запуска.
+    m_traceFromEnvironment = Trace::isEnabled();
+    m_perfOverlay = new PerfOverlay(tableView);
+    QAction *perfAction = new QAction(tr("&Производительность"), this);
+    perfAction->setCheckable(true);
+    perfAction->setShortcut(QKeySequence("Ctrl+Shift+P"));
+    perfAction->setStatusTip(tr("Показать p50/p99 запросов, обновления таблицы и отрисовки"));
+    connect(perfAction, &QAction::toggled, this, [this](bool on) {
+        Trace::setEnabled(on || m_traceFromEnvironment);
+        m_perfOverlay->setVisible(on);
+    });
+    QAction *saveTraceAction = new QAction(tr("Сохранить &трассировку…"), this);
+    saveTraceAction->setStatusTip(tr("Записать интервалы в формате Chrome trace (chrome://tracing, Perfetto)"));
+    connect(saveTraceAction, &QAction::triggered, this, [this]() {
+        const QString path = QFileDialog::getSaveFileName(this, tr("Сохранить трассировку"), QStringLiteral("tracker-trace.json"),
+                                                          tr("Chrome trace (*.json)"));
+        QString error;
+        if (!path.isEmpty() && !Trace::exportChromeTrace(path, &error))
+            QMessageBox::warning(this, tr("Трассировка"), tr("Не удалось сохранить файл: %1").arg(error));
+    });
+    QMenu *viewMenu = menuBar()->addMenu(tr("&Вид"));
+    viewMenu->addAction(perfAction);
+    viewMenu->addAction(saveTraceAction);
+
+    // Вся работа с БД идёт в фоновом потоке (TaskDataService); GUI только отправляет
+    // запросы и применяет результаты, поэтому окно не замирает на большой tracker.db.
+    m_data = new TaskDataService(this);
+    connect(m_data, &TaskDataService::opened, this, &MainWindow::onDatabaseOpened);
+    // STATUS изменили извне — справочник перечитан потоком БД
+    connect(m_data, &TaskDataService::statusesChanged, this, [this](const StatusRegistry &statuses) {
+        m_statuses = statuses;
+        m_statusDelegate->invalidate();
+        tableView->viewport()->update();
+    });
+    connect(m_data, &TaskDataService::pageReady, this, &MainWindow::onPageReady);
+    connect(m_data, &TaskDataService::blockReady, this, &MainWindow::onBlockReady);
+    connect(m_data, &TaskDataService::importFinished, this, &MainWindow::onImportFinished);
+    connect(m_data, &TaskDataService::importProgress, this, [this](qint64 rows, qint64 bytesRead, qint64 totalBytes) {
+        if (!m_importProgress)
+            return;
+        if (totalBytes > 0)
+            m_importProgress->setValue(int(bytesRead * 1000 / totalBytes));
+        m_importProgress->setLabelText(tr("Импортировано задач: %1").arg(rows));
+    });
+    connect(m_data, &TaskDataService::exportFinished, this, &MainWindow::onExportFinished);
+    connect(m_data, &TaskDataService::exportProgress, this, [this](qint64 rows, qint64 expectedRows) {
+        if (!m_exportProgress)
+            return;
+        if (expectedRows > 0)
+            m_exportProgress->setValue(int(qMin(rows, expectedRows) * 1000 / expectedRows));
+        m_exportProgress->setLabelText(tr("Выгружено задач: %1").arg(rows));
+    });
+    connect(m_data, &TaskDataService::backupFinished, this, &MainWindow::onBackupFinished);
+    connect(m_data, &TaskDataService::detailsReady, this, &MainWindow::onDetailsReady);
+    connect(m_data, &TaskDataService::backupProgress, this, [this](qint64 pages, qint64 totalPages) {
+        // Ход копии — в строке состояния, без диалога: копия не мешает работе
+        if (totalPages > 0)
+            statusBar()->showMessage(tr("Резервная копия: %1%").arg(pages * 100 / totalPages));
+    });
+    connect(m_scrollModel, &TaskScrollModel::blockRequested, m_data, &TaskDataService::requestBlock);
+    connect(m_scrollModeCheck, &QCheckBox::toggled, this, &MainWindow::setScrollMode);
+    connect(m_trashCheck, &QCheckBox::toggled, this, &MainWindow::setTrashMode);
+    connect(m_data, &TaskDataService::trashPurged, this, &MainWindow::onTrashPurged);
+    connect(m_data, &TaskDataService::externalChange, this, &MainWindow::onExternalChange);
+    connect(tableView->verticalScrollBar(), &QScrollBar::valueChanged, this, [this]() {
+        if (m_scrollMode)
+            updateScrollWindow();
+    });
+    connect(m_data, &TaskDataService::taskWritten, this, &MainWindow::onTaskWritten);
+    connect(m_data, &TaskDataService::writesFlushed, this, &MainWindow::onWritesFlushed);
+    // Счётчики разошлись с таблицей и были пересчитаны — обновляем подпись страниц
+    connect(m_data, &TaskDataService::countersRepaired, this, [this]() { refreshView(); });
 
     // Применяем модель к таблице
     // The table will show the paginated view model
     tableView->setModel(m_viewModel);
-    // Делегат нужен, чтобы таблица знала, как отрисовывать реляционные данные (выпадающие списки при редактировании)
-    // For editing operations we still keep a relational model (m_model) but visual display uses m_viewModel.
-    tableView->setItemDelegate(new QSqlRelationalDelegate(tableView));
-    // Create and store the custom delegate for coloring status cells so it can be
-    // reapplied after model replacements in refreshView().
-    m_statusDelegate = new StatusColorDelegate(tableView);
-    tableView->setItemDelegateForColumn(MainWindow::COL_STATUS, m_statusDelegate);
+    // Create and store the custom delegate for coloring status cells.
+    m_statusDelegate = new StatusColorDelegate(&m_statuses, tableView);
+    tableView->setItemDelegateForColumn(TaskTableModel::COL_STATUS, m_statusDelegate);
+    // Подсветка совпадений в результатах поиска
+    m_highlightDelegate = new SearchHighlightDelegate(tableView);
+    tableView->setItemDelegateForColumn(TaskTableModel::COL_DESC, m_highlightDelegate);
+    tableView->setItemDelegateForColumn(TaskTableModel::COL_DETAILS, m_highlightDelegate);
 
     // --- Настройка внешнего вида таблицы ---
     // Скрываем технические столбцы: ID (0) и флаг удаления (5)
-        tableView->hideColumn(MainWindow::COL_ID);
-        tableView->hideColumn(MainWindow::COL_IS_DELETED);
+        tableView->hideColumn(TaskTableModel::COL_ID);
+        tableView->hideColumn(TaskTableModel::COL_IS_DELETED);
 
-    // Настраиваем поведение выделения: только одна строка целиком.
-    // Это упрощает логику удаления и выглядит лучше.
+    // Выделение строками целиком, несколько строк (Shift/Ctrl): удаление и смена статуса
+    // применяются ко всему выделению одним запросом. Выделение хранится по id (m_selectedIds)
+    // и переживает листание страниц.
     tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
-    tableView->setSelectionMode(QAbstractItemView::SingleSelection);
+    tableView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    connectSelectionModel();
+    QAction *clearSelectionAction = new QAction(tableView);
+    clearSelectionAction->setShortcut(QKeySequence(Qt::Key_Escape));
+    clearSelectionAction->setShortcutContext(Qt::WidgetShortcut);
+    connect(clearSelectionAction, &QAction::triggered, this, &MainWindow::clearTaskSelection);
+    tableView->addAction(clearSelectionAction);
     tableView->setEditTriggers(QAbstractItemView::NoEditTriggers); // Запрет изменений по double-click RMB.
 
-    // Подгоняем ширину столбцов: делаем столбец с описанием растягивающимся,
-    // остальные подгоняем под содержимое — это улучшает читаемость при изменении ширины окна.
+    // Ширина столбцов: "Описание" растягивается, остальные подбираются по выборке строк
+    // (fitColumns) и дальше только растут — без ResizeToContents, который измеряет каждую
+    // строку на каждом обновлении, и без "прыжков" ширины при листании.
     QHeaderView *header = tableView->horizontalHeader();
-    header->setSectionResizeMode(MainWindow::COL_DESC, QHeaderView::ResizeToContents);
-    header->setSectionResizeMode(MainWindow::COL_DETAILS, QHeaderView::Stretch);
-    header->setSectionResizeMode(MainWindow::COL_CREATION_DT, QHeaderView::ResizeToContents);
-    header->setSectionResizeMode(MainWindow::COL_COMPLETION_DT, QHeaderView::ResizeToContents);
-    header->setSectionResizeMode(MainWindow::COL_STATUS, QHeaderView::ResizeToContents);
+    header->setSectionResizeMode(QHeaderView::Interactive);
+    header->setSectionResizeMode(TaskTableModel::COL_DETAILS, QHeaderView::Stretch);
+    m_userSizedColumns = 0;
+    m_fittingColumns = false;
+    connect(header, &QHeaderView::sectionResized, this, [this](int section) {
+        // Ширину, выставленную пользователем, больше не трогаем
+        if (!m_fittingColumns && section >= 0 && section < 32)
+            m_userSizedColumns |= (1u << section);
+    });
+
+    // Одинаковая высота строк: представлению не нужно спрашивать sizeHint у каждой строки
+    QHeaderView *rows = tableView->verticalHeader();
+    rows->setSectionResizeMode(QHeaderView::Fixed);
+    rows->setDefaultSectionSize(tableView->fontMetrics().height() + 10);
+    tableView->setWordWrap(false);
     // Enable clickable sorting via header
     tableView->setSortingEnabled(true);
     m_sortColumn = -1;
@@ -237,215 +378,66 @@ MainWindow::MainWindow(QWidget *parent)
     m_mainToolBar->hide();
 
     statusBar()->showMessage(tr("Готов к работе"));
-    // initial fill
-    refreshView();
+    // Инициализация БД; первая страница — в onDatabaseOpened(): читатели открываются только
+    // после того, как писатель привёл схему
+    m_data->open(TaskRepository::defaultDatabasePath());
 }
 
 MainWindow::~MainWindow()
 {
-    if (m_db.isOpen())
-    {
-        m_db.close();
-    }
+    // m_data (дочерний объект) дожидается записей из очереди и закрывает соединение
 }
 
-void MainWindow::initDB()
+void MainWindow::onDatabaseOpened(bool ok, const QString &error, const StatusRegistry &statuses)
 {
-    m_db = QSqlDatabase::addDatabase("QSQLITE");
-    // 1. Находим "правильное" место для хранения данных
-    // (Это будет C:/Users/ТвоёИмя/AppData/Local/SelfImprovementApp)
-    QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-
-    // 2. Убеждаемся, что эта папка существует
-    QDir dir(dataPath);
-    if (!dir.exists())
+    if (!ok)
     {
-           dir.mkpath(dataPath); // Создаем её, если нет
-    }
-
-    // 3. Устанавливаем полный путь к БД
-    QString dbPath = dataPath + "/tracker.db";
-    qDebug() << "Database path set to:" << dbPath;
-
-    m_db.setDatabaseName(dbPath);
-    if (!m_db.open())
-    {
-        qCritical() << "Database connection failed:" << m_db.lastError().text();
+        qCritical() << "Database connection failed:" << error;
         QMessageBox::critical(this, tr("Ошибка БД"), tr("Не удалось подключиться к базе данных."));
+        return;
     }
-    else
-    {
-        qDebug() << "Database connected successfully.";
-
-        QSqlQuery query(m_db);
-        // Включаем поддержку внешних ключей (для SQLite это важно)
-        query.exec("PRAGMA foreign_keys = ON;");
-
-        // 1. Создаем таблицу статусов (справочник)
-        QString createStatusTable = "CREATE TABLE IF NOT EXISTS STATUS ("
-                                    "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-                                    "name TEXT NOT NULL UNIQUE);";
-        if (!query.exec(createStatusTable))
-        {
-              qCritical() << "Failed to create 'STATUS' table:" << query.lastError().text();
-        }
-
-        // 2. Создаем основную таблицу задач
-        QString createTaskTable = "CREATE TABLE IF NOT EXISTS TASK ("
-                                  "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-                                  "description TEXT NOT NULL, "
-                                  "details TEXT, "
-                                  "creation_dt TEXT, "
-                                  "completion_dt TEXT, "
-                                  "status_id INTEGER, "
-                                  "is_deleted INTEGER DEFAULT 0, "
-                                  "FOREIGN KEY(status_id) REFERENCES STATUS(id));";
-        if (!query.exec(createTaskTable))
-        {
-              qCritical() << "Failed to create 'TASK' table:" << query.lastError().text();
-        }
-
-        // Ensure `details` column exists AND is in the expected position.
-        // Older DBs may lack the column or have it appended at the end (SQLite ALTER TABLE adds columns at the end).
-        QSqlQuery pragmaCheck(m_db);
-        QStringList cols;
-        if (pragmaCheck.exec("PRAGMA table_info('TASK');")) {
-            while (pragmaCheck.next()) {
-                cols << pragmaCheck.value("name").toString();
-            }
-        }
-
-        int idxDetails = cols.indexOf("details");
-        if (idxDetails == -1) {
-            // Column missing: add it (simple ALTER is fine)
-            qDebug() << "Adding 'details' column to existing TASK table...";
-            if (!query.exec("ALTER TABLE TASK ADD COLUMN details TEXT;")) {
-                qCritical() << "Failed to add 'details' column:" << query.lastError().text();
-            }
-        } else if (idxDetails != 2) {
-            // Column exists but in wrong position — rebuild table with desired column order
-            qDebug() << "Rebuilding TASK table to normalize column order...";
-            QString createNew = "CREATE TABLE IF NOT EXISTS TASK_new ("
-                                "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-                                "description TEXT NOT NULL, "
-                                "details TEXT, "
-                                "creation_dt TEXT, "
-                                "completion_dt TEXT, "
-                                "status_id INTEGER, "
-                                "is_deleted INTEGER DEFAULT 0, "
-                                "FOREIGN KEY(status_id) REFERENCES STATUS(id));";
-            if (!query.exec("BEGIN TRANSACTION;")) qWarning() << query.lastError().text();
-            if (!query.exec(createNew)) {
-                qCritical() << "Failed to create TASK_new:" << query.lastError().text();
-            } else {
-                // Copy data by column names to preserve values regardless of physical order
-                QString copySql = "INSERT INTO TASK_new (id, description, details, creation_dt, completion_dt, status_id, is_deleted) "
-                                  "SELECT id, description, details, creation_dt, completion_dt, status_id, is_deleted FROM TASK;";
-                if (!query.exec(copySql)) {
-                    qCritical() << "Failed to copy data to TASK_new:" << query.lastError().text();
-                } else {
-                    if (!query.exec("DROP TABLE TASK;")) {
-                        qCritical() << "Failed to drop old TASK table:" << query.lastError().text();
-                    } else if (!query.exec("ALTER TABLE TASK_new RENAME TO TASK;")) {
-                        qCritical() << "Failed to rename TASK_new to TASK:" << query.lastError().text();
-                    }
-                }
-            }
-            if (!query.exec("COMMIT;")) qWarning() << query.lastError().text();
-        }
-
-        // 3. Заполняем/дополняем справочник начальными значениями.
-        // Если таблица пустая — вставляем полный набор. Если непустая — добавляем недостающие значения.
-        QStringList requiredStatuses = {"Запланировано", "В процессе", "Сделано", "Отложено", "Отменено"};
-        if (query.exec("SELECT COUNT(*) FROM STATUS") && query.next() && query.value(0).toInt() == 0)
-        {
-            qDebug() << "Populating 'STATUS' table with default values...";
-            for (const QString &s : requiredStatuses) {
-                QSqlQuery ins(m_db);
-                ins.prepare("INSERT INTO STATUS (name) VALUES (:name);");
-                ins.bindValue(":name", s);
-                if (!ins.exec())
-                    qWarning() << "Failed to insert status" << s << ins.lastError().text();
-            }
-        } else {
-            // Ensure specific statuses exist (add missing ones)
-            for (const QString &s : requiredStatuses) {
-                QSqlQuery chk(m_db);
-                chk.prepare("SELECT COUNT(*) FROM STATUS WHERE name = :name");
-                chk.bindValue(":name", s);
-                if (chk.exec() && chk.next()) {
-                    if (chk.value(0).toInt() == 0) {
-                        QSqlQuery ins(m_db);
-                        ins.prepare("INSERT INTO STATUS (name) VALUES (:name);");
-                        ins.bindValue(":name", s);
-                        if (!ins.exec())
-                            qWarning() << "Failed to insert missing status" << s << ins.lastError().text();
-                    }
-                }
-            }
-        }
-    }
+    m_statuses = statuses;
+    // Открытие читателей уже стоит в их очередях (TaskDataService) — страница встаёт следом
+    refreshView(PageSeek::First);
+    // Сверка счётчиков идёт в потоке писателя и не задерживает первую страницу
+    m_data->verifyCounters();
 }
 
 void MainWindow::onAddTask()
 {
-    AddTaskDialog dialog(this);
+    TraceSpan openSpan("ui.dialogOpen");
+    AddTaskDialog dialog(m_statuses, this);
+    openSpan.finish();
     if (dialog.exec() == QDialog::Accepted)
     {
-        QString description = dialog.getTaskDescription();
-        QString details = dialog.getTaskDetails();
-        QString statusName = dialog.getSelectedStatus();
-        QString creationTime = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss");
-
-        // 1. Получаем ID статуса по выбранному имени; если выбранный статус не найден,
-        // используем 'Запланировано' как рекомендованный по умолчанию, иначе fallback = 1.
-        QSqlQuery statusQuery(m_db);
-        statusQuery.prepare("SELECT id FROM STATUS WHERE name = :name");
-        statusQuery.bindValue(":name", statusName);
-        int statusId = 0;
-        if (statusQuery.exec() && statusQuery.next()) {
-            statusId = statusQuery.value(0).toInt();
-        } else {
-            QString defaultStatusName = QStringLiteral("Запланировано");
-            QSqlQuery getDefault(m_db);
-            getDefault.prepare("SELECT id FROM STATUS WHERE name = :name");
-            getDefault.bindValue(":name", defaultStatusName);
-            if (getDefault.exec() && getDefault.next()) {
-                statusId = getDefault.value(0).toInt();
-            } else {
-                statusId = 1; // ultimate fallback
+        TaskRecord task;
+        task.description = dialog.getTaskDescription();
+        task.details = dialog.getTaskDetails();
+        task.statusId = dialog.getSelectedStatusId();
+        task.statusName = dialog.getSelectedStatus();
+        task.creationDt = TimestampFormat::now();
+        const int doneId = m_statuses.id(StatusRegistry::doneName());
+        if (doneId != -1 && task.statusId == doneId)
+            task.completionDt = task.creationDt;
+        // Вставка выполняется в потоке БД с отложенной фиксацией. Строка показывается сразу,
+        // с временным id; onTaskWritten() подставит настоящий. На странице — вверху (перечитанная
+        // после пачки страница поставит задачу на место в сортировке), в ленте — сразу на место
+        // в загруженном блоке.
+        const int provisionalId = m_nextProvisionalId--;
+        m_data->addTask(task, provisionalId);
+        if (m_trashMode)
+            return;
+        TaskPage row;
+        row.appendTask(provisionalId, task.description, task.details, task.creationDt, task.completionDt,
+                       task.statusId, task.statusName);
+        if (m_scrollMode) {
+            if (m_scrollModel->insertSorted(row, 0) == TaskScrollModel::InsertResult::Inserted) {
+                tableView->scrollTo(m_scrollModel->index(m_scrollModel->rowForId(provisionalId), TaskTableModel::COL_DESC));
+                updateScrollInfo();
             }
-        }
-
-        // 2. Вставляем данные через прямой SQL-запрос (вместо insertRecord)
-        QSqlQuery insertQuery(m_db);
-        insertQuery.prepare("INSERT INTO TASK (description, details, creation_dt, completion_dt, status_id, is_deleted) "
-                    "VALUES (:desc, :details, :created, :completed, :status_id, 0)");
-
-        insertQuery.bindValue(":desc", description);
-        insertQuery.bindValue(":details", details);
-        insertQuery.bindValue(":created", creationTime);
-
-        // Если задача создаётся сразу со статусом "Сделано", ставим completion_dt = creationTime
-        QVariant completionDt;
-        if (m_statusDoneId != -1 && statusId == m_statusDoneId) {
-            completionDt = creationTime;
-        }
-        insertQuery.bindValue(":completed", completionDt);
-        insertQuery.bindValue(":status_id", statusId);
-
-        if (insertQuery.exec())
-        {
-            // 3. Обновляем представление
-            m_model->select();
-            refreshView();
-            statusBar()->showMessage(tr("Задача успешно добавлена!"));
-        }
-        else
-        {
-            qCritical() << "Failed to insert new task:" << insertQuery.lastError().text();
-            QMessageBox::critical(this, tr("Ошибка"),
-                                  tr("Не удалось добавить задачу в базу данных."));
+        } else {
+            m_viewModel->insertTask(0, row, 0);
+            tableView->scrollToTop();
         }
     }
 }
@@ -457,14 +449,37 @@ void MainWindow::onCustomContextMenu(const QPoint &pos)
     if (!index.isValid())
         return;
 
-    // Удобство: при ПКМ автоматически выделяем строку под курсором,
-    // чтобы действия (редактировать/удалить) применялись к этой строке.
-    tableView->selectRow(index.row());
+    // ПКМ по невыделенной строке выделяет только её; по выделенной — действия применяются
+    // ко всему выделению, включая строки на других страницах.
+    if (!tableView->selectionModel()->isRowSelected(index.row(), QModelIndex())) {
+        clearTaskSelection();
+        tableView->selectRow(index.row());
+    }
+    const int count = int(m_selectedIds.size());
 
     QMenu contextMenu(this);
+    if (m_trashMode) {
+        // В корзине задачу можно только вернуть или удалить окончательно
+        QAction *actionRestore = contextMenu.addAction(count > 1 ? tr("Восстановить (%1)").arg(count) : tr("Восстановить"));
+        QAction *actionHardDelete = contextMenu.addAction(count > 1 ? tr("Удалить полностью (%1)").arg(count)
+                                                                    : tr("Удалить полностью"));
+        connect(actionRestore, &QAction::triggered, this, &MainWindow::onRestoreTasks);
+        connect(actionHardDelete, &QAction::triggered, this, &MainWindow::onDeleteHard);
+        contextMenu.exec(tableView->viewport()->mapToGlobal(pos));
+        return;
+    }
     QAction *actionEdit = contextMenu.addAction(tr("Редактировать"));
-    QAction *actionSoftDelete = contextMenu.addAction(tr("Удалить (в корзину)"));
-    QAction *actionHardDelete = contextMenu.addAction(tr("Удалить полностью"));
+    actionEdit->setEnabled(count <= 1);
+    QMenu *statusMenu = contextMenu.addMenu(count > 1 ? tr("Статус (%1)").arg(count) : tr("Статус"));
+    for (const StatusRegistry::Entry &entry : m_statuses.entries()) {
+        QAction *action = statusMenu->addAction(entry.name);
+        connect(action, &QAction::triggered, this, [this, statusId = entry.id]() { submitStatusChange(statusId); });
+    }
+    contextMenu.addSeparator();
+    QAction *actionSoftDelete = contextMenu.addAction(count > 1 ? tr("Удалить в корзину (%1)").arg(count)
+                                                                : tr("Удалить (в корзину)"));
+    QAction *actionHardDelete = contextMenu.addAction(count > 1 ? tr("Удалить полностью (%1)").arg(count)
+                                                                : tr("Удалить полностью"));
 
     // Используем connect с лямбдами или прямыми слотами
     connect(actionEdit, &QAction::triggered, this, &MainWindow::onEditTask);
@@ -477,51 +492,74 @@ void MainWindow::onCustomContextMenu(const QPoint &pos)
 
 void MainWindow::onDeleteSoft()
 {
-    // Получаем список выделенных строк (благодаря SingleSelection там будет максимум одна)
-    QModelIndexList selectedRows = tableView->selectionModel()->selectedRows();
-    if (selectedRows.isEmpty())
-        return;
-
-    int row = selectedRows.first().row();
-    int taskId = m_viewModel->data(m_viewModel->index(row, 0)).toInt();
-
-    QSqlQuery q(m_db);
-    q.prepare("UPDATE TASK SET is_deleted = 1 WHERE id = :id");
-    q.bindValue(":id", taskId);
-    if (q.exec()) {
-        refreshView();
-        statusBar()->showMessage(tr("Задача перемещена в корзину"));
-    } else {
-        QMessageBox::warning(this, tr("Ошибка БД"), q.lastError().text());
-    }
+    submitDelete(false);
 }
 
 void MainWindow::onDeleteHard()
 {
-    QModelIndexList selectedRows = tableView->selectionModel()->selectedRows();
-    if (selectedRows.isEmpty())
+    const int count = int(m_selectedIds.size());
+    if (count == 0)
         return;
 
     // Запрашиваем подтверждение, так как действие необратимо
     QMessageBox::StandardButton reply;
     reply = QMessageBox::question(this, tr("Подтверждение"),
-                                  tr("Вы уверены, что хотите удалить эту задачу? Это действие нельзя будет отменить."),
+                                  count == 1
+                                      ? tr("Вы уверены, что хотите удалить эту задачу? Это действие нельзя будет отменить.")
+                                      : tr("Удалить выделенные задачи (%1)? Это действие нельзя будет отменить.").arg(count),
                                   QMessageBox::Yes | QMessageBox::No);
 
     if (reply == QMessageBox::Yes)
-    {
-        int row = selectedRows.first().row();
-        int taskId = m_viewModel->data(m_viewModel->index(row, 0)).toInt();
-        QSqlQuery q(m_db);
-        q.prepare("DELETE FROM TASK WHERE id = :id");
-        q.bindValue(":id", taskId);
-        if (q.exec()) {
-            refreshView();
-            statusBar()->showMessage(tr("Задача удалена полностью"));
-        } else {
-            QMessageBox::warning(this, tr("Ошибка БД"), q.lastError().text());
-        }
-    }
+        submitDelete(true);
+}
+
+void MainWindow::onRestoreTasks()
+{
+    submitRestore();
+}
+
+void MainWindow::onEmptyTrash()
+{
+    const QMessageBox::StandardButton reply = QMessageBox::question(
+        this, tr("Очистить корзину"), tr("Удалить все задачи из корзины? Это действие нельзя будет отменить."),
+        QMessageBox::Yes | QMessageBox::No);
+    if (reply != QMessageBox::Yes)
+        return;
+    // Очистка идёт в потоке писателя порциями; итог — onTrashPurged()
+    m_data->emptyTrash();
+    statusBar()->showMessage(tr("Очистка корзины…"));
+}
+
+void MainWindow::onTrashPurged(int rows)
+{
+    statusBar()->showMessage(tr("Удалено из корзины: %1").arg(rows));
+    // Живой список очистка не меняет
+    if (m_trashMode)
+        refreshView();
+}
+
+void MainWindow::onExternalChange()
+{
+    // Страница перечитывается на месте (updatePage() — только разница); в ленте — только
+    // загруженные блоки, позиция прокрутки сохраняется
+    if (m_scrollMode)
+        m_scrollModel->reloadBlocks();
+    else
+        refreshView();
+    statusBar()->showMessage(tr("Данные обновлены: база изменена другим процессом"), 3000);
+}
+
+void MainWindow::setTrashMode(bool enabled)
+{
+    if (m_trashMode == enabled)
+        return;
+    m_trashMode = enabled;
+    // Выделение относится к другому списку
+    clearTaskSelection();
+    m_addTaskAction->setEnabled(!enabled);
+    m_addTaskButton->setEnabled(!enabled);
+    m_currentPage = 0;
+    refreshView(PageSeek::First);
 }
 
 void MainWindow::onEditTask()
@@ -534,124 +572,87 @@ void MainWindow::onEditTask()
         return;
     }
 
-    int row = selectedRows.first().row();
+    // При нескольких выделенных строках редактируется текущая (под фокусом)
+    const QModelIndex current = tableView->currentIndex();
+    int row = (current.isValid() && tableView->selectionModel()->isRowSelected(current.row(), QModelIndex()))
+        ? current.row() : selectedRows.first().row();
 
-    // 2. Извлекаем текущие данные из view model (пагинация)
-    // Нам нужны: ID (0), Описание (1), Подробное описание (2) и Имя Статуса (5)
-    int taskId = m_viewModel->data(m_viewModel->index(row, 0)).toInt();
-    QString currentDesc = m_viewModel->data(m_viewModel->index(row, 1)).toString();
-    QString currentDetails = m_viewModel->data(m_viewModel->index(row, 2)).toString();
-    QString currentStatus = m_viewModel->data(m_viewModel->index(row, 5)).toString();
-
-    // 3. Создаем диалог и заполняем его данными
-    AddTaskDialog dialog(this);
-    dialog.setWindowTitle(tr("Редактировать задачу")); // Меняем заголовок
-    dialog.setTaskData(currentDesc, currentDetails, currentStatus);
-
-    // 4. Запускаем диалог и ждем, пока пользователь нажмет "ОК"
-    if (dialog.exec() == QDialog::Accepted)
-    {
-        // 5. Получаем НОВЫЕ данные из диалога
-        QString newDesc = dialog.getTaskDescription();
-        QString newDetails = dialog.getTaskDetails();
-        QString newStatusName = dialog.getSelectedStatus();
-
-        // 6. Получаем ID нового статуса
-        QSqlQuery statusQuery(m_db);
-        statusQuery.prepare("SELECT id FROM STATUS WHERE name = :name");
-        statusQuery.bindValue(":name", newStatusName);
-        int newStatusId = 1; // "В процессе" по умолчанию
-        if (statusQuery.exec() && statusQuery.next())
-        {
-            newStatusId = statusQuery.value(0).toInt();
-        }
-
-        // 7. *** ВОТ ОНА! ЧИСТАЯ ЛОГИКА ДАТЫ ***
-        QVariant completionDt; // По умолчанию NULL
-        if (newStatusId == m_statusDoneId)
-        {
-            // Если статус "Сделано", ставим текущую дату
-            completionDt = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss");
-        }
-
-        // 8. Подготавливаем и выполняем прямой SQL-запрос UPDATE
-        QSqlQuery updateQuery(m_db);
-        updateQuery.prepare("UPDATE TASK SET "
-                    "description = :desc, "
-                    "details = :details, "
-                    "status_id = :status_id, "
-                    "completion_dt = :completion_dt "
-                    "WHERE id = :id");
-
-        updateQuery.bindValue(":desc", newDesc);
-        updateQuery.bindValue(":details", newDetails);
-        updateQuery.bindValue(":status_id", newStatusId);
-        updateQuery.bindValue(":completion_dt", completionDt);
-        updateQuery.bindValue(":id", taskId);
-
-        if (updateQuery.exec())
-        {
-            m_model->select(); // Keep relational model in sync
-            refreshView();
-            statusBar()->showMessage(tr("Задача успешно обновлена!"));
-        }
-        else
-        {
-            qCritical() << "Failed to update task:" << updateQuery.lastError().text();
-            QMessageBox::critical(this, tr("Ошибка"), tr("Не удалось обновить задачу."));
-        }
-    }
+    openTaskDialog(row, tr("Редактировать задачу"));
 }
 
 void MainWindow::onTableDoubleClicked(const QModelIndex &index)
 {
     if (!index.isValid())
         return;
+    openTaskDialog(index.row(), tr("Просмотр / редактирование задачи"));
+}
 
-    int row = index.row();
-
-    int taskId = m_viewModel->data(m_viewModel->index(row, 0)).toInt();
-    QString currentDesc = m_viewModel->data(m_viewModel->index(row, 1)).toString();
-    QString currentDetails = m_viewModel->data(m_viewModel->index(row, 2)).toString();
-    QString currentStatus = m_viewModel->data(m_viewModel->index(row, 5)).toString();
+void MainWindow::openTaskDialog(int row, const QString &title)
+{
+    if (currentModel()->taskId(row) < 0) {
+        // Временная строка добавленной задачи: правка по id возможна только после записи
+        statusBar()->showMessage(tr("Задача ещё сохраняется…"));
+        return;
+    }
+    if (!currentModel()->hasMoreDetails(row)) {
+        showTaskDialog(row, title, currentModel()->text(row, TaskTableModel::COL_DETAILS));
+        return;
+    }
+    // Страница хранит только начало длинного "Описания" — полный текст читает поток БД.
+    // Повторный запрос той же задачи, пока ответ не пришёл, не нужен.
+    const int taskId = currentModel()->taskId(row);
+    if (m_detailsTaskId == taskId)
+        return;
+    m_detailsTaskId = taskId;
+    m_detailsDialogTitle = title;
+    statusBar()->showMessage(tr("Загрузка описания…"));
+    m_data->loadDetails(taskId);
+}
 
-    AddTaskDialog dialog(this);
-    dialog.setWindowTitle(tr("Просмотр / редактирование задачи"));
-    dialog.setTaskData(currentDesc, currentDetails, currentStatus);
+void MainWindow::onDetailsReady(int id, const QString &details, bool ok, const QString &error)
+{
+    if (id != m_detailsTaskId)
+        return; // пользователь уже открыл другую задачу
+    m_detailsTaskId = -1;
+    statusBar()->clearMessage();
+    if (!ok) {
+        QMessageBox::warning(this, tr("Ошибка БД"), tr("Не удалось загрузить описание задачи:\n%1").arg(error));
+        return;
+    }
+    // Пока текст загружался, страница могла смениться
+    const int row = currentModel()->rowForId(id);
+    if (row < 0)
+        return;
+    showTaskDialog(row, m_detailsDialogTitle, details);
+}
 
+void MainWindow::showTaskDialog(int row, const QString &title, const QString &details)
+{
+    // Нам нужны: ID, Описание, Подробное описание и Имя Статуса
+    int taskId = currentModel()->taskId(row);
+    QString currentDesc = currentModel()->text(row, TaskTableModel::COL_DESC);
+    int currentStatus = currentModel()->statusId(row);
+
+    // Создаем диалог и заполняем его данными
+    TraceSpan openSpan("ui.dialogOpen");
+    AddTaskDialog dialog(m_statuses, this);
+    dialog.setWindowTitle(title);
+    dialog.setTaskData(currentDesc, details, currentStatus);
+    openSpan.finish();
+
+    // Запускаем диалог и ждем, пока пользователь нажмет "ОК"
     if (dialog.exec() == QDialog::Accepted)
     {
-        QString newDesc = dialog.getTaskDescription();
-        QString newDetails = dialog.getTaskDetails();
-        QString newStatusName = dialog.getSelectedStatus();
-
-        QSqlQuery statusQuery(m_db);
-        statusQuery.prepare("SELECT id FROM STATUS WHERE name = :name");
-        statusQuery.bindValue(":name", newStatusName);
-        int newStatusId = 1;
-        if (statusQuery.exec() && statusQuery.next())
-            newStatusId = statusQuery.value(0).toInt();
-
-        QVariant completionDt;
-        if (newStatusId == m_statusDoneId)
-            completionDt = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss");
-
-        QSqlQuery updateQuery(m_db);
-        updateQuery.prepare("UPDATE TASK SET description = :desc, details = :details, status_id = :status_id, completion_dt = :completion_dt WHERE id = :id");
-        updateQuery.bindValue(":desc", newDesc);
-        updateQuery.bindValue(":details", newDetails);
-        updateQuery.bindValue(":status_id", newStatusId);
-        updateQuery.bindValue(":completion_dt", completionDt);
-        updateQuery.bindValue(":id", taskId);
-
-        if (updateQuery.exec()) {
-            m_model->select();
-            refreshView();
-            statusBar()->showMessage(tr("Задача обновлена"));
-        } else {
-            qCritical() << "Failed to update task (double-click):" << updateQuery.lastError().text();
-            QMessageBox::critical(this, tr("Ошибка"), tr("Не удалось сохранить изменения."));
-        }
+        // Получаем НОВЫЕ данные из диалога и отправляем UPDATE в поток БД.
+        // Статус передаётся id из справочника; completion_dt ("Сделано" — текущая дата, иначе NULL)
+        // проставит репозиторий, до фиксации таблица показывает оценку (submitTaskUpdate).
+        TaskRecord task;
+        task.id = taskId;
+        task.description = dialog.getTaskDescription();
+        task.details = dialog.getTaskDetails();
+        task.statusId = dialog.getSelectedStatusId();
+        task.statusName = dialog.getSelectedStatus();
+        submitTaskUpdate(task);
     }
 }
 
@@ -668,8 +669,10 @@ void MainWindow::onHeaderClicked(int section)
         m_sortOrder = Qt::AscendingOrder;
     }
 
-    // Apply sort to the view by re-querying with new ORDER BY
-    refreshView();
+    // Apply sort to the view by re-querying with new ORDER BY.
+    // Keyset anchors belong to the previous order, so start from the first page.
+    m_currentPage = 0;
+    refreshView(PageSeek::First);
 
     // Update visual indicator
     QHeaderView *header = tableView->horizontalHeader();
@@ -677,62 +680,691 @@ void MainWindow::onHeaderClicked(int section)
     header->setSortIndicatorShown(true);
 }
 
-void MainWindow::refreshView()
+void MainWindow::onSearchTextChanged()
 {
-    // compute total rows
-    QSqlQuery countQ(m_db);
-    int total = 0;
-    if (countQ.exec("SELECT COUNT(*) FROM TASK WHERE is_deleted = 0")) {
-        if (countQ.next()) total = countQ.value(0).toInt();
+    const QString text = m_searchEdit->text().trimmed();
+    if (text == m_searchText)
+        return;
+    m_searchText = text;
+    // Новый запрос получает следующий номер поколения — если предыдущий поиск ещё
+    // выполняется, поток БД прервёт его (progress handler) и сразу возьмётся за этот.
+    m_currentPage = 0;
+    refreshView(PageSeek::First);
+}
+
+void MainWindow::onDateFilterChanged()
+{
+    const bool enabled = m_dateFilterCombo->currentData().toInt() >= 0;
+    m_dateFromEdit->setEnabled(enabled);
+    m_dateToEdit->setEnabled(enabled);
+    // Смена дат при выключенном фильтре на выборку не влияет
+    if (!enabled && sender() != m_dateFilterCombo)
+        return;
+    m_currentPage = 0;
+    refreshView(PageSeek::First);
+}
+
+void MainWindow::applyFilters(PageRequest &request) const
+{
+    request.trash = m_trashMode;
+    request.dateColumn = m_dateFilterCombo->currentData().toInt();
+    if (request.dateColumn < 0)
+        return;
+    // Локальные сутки → полуинтервал в мс UTC: "по" включает весь последний день
+    const QDate from = qMin(m_dateFromEdit->date(), m_dateToEdit->date());
+    const QDate to = qMax(m_dateFromEdit->date(), m_dateToEdit->date());
+    request.dateFrom = from.startOfDay().toMSecsSinceEpoch();
+    request.dateTo = to.addDays(1).startOfDay().toMSecsSinceEpoch();
+}
+
+void MainWindow::navigatePages(int delta)
+{
+    // Клики копятся относительно последней показанной страницы: пока запрос в пути,
+    // следующий клик заменяет его запросом "на N страниц от якоря" (старый схлопнется).
+    m_pendingSteps += delta;
+    requestPage();
+}
+
+void MainWindow::refreshView(PageSeek seek)
+{
+    TraceSpan span("ui.refreshView");
+    if (m_scrollMode) {
+        // Лента начинается заново: блоки прежней сортировки/поиска устаревают целиком.
+        // После записей — только если новые строки встали среди выгруженных блоков (см.
+        // TaskScrollModel::insertSorted()) или удалённые в них не были загружены.
+        PageRequest base;
+        base.sortColumn = m_sortColumn;
+        base.sortOrder = m_sortOrder;
+        base.search = m_searchText;
+        applyFilters(base);
+        m_data->resetBlocks();
+        m_scrollModel->reset(base);
+        return;
     }
+    if (seek == PageSeek::First) {
+        // Новая сортировка/размер страницы: старые якоря больше не действуют
+        m_baseIsFirst = true;
+        m_pendingSteps = 0;
+    }
+    requestPage();
+}
 
-    int offset = m_currentPage * m_pageSize;
-    if (offset < 0) offset = 0;
+void MainWindow::requestPage()
+{
+    // База — последняя показанная страница (или начало списка) плюс накопленные клики
+    PageSeek seek = PageSeek::Reload;
+    if (m_baseIsFirst)
+        seek = PageSeek::First;
+    else if (m_pendingSteps != 0)
+        seek = (m_pendingSteps > 0) ? PageSeek::Forward : PageSeek::Backward;
+
+    PageRequest request;
+    request.sortColumn = m_sortColumn;
+    request.sortOrder = m_sortOrder;
+    request.pageSize = m_pageSize;
+    request.page = m_currentPage;
+    request.seek = seek;
+    request.steps = qAbs(m_pendingSteps);
+    request.firstKey = m_firstKey;
+    request.firstId = m_firstId;
+    request.lastKey = m_lastKey;
+    request.lastId = m_lastId;
+    // При поиске страница выбирается по номеру (m_currentPage уже сдвинут кнопками)
+    request.search = m_searchText;
+    applyFilters(request);
+    m_data->requestPage(request);
+}
+
+void MainWindow::onPageReady(const PageResult &result)
+{
+    if (!result.ok) {
+        qWarning() << "Failed to load task page:" << result.error;
+        if (!result.request.search.isEmpty())
+            statusBar()->showMessage(tr("Ошибка поиска: %1").arg(result.error));
+        return;
+    }
+    // Страница, запрошенная до включения ленты
+    if (m_scrollMode)
+        return;
+
+    TraceSpan span("ui.pageReady");
+    TraceSpan setPageSpan("ui.setPage");
+    m_restoringSelection = true; // сброс модели снимает выделение в таблице, m_selectedIds его переживает
+    // Перечитана та же страница (после записи): модель применяет только разницу — удалённые,
+    // вставленные и изменённые строки, без сброса; прокрутка и выделение остаются на месте
+    if (result.request.seek == PageSeek::Reload)
+        m_viewModel->updatePage(result.page);
+    else
+        m_viewModel->setPage(result.page);
+    m_restoringSelection = false;
+    const TaskPage &page = *result.page;
+    const int rows = page.rowCount();
+    setPageSpan.setRows(rows);
+    setPageSpan.finish();
+    restoreSelection();
+    span.setRows(rows);
+    m_currentPage = result.pageIndex;
+
+    // Страница показана — теперь она база для следующих переходов
+    m_baseIsFirst = false;
+    m_pendingSteps = 0;
+    if (rows > 0) {
+        m_firstId = page.taskId(0);
+        m_firstKey = TaskRepository::sortKeyValue(page, 0, m_sortColumn);
+        m_lastId = page.taskId(rows - 1);
+        m_lastKey = TaskRepository::sortKeyValue(page, rows - 1, m_sortColumn);
+    } else {
+        m_firstId = m_lastId = -1;
+        m_firstKey = m_lastKey = QVariant();
+        m_baseIsFirst = true;
+    }
+
+    // Ensure technical columns remain hidden when the view model is reset
+    tableView->hideColumn(TaskTableModel::COL_ID);
+    tableView->hideColumn(TaskTableModel::COL_IS_DELETED);
+    fitColumns(page);
+
+    const int total = result.total;
+    m_totalPages = qMax(1, (total + m_pageSize - 1) / m_pageSize);
+    if (m_currentPage >= m_totalPages) m_currentPage = m_totalPages - 1;
+    const QString pageInfo = (result.request.search.isEmpty() && !TaskRepository::hasDateFilter(result.request))
+        ? tr("Стр. %1 / %2 (%3)").arg(m_currentPage+1).arg(m_totalPages).arg(total)
+        : tr("Стр. %1 / %2 (найдено: %3)").arg(m_currentPage+1).arg(m_totalPages).arg(total);
+    m_pageInfoLabel->setText(result.request.trash ? tr("Корзина: %1").arg(pageInfo) : pageInfo);
+    m_prevPageButton->setEnabled(m_currentPage > 0);
+    m_nextPageButton->setEnabled((m_currentPage+1) < m_totalPages && rows == m_pageSize);
+}
+
+void MainWindow::onImportTasks()
+{
+    const QString path = QFileDialog::getOpenFileName(this, tr("Импорт задач"), QString(),
+                                                      tr("CSV (*.csv);;NDJSON (*.ndjson *.jsonl);;Все файлы (*)"));
+    if (path.isEmpty())
+        return;
+
+    // Импорт идёт в потоке БД одной транзакцией; "Отмена" откатывает его целиком
+    m_importAction->setEnabled(false);
+    m_importProgress = new QProgressDialog(tr("Импорт…"), tr("Отмена"), 0, 1000, this);
+    m_importProgress->setWindowTitle(tr("Импорт задач"));
+    m_importProgress->setAttribute(Qt::WA_DeleteOnClose);
+    m_importProgress->setMinimumDuration(0);
+    m_importProgress->setAutoClose(false);
+    m_importProgress->setAutoReset(false);
+    connect(m_importProgress, &QProgressDialog::canceled, m_data, &TaskDataService::cancelImport);
+    m_importProgress->show();
+    m_data->importTasks(path);
+}
+
+void MainWindow::onImportFinished(const ImportResult &result)
+{
+    m_importAction->setEnabled(true);
+    if (m_importProgress) {
+        m_importProgress->close();
+        m_importProgress = nullptr;
+    }
+
+    if (result.cancelled) {
+        statusBar()->showMessage(tr("Импорт отменён, изменения откачены"));
+        return;
+    }
+    if (!result.ok) {
+        QMessageBox::warning(this, tr("Импорт"), tr("Импорт не выполнен, изменения откачены:\n%1").arg(result.error));
+        return;
+    }
+
+    QString message = tr("Импортировано задач: %1").arg(result.imported);
+    if (result.skipped > 0)
+        message += tr(", пропущено: %1").arg(result.skipped);
+    if (result.unknownStatus > 0)
+        message += tr(", с неизвестным статусом (записаны как \"Запланировано\"): %1").arg(result.unknownStatus);
+    statusBar()->showMessage(message);
+    refreshView();
+}
+
+void MainWindow::onExportTasks()
+{
+    const QString path = QFileDialog::getSaveFileName(this, tr("Экспорт задач"), QStringLiteral("tasks.csv"),
+                                                      tr("CSV (*.csv);;JSON (*.json);;NDJSON (*.ndjson *.jsonl)"));
+    if (path.isEmpty())
+        return;
+
+    // Выгружается весь список в том порядке, что на экране (с учётом поиска и фильтра по дате)
+    PageRequest request;
+    request.sortColumn = m_sortColumn;
+    request.sortOrder = m_sortOrder;
+    request.search = m_searchText;
+    applyFilters(request);
+
+    m_exportAction->setEnabled(false);
+    m_exportProgress = new QProgressDialog(tr("Экспорт…"), tr("Отмена"), 0, 1000, this);
+    m_exportProgress->setWindowTitle(tr("Экспорт задач"));
+    m_exportProgress->setAttribute(Qt::WA_DeleteOnClose);
+    m_exportProgress->setMinimumDuration(0);
+    m_exportProgress->setAutoClose(false);
+    m_exportProgress->setAutoReset(false);
+    connect(m_exportProgress, &QProgressDialog::canceled, m_data, &TaskDataService::cancelExport);
+    m_exportProgress->show();
+    m_data->exportTasks(path, request);
+}
+
+void MainWindow::onExportFinished(const ExportResult &result)
+{
+    m_exportAction->setEnabled(true);
+    if (m_exportProgress) {
+        m_exportProgress->close();
+        m_exportProgress = nullptr;
+    }
+
+    if (result.cancelled) {
+        statusBar()->showMessage(tr("Экспорт отменён"));
+        return;
+    }
+    if (!result.ok) {
+        QMessageBox::warning(this, tr("Экспорт"), tr("Экспорт не выполнен:\n%1").arg(result.error));
+        return;
+    }
+    statusBar()->showMessage(tr("Выгружено задач: %1 (%2 КБ)").arg(result.rows).arg((result.bytes + 1023) / 1024));
+}
+
+void MainWindow::onBackupFinished(const BackupResult &result)
+{
+    m_backupAction->setEnabled(true);
+    // Плановая проверка без новой копии — не показываем
+    if (result.skipped)
+        return;
+    if (result.cancelled) {
+        statusBar()->showMessage(tr("Резервная копия отменена"));
+        return;
+    }
+    if (!result.ok) {
+        statusBar()->showMessage(tr("Резервная копия не создана: %1").arg(result.error));
+        return;
+    }
+    statusBar()->showMessage(tr("Резервная копия: %1 (%2 МБ)")
+                                 .arg(QDir::toNativeSeparators(result.path))
+                                 .arg(double(result.bytes) / (1024 * 1024), 0, 'f', 1));
+}
+
+void MainWindow::onBlockReady(const PageResult &result)
+{
+    TraceSpan span("ui.blockReady");
+    if (!result.ok) {
+        qWarning() << "Failed to load task block:" << result.error;
+        if (!result.request.search.isEmpty())
+            statusBar()->showMessage(tr("Ошибка поиска: %1").arg(result.error));
+    }
+    const bool first = (m_scrollModel->rowCount() == 0);
+    m_restoringSelection = true;
+    m_scrollModel->applyBlock(result);
+    m_restoringSelection = false;
+    restoreSelection();
+    if (first && result.ok)
+        fitColumns(*result.page);
+    // Пришедший блок мог оказаться в видимой области (или её надо продолжить)
+    updateScrollWindow();
+    updateScrollInfo();
+}
+
+void MainWindow::setScrollMode(bool enabled)
+{
+    if (m_scrollMode == enabled)
+        return;
+    m_scrollMode = enabled;
+    m_prevPageButton->setVisible(!enabled);
+    m_nextPageButton->setVisible(!enabled);
+    m_pageSizeLabel->setVisible(!enabled);
+    m_pageSizeCombo->setVisible(!enabled);
+
+    tableView->setModel(currentModel());
+    connectSelectionModel();
+    tableView->hideColumn(TaskTableModel::COL_ID);
+    tableView->hideColumn(TaskTableModel::COL_IS_DELETED);
+    if (!enabled) {
+        // Возврат к страницам: освобождаем блоки ленты
+        m_data->resetBlocks();
+        m_scrollModel->clear();
+    }
+    m_currentPage = 0;
+    refreshView(PageSeek::First);
+}
+
+void MainWindow::updateScrollWindow()
+{
+    const int rows = m_scrollModel->rowCount();
+    if (rows == 0)
+        return;
+    int first = tableView->rowAt(0);
+    int last = tableView->rowAt(tableView->viewport()->height() - 1);
+    if (first < 0)
+        first = 0;
+    if (last < 0)
+        last = rows - 1;
+    m_scrollModel->setVisibleRows(first, last);
+}
+
+void MainWindow::updateScrollInfo()
+{
+    m_pageInfoLabel->setText(tr("Загружено %1 из %2 (в памяти %3)")
+                                 .arg(m_scrollModel->rowCount())
+                                 .arg(m_scrollModel->total())
+                                 .arg(m_scrollModel->loadedRows()));
+}
+
+TaskTableModel *MainWindow::currentModel() const
+{
+    return m_scrollMode ? m_scrollModel : m_viewModel;
+}
+
+void MainWindow::onTaskWritten(const WriteResult &result)
+{
+    // Результат одной правки из зафиксированной пачки; итог пачки — в onWritesFlushed()
+    if (!result.ok) {
+        QString what;
+        switch (result.kind) {
+            case WriteResult::Added:
+                what = tr("Не удалось добавить задачу «%1»").arg(result.task.description);
+                break;
+            case WriteResult::Updated:
+                what = tr("Не удалось обновить задачу #%1").arg(result.task.id);
+                break;
+            case WriteResult::SoftDeleted:
+                what = tr("Не удалось переместить задачи в корзину (%1 шт.)").arg(result.ids.size());
+                break;
+            case WriteResult::HardDeleted:
+                what = tr("Не удалось удалить задачи (%1 шт.)").arg(result.ids.size());
+                break;
+            case WriteResult::StatusChanged:
+                what = tr("Не удалось сменить статус задач (%1 шт.)").arg(result.ids.size());
+                break;
+            case WriteResult::Restored:
+                what = tr("Не удалось восстановить задачи (%1 шт.)").arg(result.ids.size());
+                break;
+        }
+        m_writeErrors.append(result.error.isEmpty() ? what : tr("%1: %2").arg(what, result.error));
+        // Таблица уже показывала правку — возвращаем строке состояние из базы. Лента перечитывает
+        // загруженные блоки на месте; временная строка несохранённой задачи убирается сразу.
+        if (m_scrollMode) {
+            if (result.kind == WriteResult::Added && result.provisionalId < -1)
+                m_scrollModel->removeTasks({ result.provisionalId });
+            m_reloadBlocksAfterFlush = true;
+        } else {
+            m_refreshAfterFlush = true;
+        }
+        return;
+    }
 
-    // Map sort column to DB column name
-    QString orderBy = "creation_dt DESC";
-    if (m_sortColumn >= 0) {
-        switch (m_sortColumn) {
-            case MainWindow::COL_DESC: orderBy = "description"; break;
-            case MainWindow::COL_DETAILS: orderBy = "details"; break;
-            case MainWindow::COL_CREATION_DT: orderBy = "creation_dt"; break;
-            case MainWindow::COL_COMPLETION_DT: orderBy = "completion_dt"; break;
-            case MainWindow::COL_STATUS: orderBy = "STATUS.name"; break;
-            default: orderBy = "creation_dt"; break;
+    switch (result.kind) {
+        case WriteResult::Updated: {
+            // Строка могла уйти со страницы, пока шла запись — тогда обновлять нечего.
+            // Точные значения (дата выполнения) — из репозитория, таблица показывала оценку.
+            const int row = currentModel()->rowForId(result.task.id);
+            if (row >= 0) {
+                applyTaskUpdate(row, result.task.description, result.task.details,
+                                result.task.completionDt, result.task.statusId, result.task.statusName);
+            }
+            break;
+        }
+        case WriteResult::Added: {
+            // Временная строка получает настоящий id: перечитанная страница сопоставит её по id
+            const int row = (result.provisionalId < -1) ? currentModel()->rowForId(result.provisionalId) : -1;
+            if (row >= 0)
+                currentModel()->setTaskId(row, result.task.id);
+            if (!m_scrollMode) {
+                m_refreshAfterFlush = true;
+            } else if (row < 0 && !m_trashMode) {
+                // Временной строки в ленте нет (её блок выгружали) — вставляем записанную; сброс
+                // ленты — только если её место среди выгруженных блоков
+                TaskPage written;
+                written.appendTask(result.task.id, result.task.description, result.task.details, result.task.creationDt,
+                                   result.task.completionDt, result.task.statusId, result.task.statusName);
+                if (m_scrollModel->insertSorted(written, 0) == TaskScrollModel::InsertResult::Outside)
+                    m_refreshAfterFlush = true;
+                updateScrollInfo();
+            }
+            break;
         }
-        orderBy += (m_sortOrder == Qt::DescendingOrder) ? " DESC" : " ASC";
+        case WriteResult::SoftDeleted:
+            m_flushMessage = tr("Перемещено в корзину: %1").arg(result.affected);
+            removeWrittenRows(result);
+            break;
+        case WriteResult::HardDeleted:
+            m_flushMessage = tr("Удалено полностью: %1").arg(result.affected);
+            removeWrittenRows(result);
+            break;
+        case WriteResult::StatusChanged:
+            m_flushMessage = tr("Статус изменён: %1").arg(result.affected);
+            // Точные completion_dt — перечитыванием страницы; лента остаётся на месте с оценкой
+            if (!m_scrollMode)
+                m_refreshAfterFlush = true;
+            break;
+        case WriteResult::Restored:
+            m_flushMessage = tr("Восстановлено: %1").arg(result.affected);
+            removeWrittenRows(result);
+            break;
+    }
+}
+
+void MainWindow::removeWrittenRows(const WriteResult &result)
+{
+    // Страница перечитывается после пачки (updatePage() уберёт строки и добавит снизу новые).
+    // Лента на месте: если все затронутые строки загружены, они просто убираются из блоков;
+    // иначе номера строк выгруженных блоков разошлись бы с базой — лента начинается заново.
+    if (m_scrollMode && m_scrollModel->removeTasks(result.ids) == result.affected) {
+        updateScrollInfo();
+        return;
     }
+    m_refreshAfterFlush = true;
+}
 
-    QString sql = QString("SELECT TASK.id, TASK.description, TASK.details, TASK.creation_dt, TASK.completion_dt, STATUS.name as status, TASK.is_deleted "
-                          "FROM TASK LEFT JOIN STATUS ON TASK.status_id = STATUS.id "
-                          "WHERE TASK.is_deleted = 0 "
-                          "ORDER BY %1 "
-                          "LIMIT %2 OFFSET %3;").arg(orderBy).arg(m_pageSize).arg(offset);
+void MainWindow::onWritesFlushed(int written, int failed)
+{
+    // Одно перечитывание страницы на пачку правок, а не на каждую
+    if (m_refreshAfterFlush) {
+        m_refreshAfterFlush = false;
+        m_reloadBlocksAfterFlush = false;
+        refreshView();
+    } else if (m_reloadBlocksAfterFlush) {
+        m_reloadBlocksAfterFlush = false;
+        if (m_scrollMode)
+            m_scrollModel->reloadBlocks();
+    }
+    const QString message = std::exchange(m_flushMessage, QString());
+    if (failed > 0) {
+        const QStringList errors = std::exchange(m_writeErrors, QStringList());
+        statusBar()->showMessage(tr("Сохранено правок: %1 из %2").arg(written - failed).arg(written));
+        QMessageBox::warning(this, tr("Ошибка БД"), errors.join(QLatin1Char('\n')));
+        return;
+    }
+    if (!message.isEmpty() && written == 1)
+        statusBar()->showMessage(message);
+    else
+        statusBar()->showMessage(written == 1 ? tr("Изменения сохранены") : tr("Сохранено правок: %1").arg(written));
+}
 
-    m_viewModel->setQuery(sql, m_db);
-    // set headers
-    m_viewModel->setHeaderData(1, Qt::Horizontal, tr("Задание"));
-    m_viewModel->setHeaderData(2, Qt::Horizontal, tr("Описание"));
-    m_viewModel->setHeaderData(3, Qt::Horizontal, tr("Дата создания"));
-    m_viewModel->setHeaderData(4, Qt::Horizontal, tr("Дата выполнения"));
-    m_viewModel->setHeaderData(5, Qt::Horizontal, tr("Статус"));
+void MainWindow::submitTaskUpdate(const TaskRecord &task)
+{
+    m_data->updateTask(task);
 
-    tableView->setModel(m_viewModel);
-    // Ensure technical columns remain hidden when the view model is reset
-    tableView->hideColumn(MainWindow::COL_ID);
-    tableView->hideColumn(MainWindow::COL_IS_DELETED);
-    // Reapply our stored status-color delegate to the status column
-    tableView->setItemDelegateForColumn(MainWindow::COL_STATUS, m_statusDelegate);
+    // Пока шёл диалог, страница могла смениться — строку ищем по id
+    const int row = currentModel()->rowForId(task.id);
+    if (row < 0)
+        return;
+    // Та же логика completion_dt, что в TaskRepository::updateTask; точное значение придёт
+    // в onTaskWritten() после фиксации
+    const int doneId = m_statuses.id(StatusRegistry::doneName());
+    const QVariant completionDt = (doneId != -1 && task.statusId == doneId)
+        ? QVariant(TimestampFormat::now()) : QVariant();
+    applyTaskUpdate(row, task.description, task.details, completionDt, task.statusId, task.statusName);
+}
+
+void MainWindow::submitDelete(bool hard)
+{
+    const QVector<int> ids = selectedTaskIds();
+    if (ids.isEmpty())
+        return;
+    if (hard)
+        m_data->hardDeleteTasks(ids);
+    else
+        m_data->softDeleteTasks(ids);
+    // Видимые строки набора остаются зачёркнутыми до фиксации пачки, затем страница перечитывается
+    for (int row : selectedModelRows())
+        currentModel()->markRemoved(row);
+    clearTaskSelection();
+}
+
+void MainWindow::submitRestore()
+{
+    const QVector<int> ids = selectedTaskIds();
+    if (ids.isEmpty())
+        return;
+    m_data->restoreTasks(ids);
+    // Восстановленные строки уходят из корзины — так же, как удалённые из списка
+    for (int row : selectedModelRows())
+        currentModel()->markRemoved(row);
+    clearTaskSelection();
+}
+
+void MainWindow::submitStatusChange(int statusId)
+{
+    const QVector<int> ids = selectedTaskIds();
+    if (ids.isEmpty())
+        return;
+    m_data->setTasksStatus(ids, statusId);
+
+    // Видимые строки меняются сразу; строки, уже стоящие в этом статусе, репозиторий не трогает
+    const int doneId = m_statuses.id(StatusRegistry::doneName());
+    const QVariant completionDt = (doneId != -1 && statusId == doneId) ? QVariant(TimestampFormat::now()) : QVariant();
+    const QString statusName = m_statuses.name(statusId);
+    // Только статус и дата: в строке может лежать лишь начало длинного "Описания"
+    TaskTableModel *model = currentModel();
+    bool changed = false;
+    for (int row : selectedModelRows()) {
+        if (model->statusId(row) != statusId) {
+            model->updateStatus(row, completionDt, statusId, statusName);
+            changed = true;
+        }
+    }
+    if (changed && updateMovesRow())
+        m_refreshAfterFlush = true;
+}
+
+QVector<int> MainWindow::selectedTaskIds() const
+{
+    QVector<int> ids(m_selectedIds.cbegin(), m_selectedIds.cend());
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+QVector<int> MainWindow::selectedModelRows() const
+{
+    QVector<int> rows;
+    if (m_selectedIds.isEmpty())
+        return rows;
+    const TaskTableModel *model = currentModel();
+    const int count = model->rowCount();
+    for (int row = 0; row < count; ++row) {
+        if (m_selectedIds.contains(model->taskId(row)))
+            rows.append(row);
+    }
+    return rows;
+}
+
+void MainWindow::connectSelectionModel()
+{
+    // setModel() создаёт новую модель выделения — подключаемся к ней заново
+    connect(tableView->selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &MainWindow::onSelectionChanged, Qt::UniqueConnection);
+}
+
+void MainWindow::onSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected)
+{
+    if (m_restoringSelection)
+        return;
+    // Незагруженные строки ленты (id -1) пропускаем
+    const TaskTableModel *model = currentModel();
+    for (const QItemSelectionRange &range : deselected) {
+        for (int row = range.top(); row <= range.bottom(); ++row)
+            m_selectedIds.remove(model->taskId(row));
+    }
+    for (const QItemSelectionRange &range : selected) {
+        for (int row = range.top(); row <= range.bottom(); ++row) {
+            const int id = model->taskId(row);
+            if (id >= 0)
+                m_selectedIds.insert(id);
+        }
+    }
+    updateSelectionInfo();
+}
+
+void MainWindow::restoreSelection()
+{
+    const QVector<int> rows = selectedModelRows();
+    if (!rows.isEmpty()) {
+        // Подряд идущие строки — одним диапазоном
+        const TaskTableModel *model = currentModel();
+        const int lastColumn = model->columnCount() - 1;
+        QItemSelection selection;
+        for (int i = 0; i < rows.size();) {
+            int j = i;
+            while (j + 1 < rows.size() && rows[j + 1] == rows[j] + 1)
+                ++j;
+            selection.select(model->index(rows[i], 0), model->index(rows[j], lastColumn));
+            i = j + 1;
+        }
+        m_restoringSelection = true;
+        tableView->selectionModel()->select(selection, QItemSelectionModel::Select | QItemSelectionModel::Rows);
+        m_restoringSelection = false;
+    }
+    updateSelectionInfo();
+}
+
+void MainWindow::clearTaskSelection()
+{
+    m_selectedIds.clear();
+    m_restoringSelection = true;
+    tableView->clearSelection();
+    m_restoringSelection = false;
+    updateSelectionInfo();
+}
+
+void MainWindow::updateSelectionInfo()
+{
+    const int count = int(m_selectedIds.size());
+    m_selectionLabel->setText(tr("Выделено: %1").arg(count));
+    m_selectionLabel->setVisible(count > 1);
+}
+
+void MainWindow::applyTaskUpdate(int row, const QString &description, const QString &details,
+                                 const QVariant &completionDt, int statusId, const QString &statusName)
+{
+    // Строка обновляется на месте сразу; если она может сменить позицию или выпасть из выборки,
+    // страница перечитывается один раз после фиксации пачки правок.
+    currentModel()->updateTask(row, description, details, completionDt, statusId, statusName);
+    if (updateMovesRow())
+        m_refreshAfterFlush = true;
+}
+
+bool MainWindow::updateMovesRow() const
+{
+    // Если изменённое поле участвует в текущей сортировке, строка может сменить позицию.
+    // В результатах поиска новый текст мог изменить релевантность или перестать совпадать.
+    // В ленте строка остаётся на месте до следующего сброса — иначе сбросилась бы прокрутка.
+    if (m_scrollMode)
+        return false;
+    // Под фильтром по дате выполнения строка могла выпасть из выборки (или попасть в неё)
+    if (!m_searchText.isEmpty() || m_dateFilterCombo->currentData().toInt() == TaskTableModel::COL_COMPLETION_DT)
+        return true;
+    switch (m_sortColumn) {
+        case TaskTableModel::COL_DESC:
+        case TaskTableModel::COL_DETAILS:
+        case TaskTableModel::COL_COMPLETION_DT:
+        case TaskTableModel::COL_STATUS:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void MainWindow::fitColumns(const TaskPage &page)
+{
+    TraceSpan span("ui.fitColumns");
+    // Оценка по ограниченной выборке строк, равномерно по странице: стоимость не зависит
+    // от размера страницы. Столбцы только расширяются — ширина стабильна между обновлениями.
     QHeaderView *header = tableView->horizontalHeader();
-    header->setSectionResizeMode(MainWindow::COL_DESC, QHeaderView::ResizeToContents);
-    header->setSectionResizeMode(MainWindow::COL_DETAILS, QHeaderView::Stretch);
-    header->setSectionResizeMode(MainWindow::COL_CREATION_DT, QHeaderView::ResizeToContents);
-    header->setSectionResizeMode(MainWindow::COL_COMPLETION_DT, QHeaderView::ResizeToContents);
-    header->setSectionResizeMode(MainWindow::COL_STATUS, QHeaderView::ResizeToContents);
-
-    int totalPages = qMax(1, (total + m_pageSize - 1) / m_pageSize);
-    if (m_currentPage >= totalPages) m_currentPage = totalPages - 1;
-    m_pageInfoLabel->setText(tr("Стр. %1 / %2 (%3)").arg(m_currentPage+1).arg(totalPages).arg(total));
-    m_prevPageButton->setEnabled(m_currentPage > 0);
-    m_nextPageButton->setEnabled((m_currentPage+1) < totalPages);
-}
\ No newline at end of file
+    const QFontMetrics fm(tableView->font());
+    const int rows = page.rowCount();
+    const int step = qMax(1, rows / ColumnSampleRows);
+
+    // Даты хранятся числом и выводятся в одном формате — ширину даёт образец
+    const int dateWidth = fm.horizontalAdvance(QStringLiteral("0000-00-00 00:00:00"));
+    auto sampleWidth = [&](int column) {
+        int width = 0;
+        for (int row = 0; row < rows; row += step) {
+            const QStringView text = page.textView(row, column);
+            width = qMax(width, fm.horizontalAdvance(QString::fromRawData(text.data(), text.size())));
+        }
+        return width;
+    };
+    // Статусов немного — меряем справочник, а не строки
+    int statusWidth = 0;
+    for (const StatusRegistry::Entry &entry : m_statuses.entries())
+        statusWidth = qMax(statusWidth, fm.horizontalAdvance(entry.name));
+
+    const QPair<int, int> wanted[] = {
+        { TaskTableModel::COL_DESC, qMin(sampleWidth(TaskTableModel::COL_DESC),
+                                         int(tableView->viewport()->width() * MaxDescColumnShare)) },
+        { TaskTableModel::COL_CREATION_DT, dateWidth },
+        { TaskTableModel::COL_COMPLETION_DT, dateWidth },
+        { TaskTableModel::COL_STATUS, statusWidth }
+    };
+
+    m_fittingColumns = true;
+    for (const QPair<int, int> &column : wanted) {
+        if (m_userSizedColumns & (1u << column.first))
+            continue;
+        const int width = qMax(column.second + ColumnPadding, header->sectionSizeHint(column.first));
+        if (width > header->sectionSize(column.first))
+            header->resizeSection(column.first, width);
+    }
+    m_fittingColumns = false;
+}
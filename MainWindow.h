@@ -1,38 +1,41 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "DatabaseWorker.h"
+
+#include <QItemSelection>
 #include <QMainWindow>
 #include <QObject>
-#include <QSqlDatabase>
+#include <QSet>
+#include <QStringList>
+#include <QVariant>
 
 // Forward declarations — ускоряют компиляцию.
 class QTableView;
-class QSqlRelationalTableModel;
 class QToolBar;
 class QAction;
-class QSqlQueryModel;
+class TaskTableModel;
+class TaskScrollModel;
+class QCheckBox;
+class QProgressDialog;
+class TaskDataService;
 class QPushButton;
 class QLabel;
 class QComboBox;
 class QWidget;
 class QStyledItemDelegate;
+class QLineEdit;
+class QDateEdit;
+class QTimer;
+class StatusColorDelegate;
+class TaskPage;
+class PerfOverlay;
 
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    // Именованные индексы столбцов таблицы
-    enum Column {
-        COL_ID = 0,
-        COL_DESC = 1,
-        COL_DETAILS = 2,
-        COL_CREATION_DT = 3,
-        COL_COMPLETION_DT = 4,
-        COL_STATUS = 5,
-        COL_IS_DELETED = 6
-    };
-
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
@@ -45,17 +48,76 @@ private slots:
     void onEditTask();
     void onTableDoubleClicked(const QModelIndex &index);
     void onHeaderClicked(int section);
+    void onSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected);
+    void clearTaskSelection();
+    void onSearchTextChanged();
+    void onDateFilterChanged();
+    // Корзина: список удалённых задач вместо живых (восстановить / удалить полностью)
+    void setTrashMode(bool enabled);
+    void onRestoreTasks();
+    void onEmptyTrash();
+    void onTrashPurged(int rows);
+    // Базу изменил другой процесс: перечитать только показанное
+    void onExternalChange();
+    void onImportTasks();
+    void onExportTasks();
+
+    // Ответы потока БД
+    void onDatabaseOpened(bool ok, const QString &error, const StatusRegistry &statuses);
+    void onPageReady(const PageResult &result);
+    void onBlockReady(const PageResult &result);
+    void onTaskWritten(const WriteResult &result);
+    void onWritesFlushed(int written, int failed);
+    void onImportFinished(const ImportResult &result);
+    void onExportFinished(const ExportResult &result);
+    void onBackupFinished(const BackupResult &result);
+    void onDetailsReady(int id, const QString &details, bool ok, const QString &error);
 
 private:
-    // Инициализация и подготовка БД
-    void initDB();
-    void refreshView();
+    // Перечитать текущую страницу (Reload) или начать с первой (First)
+    void refreshView(PageSeek seek = PageSeek::Reload);
+    void navigatePages(int delta);
+    // Переключение между страницами и лентой (бесконечная прокрутка, TaskScrollModel)
+    void setScrollMode(bool enabled);
+    void updateScrollWindow();
+    void updateScrollInfo();
+    // Модель, которая сейчас показана в таблице
+    TaskTableModel *currentModel() const;
+    void requestPage();
+    // Фильтры панели → поля запроса: корзина и дата (столбец и [с, по] в локальных сутках)
+    void applyFilters(PageRequest &request) const;
+    // Ширина столбцов по выборке строк страницы (только расширение)
+    void fitColumns(const TaskPage &page);
+    void applyTaskUpdate(int row, const QString &description, const QString &details,
+                         const QVariant &completionDt, int statusId, const QString &statusName);
+    // Диалог просмотра/редактирования строки. Если в странице лишь начало длинного "Описания",
+    // диалог открывается, когда поток БД вернёт полный текст (onDetailsReady())
+    void openTaskDialog(int row, const QString &title);
+    void showTaskDialog(int row, const QString &title, const QString &details);
+    // Правка уходит в журнал потока БД, а таблица показывает её сразу (до фиксации)
+    void submitTaskUpdate(const TaskRecord &task);
+    // Массовые операции над выделением (m_selectedIds — все страницы, не только видимая)
+    void submitDelete(bool hard);
+    void submitRestore();
+    // Задачи ушли из текущего списка (удаление, восстановление) — убрать их строки из представления
+    void removeWrittenRows(const WriteResult &result);
+    void submitStatusChange(int statusId);
+    QVector<int> selectedTaskIds() const;
+    QVector<int> selectedModelRows() const; // строки текущей модели из m_selectedIds
+    // Выделение переживает смену страницы: после загрузки строки с id из m_selectedIds выделяются снова
+    void connectSelectionModel();
+    void restoreSelection();
+    void updateSelectionInfo();
+    // Изменение строки может сдвинуть её при текущих сортировке/поиске/фильтре
+    bool updateMovesRow() const;
 
     // Виджеты и модель
     QTableView *tableView;
-    QSqlDatabase m_db;
-    QSqlRelationalTableModel *m_model;
-    QSqlQueryModel *m_viewModel;
+    TaskDataService *m_data;
+    TaskTableModel *m_viewModel;
+    TaskScrollModel *m_scrollModel;
+    bool m_scrollMode;
+    StatusRegistry m_statuses; // справочник статусов: AddTaskDialog и цвета делегата
 
     // Панель инструментов
     QToolBar *m_mainToolBar;
@@ -68,13 +130,62 @@ private:
     QPushButton *m_nextPageButton;
     QLabel *m_pageInfoLabel;
     QComboBox *m_pageSizeCombo;
+    QLabel *m_pageSizeLabel;
+    QCheckBox *m_scrollModeCheck;
+    QCheckBox *m_trashCheck;
+    bool m_trashMode;
+    QAction *m_emptyTrashAction;
     int m_pageSize;
     int m_currentPage;
+    int m_totalPages;
+    // Keyset anchors: (sort key, id) первой и последней строки видимой страницы
+    QVariant m_firstKey;
+    int m_firstId;
+    QVariant m_lastKey;
+    int m_lastId;
+    bool m_baseIsFirst; // якорей ещё нет (новая сортировка) — отсчёт от начала списка
+    int m_pendingSteps; // клики "вперёд/назад", ещё не подтверждённые ответом потока БД
+    // Журнал правок: после фиксации пачки страницу нужно перечитать (добавления, удаления,
+    // ошибки, сдвинутые строки); ошибки пачки показываются одним сообщением
+    bool m_refreshAfterFlush;
+    bool m_reloadBlocksAfterFlush; // лента: перечитать загруженные блоки на месте (ошибка правки)
+    QStringList m_writeErrors;
+    QString m_flushMessage; // итог массовой операции для строки состояния
+    int m_nextProvisionalId; // временный id следующей добавленной задачи (-2, -3, …) до её записи
+    // Задача, полное "Описание" которой загружается для диалога (-1 — нет), и заголовок диалога
+    int m_detailsTaskId;
+    QString m_detailsDialogTitle;
+
+    // Выделенные задачи по id — на всех страницах/блоках ленты
+    QSet<int> m_selectedIds;
+    bool m_restoringSelection; // выделение восстанавливается программно — m_selectedIds не трогаем
+    QLabel *m_selectionLabel;
 
-    QStyledItemDelegate *m_statusDelegate;
+    // Поиск: запрос уходит после паузы в наборе, устаревший прерывается в потоке БД
+    QLineEdit *m_searchEdit;
+    QTimer *m_searchTimer;
+    QString m_searchText;
+
+    // Фильтр по дате создания/выполнения: диапазон ищется по индексу даты (см. TaskRepository)
+    QComboBox *m_dateFilterCombo;
+    QDateEdit *m_dateFromEdit;
+    QDateEdit *m_dateToEdit;
+
+    StatusColorDelegate *m_statusDelegate;
+    QStyledItemDelegate *m_highlightDelegate;
+    QAction *m_importAction;
+    QProgressDialog *m_importProgress; // не модальный: окно остаётся отзывчивым во время импорта
+    QAction *m_exportAction;
+    QProgressDialog *m_exportProgress;
+    QAction *m_backupAction;
     QPushButton *m_addTaskButton;
 
-    int m_statusDoneId; // ID статуса "Сделано"
+    PerfOverlay *m_perfOverlay;
+    bool m_traceFromEnvironment; // TRACKER_TRACE=1: трассировка не выключается вместе с панелью
+
+    quint32 m_userSizedColumns; // биты столбцов, ширину которых задал пользователь
+    bool m_fittingColumns;
+
     int m_sortColumn;
     Qt::SortOrder m_sortOrder;
 };
@@ -0,0 +1,71 @@
+#include "PerfOverlay.h"
+#include "Trace.h"
+
+#include <QEvent>
+#include <QFontDatabase>
+#include <QTimer>
+
+namespace {
+// Период обновления панели
+constexpr int RefreshIntervalMs = 500;
+// Отступ от правого верхнего угла родителя
+constexpr int Margin = 8;
+}
+
+PerfOverlay::PerfOverlay(QWidget *parent)
+    : QLabel(parent)
+    , m_timer(new QTimer(this))
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setTextFormat(Qt::PlainText);
+    setStyleSheet(QStringLiteral("QLabel{background-color:rgba(0,0,0,170);color:#e0e0e0;padding:6px;border-radius:4px;}"));
+    m_timer->setInterval(RefreshIntervalMs);
+    connect(m_timer, &QTimer::timeout, this, &PerfOverlay::refresh);
+    parent->installEventFilter(this);
+    hide();
+}
+
+void PerfOverlay::showEvent(QShowEvent *event)
+{
+    QLabel::showEvent(event);
+    refresh();
+    m_timer->start();
+}
+
+void PerfOverlay::hideEvent(QHideEvent *event)
+{
+    m_timer->stop();
+    QLabel::hideEvent(event);
+}
+
+bool PerfOverlay::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == parent() && event->type() == QEvent::Resize)
+        reposition();
+    return QLabel::eventFilter(watched, event);
+}
+
+void PerfOverlay::refresh()
+{
+    const QVector<Trace::SpanStats> stats = Trace::stats();
+    QString text = QStringLiteral("%1 %2 %3 %4\n").arg(QStringLiteral("span"), -18)
+                       .arg(QStringLiteral("n"), 6).arg(QStringLiteral("p50 ms"), 9).arg(QStringLiteral("p99 ms"), 9);
+    for (const Trace::SpanStats &s : stats) {
+        text += QStringLiteral("%1 %2 %3 %4\n").arg(QString::fromLatin1(s.name), -18).arg(s.count, 6)
+                    .arg(double(s.p50Ns) / 1e6, 9, 'f', 2).arg(double(s.p99Ns) / 1e6, 9, 'f', 2);
+    }
+    if (stats.isEmpty())
+        text += Trace::isEnabled() ? tr("(нет данных)") : tr("(трассировка выключена)");
+    setText(text.trimmed());
+    adjustSize();
+    reposition();
+    raise();
+}
+
+void PerfOverlay::reposition()
+{
+    const QWidget *host = parentWidget();
+    if (host)
+        move(host->width() - width() - Margin, Margin);
+}
@@ -0,0 +1,29 @@
+#ifndef PERFOVERLAY_H
+#define PERFOVERLAY_H
+
+#include <QLabel>
+
+class QTimer;
+
+// Полупрозрачная панель поверх таблицы: p50/p99 по интервалам трассировки (Trace), что сейчас
+// лежат в кольцевом буфере. Обновляется по таймеру, пока видна; клики проходят сквозь неё.
+class PerfOverlay : public QLabel
+{
+    Q_OBJECT
+
+public:
+    explicit PerfOverlay(QWidget *parent);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    void refresh();
+    void reposition();
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+    QTimer *m_timer;
+};
+
+#endif // PERFOVERLAY_H
@@ -0,0 +1,96 @@
+#include "SearchHighlightDelegate.h"
+#include "TaskPage.h"
+
+#include <QApplication>
+#include <QFontMetrics>
+#include <QPainter>
+
+namespace {
+// Фон совпадения (на выделенной строке не рисуется — там остаётся цвет выделения)
+const QColor MatchBackground(255, 230, 120);
+}
+
+QString SearchHighlightDelegate::plainText(const QString &marked)
+{
+    QString text = marked;
+    text.remove(TaskPage::HighlightBegin);
+    text.remove(TaskPage::HighlightEnd);
+    return text;
+}
+
+void SearchHighlightDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    QStyleOptionViewItem opt(option);
+    initStyleOption(&opt, index);
+    if (!opt.text.contains(TaskPage::HighlightBegin)) {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+
+    // Фон, выделение и фокус рисует стиль, текст — мы, по сегментам
+    const QString marked = opt.text;
+    opt.text.clear();
+    const QWidget *widget = opt.widget;
+    QStyle *style = widget ? widget->style() : QApplication::style();
+    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+
+    const QRect textRect = style->subElementRect(QStyle::SE_ItemViewItemText, &opt, widget).adjusted(2, 0, -2, 0);
+    const bool selected = opt.state & QStyle::State_Selected;
+    const QPalette::ColorGroup group = (opt.state & QStyle::State_Enabled) ? QPalette::Normal : QPalette::Disabled;
+    const QColor textColor = opt.palette.color(group, selected ? QPalette::HighlightedText : QPalette::Text);
+
+    QFont matchFont = opt.font;
+    matchFont.setBold(true);
+
+    painter->save();
+    painter->setClipRect(textRect);
+    painter->setPen(textColor);
+
+    int x = textRect.left();
+    bool inMatch = false;
+    QString segment;
+    // Рисует накопленный сегмент; false — места в ячейке больше нет
+    auto flush = [&]() {
+        if (segment.isEmpty())
+            return true;
+        const QFont &font = inMatch ? matchFont : opt.font;
+        const QFontMetrics fm(font);
+        const int available = textRect.right() - x;
+        QString shown = segment;
+        if (fm.horizontalAdvance(shown) > available)
+            shown = fm.elidedText(shown, Qt::ElideRight, available);
+        const int width = fm.horizontalAdvance(shown);
+        const QRect segRect(x, textRect.top(), width, textRect.height());
+        if (inMatch && !selected)
+            painter->fillRect(segRect.adjusted(0, 2, 0, -2), MatchBackground);
+        painter->setFont(font);
+        painter->drawText(segRect, Qt::AlignVCenter | Qt::AlignLeft, shown);
+        x += width;
+        segment.clear();
+        return x < textRect.right();
+    };
+
+    for (QChar ch : marked) {
+        if (ch == TaskPage::HighlightBegin || ch == TaskPage::HighlightEnd) {
+            if (!flush())
+                break;
+            inMatch = (ch == TaskPage::HighlightBegin);
+            continue;
+        }
+        // Ячейка однострочная: переводы строк в "Описании" показываем пробелами
+        segment += (ch == QLatin1Char('\n') || ch == QLatin1Char('\r')) ? QChar(QLatin1Char(' ')) : ch;
+    }
+    flush();
+    painter->restore();
+}
+
+QSize SearchHighlightDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    // Символы разметки не должны влиять на ширину столбца (ResizeToContents)
+    QStyleOptionViewItem opt(option);
+    initStyleOption(&opt, index);
+    opt.text = plainText(opt.text);
+    const QWidget *widget = opt.widget;
+    QStyle *style = widget ? widget->style() : QApplication::style();
+    return style->sizeFromContents(QStyle::CT_ItemViewItem, &opt, QSize(), widget);
+}
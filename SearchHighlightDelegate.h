@@ -0,0 +1,23 @@
+#ifndef SEARCHHIGHLIGHTDELEGATE_H
+#define SEARCHHIGHLIGHTDELEGATE_H
+
+#include <QStyledItemDelegate>
+
+// Отрисовка текста с подсвеченными совпадениями поиска.
+// Модель отдаёт фрагменты, где совпадения обрамлены TaskPage::HighlightBegin/HighlightEnd
+// (их расставляют highlight()/snippet() FTS5); ячейки без разметки рисуются как обычно.
+class SearchHighlightDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    using QStyledItemDelegate::QStyledItemDelegate;
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+    // Текст без разметки совпадений
+    static QString plainText(const QString &marked);
+};
+
+#endif // SEARCHHIGHLIGHTDELEGATE_H
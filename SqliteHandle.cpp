@@ -0,0 +1,75 @@
+#include "SqliteHandle.h"
+
+#include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlQuery>
+#include <QVariant>
+
+#ifdef TRACKER_HAVE_SQLITE_API
+#include <sqlite3.h>
+
+namespace {
+// Заведомо недостижимый предел кучи — метка для проверки общей копии библиотеки
+constexpr sqlite3_int64 ProbeHeapLimit = (sqlite3_int64(1) << 40) + 4242;
+
+// Плагин QSQLITE и наш libsqlite3 — одна и та же копия библиотеки в процессе?
+// Совпадение версии (и даже sqlite_source_id()) этого не доказывает: у встроенной в плагин
+// копии могут быть другие параметры сборки и раскладка структур. Доказательство — общее
+// глобальное состояние: предел кучи, выставленный через наш API, должен прочитаться через
+// соединение плагина (PRAGMA soft_heap_limit). Предел глобальный для процесса, поэтому проверка
+// выполняется один раз под мьютексом; прежнее значение восстанавливается.
+bool sharesSqliteLibrary(const QSqlDatabase &db)
+{
+    static QMutex mutex;
+    static int shared = -1; // -1 — ещё не проверяли
+    QMutexLocker lock(&mutex);
+    if (shared >= 0)
+        return shared == 1;
+
+    QSqlQuery q(db);
+    if (!q.exec("SELECT sqlite_source_id()") || !q.next())
+        return false; // ошибка запроса — без вывода, проверим в следующий раз
+    const QString pluginSource = q.value(0).toString();
+    if (pluginSource != QLatin1String(sqlite3_sourceid())) {
+        qWarning() << "QSQLITE uses SQLite" << pluginSource << "but the app links" << sqlite3_sourceid()
+                   << "- SQLite C API features are disabled";
+        shared = 0;
+        return false;
+    }
+
+    const sqlite3_int64 previous = sqlite3_soft_heap_limit64(ProbeHeapLimit);
+    const bool seen = q.exec("PRAGMA soft_heap_limit") && q.next() && q.value(0).toLongLong() == ProbeHeapLimit;
+    sqlite3_soft_heap_limit64(previous);
+    if (!seen) {
+        qWarning() << "QSQLITE carries its own copy of SQLite" << sqlite3_libversion()
+                   << "- SQLite C API features are disabled (build Qt with -system-sqlite to enable them)";
+    }
+    shared = seen ? 1 : 0;
+    return seen;
+}
+}
+#endif
+
+sqlite3 *sqliteHandle(const QSqlDatabase &db)
+{
+#ifdef TRACKER_HAVE_SQLITE_API
+    if (!db.isOpen() || !db.driver())
+        return nullptr;
+
+    const QVariant v = db.driver()->handle();
+    if (!v.isValid() || qstrcmp(v.typeName(), "sqlite3*") != 0)
+        return nullptr;
+    sqlite3 *handle = *static_cast<sqlite3 *const *>(v.constData());
+    if (!handle)
+        return nullptr;
+
+    // Хэндл можно передавать только в ту же копию библиотеки, что внутри плагина
+    return sharesSqliteLibrary(db) ? handle : nullptr;
+#else
+    Q_UNUSED(db);
+    return nullptr;
+#endif
+}
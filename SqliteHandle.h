@@ -0,0 +1,16 @@
+#ifndef SQLITEHANDLE_H
+#define SQLITEHANDLE_H
+
+class QSqlDatabase;
+struct sqlite3;
+
+// "Сырой" sqlite3* соединения Qt — для возможностей, которых нет в Qt SQL API
+// (progress handler, update hook, backup API).
+// Доступен, только если приложение собрано с SQLite C API (TRACKER_HAVE_SQLITE_API) и плагин
+// QSQLITE работает с той же копией библиотеки в процессе (Qt, собранный с -system-sqlite):
+// плагин из стандартной поставки Qt несёт свою копию, и чужой хэндл передавать в неё нельзя,
+// даже если версии совпадают. Общая копия проверяется при первом вызове (см. SqliteHandle.cpp).
+// В остальных случаях возвращает nullptr — вызывающий код должен иметь запасной путь.
+sqlite3 *sqliteHandle(const QSqlDatabase &db);
+
+#endif // SQLITEHANDLE_H
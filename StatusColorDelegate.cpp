@@ -0,0 +1,75 @@
+#include "StatusColorDelegate.h"
+#include "StatusRegistry.h"
+#include "TaskTableModel.h"
+
+#include <QFontMetrics>
+#include <QPainter>
+
+namespace {
+// Поля текста внутри ячейки
+constexpr int TextMargin = 4;
+// Ширины меняются только при ресайзе столбца, статусов — единицы; предел — на случай
+// долгого перетаскивания границы столбца.
+constexpr int MaxCachedTexts = 256;
+}
+
+StatusColorDelegate::StatusColorDelegate(const StatusRegistry *statuses, QObject *parent)
+    : QStyledItemDelegate(parent)
+    , m_statuses(statuses)
+{
+}
+
+void StatusColorDelegate::invalidate()
+{
+    m_textCache.clear();
+}
+
+void StatusColorDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    if (index.column() != TaskTableModel::COL_STATUS) {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+
+    // If the row is selected, keep default selection rendering
+    if (option.state & QStyle::State_Selected) {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+
+    const int statusId = index.data(TaskTableModel::StatusIdRole).toInt();
+    const QRect textRect = option.rect.adjusted(TextMargin, 0, -TextMargin, 0);
+    // Строку статуса достаём из модели только при промахе кэша
+    const QStaticText &text = cachedText(statusId, index, option.font, textRect.width());
+
+    painter->save();
+    painter->fillRect(option.rect, QColor::fromRgba(m_statuses->color(statusId)));
+    painter->setFont(option.font);
+    painter->setPen(Qt::black);
+    const QSizeF size = text.size();
+    painter->drawStaticText(QPointF(textRect.left(), textRect.top() + (textRect.height() - size.height()) / 2), text);
+    painter->restore();
+}
+
+const QStaticText &StatusColorDelegate::cachedText(int statusId, const QModelIndex &index, const QFont &font, int width) const
+{
+    if (font != m_cacheFont) {
+        m_textCache.clear();
+        m_cacheFont = font;
+    }
+
+    const quint64 key = (quint64(quint32(statusId)) << 32) | quint32(qMax(0, width));
+    auto it = m_textCache.find(key);
+    if (it != m_textCache.end())
+        return *it;
+
+    if (m_textCache.size() >= MaxCachedTexts)
+        m_textCache.clear();
+
+    const QString name = index.data(Qt::DisplayRole).toString();
+    const QFontMetrics fm(font);
+    QStaticText text(fm.elidedText(name, Qt::ElideRight, width));
+    text.setTextFormat(Qt::PlainText);
+    text.prepare(QTransform(), font);
+    return *m_textCache.insert(key, text);
+}
@@ -0,0 +1,35 @@
+#ifndef STATUSCOLORDELEGATE_H
+#define STATUSCOLORDELEGATE_H
+
+#include <QFont>
+#include <QHash>
+#include <QStaticText>
+#include <QStyledItemDelegate>
+
+class StatusRegistry;
+
+// Делегат столбца "Статус": фон по цвету статуса из справочника (по id, без сравнения строк).
+// Обрезанный под ширину текст кэшируется как QStaticText по ключу (id статуса, ширина) —
+// раскладка и elide выполняются один раз, а не на каждую перерисовку ячейки.
+class StatusColorDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    StatusColorDelegate(const StatusRegistry *statuses, QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+    // Сбросить кэш (справочник статусов перечитан)
+    void invalidate();
+
+private:
+    const QStaticText &cachedText(int statusId, const QModelIndex &index, const QFont &font, int width) const;
+
+    const StatusRegistry *m_statuses;
+    // Кэш зависит от шрифта; при смене шрифта очищается целиком
+    mutable QFont m_cacheFont;
+    mutable QHash<quint64, QStaticText> m_textCache;
+};
+
+#endif // STATUSCOLORDELEGATE_H
@@ -0,0 +1,75 @@
+#include "StatusRegistry.h"
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace {
+// Цвета известных статусов (ARGB); остальные — белые
+quint32 colorForStatus(const QString &name)
+{
+    static const QHash<QString, quint32> colors = {
+        { QStringLiteral("Запланировано"), 0xFFC8C8C8 }, // gray
+        { QStringLiteral("В процессе"), 0xFF6496FF },    // blue
+        { QStringLiteral("Сделано"), 0xFFB4FFB4 },       // green
+        { QStringLiteral("Отменено"), 0xFFFFB4B4 },      // red
+        { QStringLiteral("Отложено"), 0xFFFFC878 }       // orange
+    };
+    return colors.value(name, 0xFFFFFFFF);
+}
+}
+
+StatusRegistry::StatusRegistry()
+    : m_data(std::make_shared<const Data>())
+{
+}
+
+bool StatusRegistry::load(const QSqlDatabase &db, StatusRegistry *registry, QString *error)
+{
+    auto data = std::make_shared<Data>();
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT id, name FROM STATUS ORDER BY id")) {
+        if (error)
+            *error = query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        Entry entry;
+        entry.id = query.value(0).toInt();
+        entry.name = query.value(1).toString();
+        entry.color = colorForStatus(entry.name);
+        data->byId.insert(entry.id, int(data->entries.size()));
+        data->byName.insert(entry.name, entry.id);
+        data->entries.append(entry);
+    }
+    registry->m_data = std::move(data);
+    return true;
+}
+
+QString StatusRegistry::name(int id) const
+{
+    const auto it = m_data->byId.constFind(id);
+    return it == m_data->byId.constEnd() ? QString() : m_data->entries[*it].name;
+}
+
+int StatusRegistry::id(const QString &name) const
+{
+    return m_data->byName.value(name, -1);
+}
+
+quint32 StatusRegistry::color(int id) const
+{
+    const auto it = m_data->byId.constFind(id);
+    return it == m_data->byId.constEnd() ? 0xFFFFFFFF : m_data->entries[*it].color;
+}
+
+QStringList StatusRegistry::names() const
+{
+    QStringList result;
+    result.reserve(m_data->entries.size());
+    for (const Entry &entry : m_data->entries)
+        result << entry.name;
+    return result;
+}
@@ -0,0 +1,57 @@
+#ifndef STATUSREGISTRY_H
+#define STATUSREGISTRY_H
+
+#include <QHash>
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <memory>
+
+class QSqlDatabase;
+
+// Справочник статусов в памяти: id ↔ имя и цвет для таблицы.
+// Загружается из STATUS один раз (потоком БД) и дальше передаётся по значению — копия стоит
+// одного счётчика ссылок, данные неизменяемы. GUI, диалоги и делегат работают с целыми id;
+// SQL-запросы за id по имени и сравнения строк при отрисовке больше не нужны.
+class StatusRegistry
+{
+public:
+    struct Entry {
+        int id = -1;
+        QString name;
+        quint32 color = 0xFFFFFFFF; // ARGB фона ячейки статуса; без QtGui, чтобы ядро не зависело от GUI
+    };
+
+    StatusRegistry();
+
+    // Читает STATUS (порядок по id). false — ошибка запроса, реестр остаётся пустым.
+    static bool load(const QSqlDatabase &db, StatusRegistry *registry, QString *error = nullptr);
+
+    bool isEmpty() const { return m_data->entries.isEmpty(); }
+    int size() const { return int(m_data->entries.size()); }
+    const QVector<Entry> &entries() const { return m_data->entries; }
+    bool contains(int id) const { return m_data->byId.contains(id); }
+
+    QString name(int id) const;      // пустая строка для неизвестного id
+    int id(const QString &name) const; // -1, если статус не найден
+    quint32 color(int id) const;     // белый для неизвестного id
+    QStringList names() const;
+
+    // Имена, на которые завязана логика приложения
+    static QString plannedName() { return QStringLiteral("Запланировано"); }
+    static QString doneName() { return QStringLiteral("Сделано"); }
+
+private:
+    struct Data {
+        QVector<Entry> entries;
+        QHash<int, int> byId;      // id → индекс в entries
+        QHash<QString, int> byName; // имя → id
+    };
+    std::shared_ptr<const Data> m_data;
+};
+
+Q_DECLARE_METATYPE(StatusRegistry)
+
+#endif // STATUSREGISTRY_H
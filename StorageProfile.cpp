@@ -0,0 +1,91 @@
+#include "StorageProfile.h"
+
+#include <QDebug>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace {
+// Сколько ждать чужую блокировку (другой процесс, например консольный режим), мс
+constexpr int BusyTimeoutMs = 5000;
+}
+
+StorageProfile StorageProfile::byName(const QString &name, bool *ok)
+{
+    StorageProfile profile;
+    const QString key = name.trimmed().toLower();
+    if (ok)
+        *ok = true;
+    if (key.isEmpty() || key == QLatin1String("balanced"))
+        return profile;
+
+    if (key == QLatin1String("durable")) {
+        profile.name = key;
+        profile.synchronous = QStringLiteral("FULL");
+        profile.cacheSizeKiB = 8 * 1024;
+        profile.mmapSize = 0;
+        profile.checkpointPages = 500;
+    } else if (key == QLatin1String("fast")) {
+        profile.name = key;
+        profile.synchronous = QStringLiteral("OFF");
+        profile.cacheSizeKiB = 64 * 1024;
+        profile.mmapSize = 1024ll * 1024 * 1024;
+        profile.checkpointPages = 4000;
+    } else if (ok) {
+        *ok = false;
+    }
+    return profile;
+}
+
+StorageProfile StorageProfile::fromEnvironment()
+{
+    const QString name = qEnvironmentVariable("TRACKER_DB_PROFILE");
+    bool ok = true;
+    const StorageProfile profile = byName(name, &ok);
+    if (!ok)
+        qWarning() << "Unknown TRACKER_DB_PROFILE" << name << "- using" << profile.name;
+    return profile;
+}
+
+bool StorageProfile::apply(const QSqlDatabase &db, ConnectionRole role, QString *error) const
+{
+    QSqlQuery q(db);
+    auto exec = [&q, error](const QString &sql) {
+        if (q.exec(sql))
+            return true;
+        if (error)
+            *error = q.lastError().text();
+        qWarning() << "Failed to apply" << sql << ":" << q.lastError().text();
+        return false;
+    };
+
+    if (!exec(QStringLiteral("PRAGMA busy_timeout = %1;").arg(BusyTimeoutMs)))
+        return false;
+
+    if (role != ConnectionRole::Reader) {
+        // journal_mode=WAL сохраняется в файле; на файловых системах без разделяемой памяти
+        // (сетевые диски) SQLite оставит прежний режим — работаем и так, но без параллельного чтения
+        if (!exec(QStringLiteral("PRAGMA journal_mode = WAL;")))
+            return false;
+        if (q.next() && q.value(0).toString().compare(QLatin1String("wal"), Qt::CaseInsensitive) != 0)
+            qWarning() << "WAL is not available, journal mode stays" << q.value(0).toString();
+    }
+
+    // synchronous и кэши — настройки соединения, а не файла: задаём каждому
+    if (!exec(QStringLiteral("PRAGMA synchronous = %1;").arg(synchronous))
+        || !exec(QStringLiteral("PRAGMA cache_size = %1;").arg(-cacheSizeKiB))
+        || !exec(QStringLiteral("PRAGMA mmap_size = %1;").arg(mmapSize)))
+        return false;
+
+    switch (role) {
+        case ConnectionRole::Writer:
+            // Фиксация не должна ждать checkpoint: его выполняет DatabaseWorker, когда нет записей
+            return exec(QStringLiteral("PRAGMA wal_autocheckpoint = 0;"));
+        case ConnectionRole::Reader:
+            return exec(QStringLiteral("PRAGMA query_only = 1;"));
+        case ConnectionRole::Standalone:
+            return exec(QStringLiteral("PRAGMA wal_autocheckpoint = %1;").arg(checkpointPages));
+    }
+    return true;
+}
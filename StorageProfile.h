@@ -0,0 +1,38 @@
+#ifndef STORAGEPROFILE_H
+#define STORAGEPROFILE_H
+
+#include <QString>
+
+class QSqlDatabase;
+
+// Роль соединения с tracker.db
+enum class ConnectionRole {
+    Standalone, // единственное соединение процесса (консольный режим): читает и пишет, автоматические checkpoint'ы SQLite
+    Writer,     // единственный писатель GUI: checkpoint'ы выполняет сам DatabaseWorker в простое
+    Reader      // читатель из пула: только чтение (PRAGMA query_only)
+};
+
+// Настройки хранения для всех соединений процесса. Файл всегда в режиме WAL: читатели
+// не блокируют писателя и друг друга, а фиксация транзакции — дозапись в журнал.
+//   balanced (по умолчанию) — synchronous=NORMAL: при сбое питания можно потерять последние
+//                             транзакции, но не целостность базы;
+//   durable — synchronous=FULL: каждая транзакция на диске к моменту commit;
+//   fast    — synchronous=OFF и крупные кэши: для массового импорта и бенчмарков.
+// Выбирается переменной окружения TRACKER_DB_PROFILE (или --profile в консольном режиме).
+struct StorageProfile {
+    QString name = QStringLiteral("balanced");
+    QString synchronous = QStringLiteral("NORMAL");
+    int cacheSizeKiB = 16 * 1024;          // PRAGMA cache_size = -N (на соединение)
+    qint64 mmapSize = 256ll * 1024 * 1024; // PRAGMA mmap_size; 0 — без отображения в память
+    int checkpointPages = 1000;            // wal_autocheckpoint консольного режима; писатель GUI делает checkpoint в простое
+
+    // Неизвестное имя — профиль по умолчанию (ok = false)
+    static StorageProfile byName(const QString &name, bool *ok = nullptr);
+    static StorageProfile fromEnvironment();
+
+    // Включает WAL (кроме читателей — режим уже записан в файл писателем) и применяет
+    // прагмы профиля к открытому соединению
+    bool apply(const QSqlDatabase &db, ConnectionRole role, QString *error = nullptr) const;
+};
+
+#endif // STORAGEPROFILE_H
@@ -0,0 +1,354 @@
+#include "TaskBackup.h"
+#include "SqliteHandle.h"
+#include "TaskRepository.h"
+#include "Trace.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QtEndian>
+
+#ifdef TRACKER_HAVE_SQLITE_API
+#include <sqlite3.h>
+#endif
+
+namespace {
+// Порция sqlite3_backup_step() (страниц по 4 КиБ — около 0,5 МиБ) и пауза между порциями, мс:
+// порция занимает диск на доли миллисекунды, остальные соединения между ними не ждут
+constexpr int BackupStepPages = 128;
+constexpr int BackupPauseMs = 2;
+// Сжатый формат: заголовок Magic, затем блоки "длина (4 байта, big-endian) + qCompress(кусок)",
+// блок нулевой длины — конец. qCompress хранит исходный размер куска и проверяет данные (zlib).
+const QByteArray Magic("TRKBAK1\n");
+constexpr qint64 ChunkBytes = 1024 * 1024;
+constexpr int CompressionLevel = 6;
+const QLatin1String FilePrefix("tracker-");
+const QLatin1String CompressedSuffix(".db.qz");
+const QLatin1String TimeFormat("yyyyMMdd-HHmmss");
+
+bool isCompressed(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) && file.read(Magic.size()) == Magic;
+}
+
+bool compressFile(const QString &source, const QString &target, const std::function<bool()> &isCancelled,
+                  BackupResult &result)
+{
+    QFile in(source);
+    QSaveFile out(target);
+    if (!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::WriteOnly)) {
+        result.error = in.isOpen() ? out.errorString() : in.errorString();
+        return false;
+    }
+    out.write(Magic);
+    while (!in.atEnd()) {
+        if (isCancelled()) {
+            result.cancelled = true;
+            out.cancelWriting();
+            return false;
+        }
+        const QByteArray block = qCompress(in.read(ChunkBytes), CompressionLevel);
+        uchar length[4];
+        qToBigEndian(quint32(block.size()), length);
+        out.write(reinterpret_cast<const char *>(length), 4);
+        out.write(block);
+    }
+    const uchar end[4] = { 0, 0, 0, 0 };
+    out.write(reinterpret_cast<const char *>(end), 4);
+    if (!out.commit()) {
+        result.error = out.errorString();
+        return false;
+    }
+    result.bytes = QFileInfo(target).size();
+    return true;
+}
+
+bool expandFile(const QString &source, const QString &target, QString *error)
+{
+    QFile in(source);
+    QSaveFile out(target);
+    if (!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::WriteOnly)) {
+        *error = in.isOpen() ? out.errorString() : in.errorString();
+        return false;
+    }
+    in.read(Magic.size());
+    while (true) {
+        const QByteArray header = in.read(4);
+        if (header.size() != 4) {
+            *error = QStringLiteral("копия обрезана");
+            return false;
+        }
+        const quint32 length = qFromBigEndian<quint32>(header.constData());
+        if (length == 0)
+            break;
+        const QByteArray block = qUncompress(in.read(length));
+        if (block.isEmpty()) {
+            *error = QStringLiteral("копия повреждена");
+            return false;
+        }
+        out.write(block);
+    }
+    if (!out.commit()) {
+        *error = out.errorString();
+        return false;
+    }
+    return true;
+}
+
+// quick_check и версия схемы копии — на отдельном соединении только для чтения
+bool verifyDatabase(const QString &path, int *version, QString *error)
+{
+    const QString connection = QStringLiteral("tracker-verify-%1").arg(quintptr(QThread::currentThreadId()));
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connection);
+        db.setDatabaseName(path);
+        db.setConnectOptions(QStringLiteral("QSQLITE_OPEN_READONLY"));
+        if (!db.open()) {
+            *error = db.lastError().text();
+        } else {
+            QSqlQuery q(db);
+            if (!q.exec("PRAGMA quick_check;") || !q.next())
+                *error = q.lastError().text();
+            else if (q.value(0).toString() != QLatin1String("ok"))
+                *error = QStringLiteral("проверка копии: %1").arg(q.value(0).toString());
+            else if (!q.exec("PRAGMA user_version;") || !q.next())
+                *error = q.lastError().text();
+            else {
+                *version = q.value(0).toInt();
+                ok = true;
+            }
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connection);
+    return ok;
+}
+}
+
+TaskBackup::TaskBackup(TaskRepository &repository)
+    : m_repository(repository)
+{
+}
+
+QString TaskBackup::defaultDirectory()
+{
+    return QFileInfo(TaskRepository::defaultDatabasePath()).absolutePath() + QStringLiteral("/backups");
+}
+
+QDateTime TaskBackup::lastBackupTime(const QString &dir)
+{
+    // Имена с временем в порядке сортировки: последнее по имени — самое новое
+    const QStringList names = QDir(dir).entryList({ QString(FilePrefix) + QLatin1Char('*') }, QDir::Files, QDir::Name | QDir::Reversed);
+    for (const QString &name : names) {
+        const QDateTime time = QDateTime::fromString(name.mid(FilePrefix.size(), 15), TimeFormat);
+        if (time.isValid())
+            return time;
+    }
+    return QDateTime();
+}
+
+bool TaskBackup::copyDatabase(const QString &path, BackupResult &result)
+{
+    QSqlDatabase db = m_repository.database();
+    QFile::remove(path);
+
+#ifdef TRACKER_HAVE_SQLITE_API
+    if (sqlite3 *source = sqliteHandle(db)) {
+        // Транзакция чтения на всё копирование: снимок не меняется, писатель WAL не ждёт
+        QSqlQuery pin(db);
+        if (!db.transaction() || !pin.exec("SELECT COUNT(*) FROM sqlite_master;")) {
+            result.error = db.lastError().text();
+            db.rollback();
+            return false;
+        }
+        pin.finish();
+
+        sqlite3 *target = nullptr;
+        int rc = sqlite3_open_v2(QFile::encodeName(path).constData(), &target,
+                                 SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
+        sqlite3_backup *backup = (rc == SQLITE_OK) ? sqlite3_backup_init(target, "main", source, "main") : nullptr;
+        if (!backup) {
+            result.error = QString::fromUtf8(target ? sqlite3_errmsg(target) : sqlite3_errstr(rc));
+        } else {
+            do {
+                rc = sqlite3_backup_step(backup, BackupStepPages);
+                const int total = sqlite3_backup_pagecount(backup);
+                result.pages = total - sqlite3_backup_remaining(backup);
+                if (m_progress)
+                    m_progress(result.pages, total);
+                if (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+                    if (isCancelled()) {
+                        result.cancelled = true;
+                        break;
+                    }
+                    QThread::msleep(BackupPauseMs);
+                }
+            } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+            sqlite3_backup_finish(backup);
+            if (!result.cancelled && rc != SQLITE_DONE)
+                result.error = QString::fromUtf8(sqlite3_errstr(rc));
+        }
+        sqlite3_close(target);
+        db.rollback();
+        if (result.cancelled || !result.error.isEmpty()) {
+            QFile::remove(path);
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    // Без C API: VACUUM INTO читает тот же согласованный снимок, но одним оператором (без
+    // прогресса и отмены). Соединению читателя на это время снимается query_only.
+    QSqlQuery q(db);
+    const bool queryOnly = q.exec("PRAGMA query_only;") && q.next() && q.value(0).toInt() != 0;
+    if (queryOnly)
+        q.exec("PRAGMA query_only = 0;");
+    q.prepare("VACUUM INTO :path;");
+    q.bindValue(":path", path);
+    const bool ok = q.exec();
+    if (!ok)
+        result.error = q.lastError().text();
+    if (queryOnly)
+        q.exec("PRAGMA query_only = 1;");
+    if (!ok) {
+        QFile::remove(path);
+        return false;
+    }
+    if (q.exec("PRAGMA page_count;") && q.next())
+        result.pages = q.value(0).toLongLong();
+    return true;
+}
+
+BackupResult TaskBackup::backupToFile(const QString &path, bool compress)
+{
+    TraceSpan span("db.backup");
+    BackupResult result;
+    // Копия снимается во временный файл рядом: под своим именем появляется только проверенная
+    const QString raw = path + QStringLiteral(".part");
+    if (!copyDatabase(raw, result))
+        return result;
+    span.setRows(result.pages);
+
+    int version = 0;
+    if (!verifyDatabase(raw, &version, &result.error)) {
+        QFile::remove(raw);
+        return result;
+    }
+    bool ok = false;
+    if (compress) {
+        ok = compressFile(raw, path, [this]() { return isCancelled(); }, result);
+        QFile::remove(raw);
+    } else {
+        QFile::remove(path);
+        ok = QFile::rename(raw, path);
+        if (ok)
+            result.bytes = QFileInfo(path).size();
+        else
+            result.error = QStringLiteral("не удалось переименовать %1").arg(raw);
+    }
+    if (!ok)
+        return result;
+    result.path = path;
+    result.ok = true;
+    return result;
+}
+
+BackupResult TaskBackup::backupToDirectory(const QString &dir, int keep)
+{
+    QDir target(dir);
+    if (!target.mkpath(QStringLiteral("."))) {
+        BackupResult result;
+        result.error = QStringLiteral("не удалось создать каталог %1").arg(dir);
+        return result;
+    }
+    const QString name = QString(FilePrefix) + QDateTime::currentDateTime().toString(TimeFormat) + CompressedSuffix;
+    BackupResult result = backupToFile(target.filePath(name), true);
+    if (!result.ok)
+        return result;
+
+    // Ротация: только наши сжатые копии, самые новые — первые по имени в обратном порядке
+    const QStringList names = target.entryList({ QString(FilePrefix) + QLatin1Char('*') + CompressedSuffix }, QDir::Files,
+                                               QDir::Name | QDir::Reversed);
+    for (int i = qMax(keep, 1); i < names.size(); ++i) {
+        if (!target.remove(names.at(i)))
+            qWarning() << "Failed to remove old backup" << names.at(i);
+    }
+    return result;
+}
+
+BackupResult TaskBackup::restore(const QString &backupPath, const QString &databasePath)
+{
+    BackupResult result;
+    if (!QFileInfo::exists(backupPath)) {
+        result.error = QStringLiteral("нет файла %1").arg(backupPath);
+        return result;
+    }
+    const QString staged = databasePath + QStringLiteral(".restore");
+    QFile::remove(staged);
+    if (isCompressed(backupPath)) {
+        if (!expandFile(backupPath, staged, &result.error))
+            return result;
+    } else if (!QFile::copy(backupPath, staged)) {
+        result.error = QStringLiteral("не удалось скопировать %1").arg(backupPath);
+        return result;
+    }
+
+    int version = 0;
+    if (!verifyDatabase(staged, &version, &result.error)) {
+        QFile::remove(staged);
+        return result;
+    }
+    // Более старую схему догонят миграции при открытии; более новую эта версия не поймёт
+    if (version > TaskRepository::SchemaVersion) {
+        result.error = QStringLiteral("копия от более новой версии приложения (схема %1)").arg(version);
+        QFile::remove(staged);
+        return result;
+    }
+
+    if (QFileInfo::exists(databasePath)) {
+        // Выход из WAL требует монопольного доступа: если база открыта (приложение, консоль),
+        // режим не сменится. Заодно WAL переносится в основной файл и удаляется.
+        const QString connection = QStringLiteral("tracker-restore");
+        QString mode;
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connection);
+            db.setDatabaseName(databasePath);
+            if (db.open()) {
+                QSqlQuery q(db);
+                if (q.exec("PRAGMA journal_mode = DELETE;") && q.next())
+                    mode = q.value(0).toString();
+            }
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(connection);
+        if (mode.compare(QLatin1String("delete"), Qt::CaseInsensitive) != 0) {
+            result.error = QStringLiteral("база открыта другим процессом — закройте приложение");
+            QFile::remove(staged);
+            return result;
+        }
+        const QString previous = databasePath + QStringLiteral(".before-restore");
+        QFile::remove(previous);
+        if (!QFile::rename(databasePath, previous)) {
+            result.error = QStringLiteral("не удалось переименовать %1").arg(databasePath);
+            QFile::remove(staged);
+            return result;
+        }
+    }
+    if (!QFile::rename(staged, databasePath)) {
+        result.error = QStringLiteral("не удалось переименовать %1").arg(staged);
+        return result;
+    }
+    result.path = databasePath;
+    result.bytes = QFileInfo(databasePath).size();
+    result.ok = true;
+    return result;
+}
@@ -0,0 +1,72 @@
+#ifndef TASKBACKUP_H
+#define TASKBACKUP_H
+
+#include <QDateTime>
+#include <QMetaType>
+#include <QString>
+
+#include <functional>
+
+class TaskRepository;
+
+// Итог резервного копирования или восстановления
+struct BackupResult {
+    QString path;       // созданная копия / восстановленная база
+    qint64 bytes = 0;   // размер файла копии
+    qint64 pages = 0;   // страниц базы скопировано
+    bool ok = false;
+    bool skipped = false;   // плановая копия не нужна: последняя ещё свежая
+    bool cancelled = false; // отменено; недописанные файлы удалены
+    QString error;
+};
+
+// Резервные копии открытой базы без остановки приложения.
+//
+// С SQLite C API (см. SqliteHandle) копия снимается sqlite3_backup_step() порциями по
+// BackupStepPages страниц с паузой между ними. На всё время копирования соединение держит
+// одну транзакцию чтения: в режиме WAL она не мешает писателю, а копия получается согласованным
+// снимком и не начинается заново от чужих фиксаций (цена — WAL не укорачивается checkpoint'ом,
+// пока копия не закончится). Без C API — VACUUM INTO: тот же снимок, но одним оператором.
+//
+// Затем копия проверяется (PRAGMA quick_check на отдельном соединении) и, если нужно, сжимается
+// потоково кусками qCompress (формат — см. TaskBackup.cpp): память не зависит от размера базы.
+// Файл появляется под своим именем, только когда всё готово.
+//
+// Вызывается в потоке соединения репозитория (DatabaseWorker) вне транзакции.
+class TaskBackup
+{
+public:
+    explicit TaskBackup(TaskRepository &repository);
+
+    // %AppData%/SelfImprovementApp/backups
+    static QString defaultDirectory();
+    // Время последней копии в каталоге (по имени файла); невалидное — копий нет
+    static QDateTime lastBackupTime(const QString &dir);
+
+    // Вызывается после каждой порции: скопировано страниц, всего страниц
+    void setProgressCallback(std::function<void(qint64, qint64)> callback) { m_progress = std::move(callback); }
+    // Проверяется между порциями; true — прервать и удалить недописанное
+    void setCancelCheck(std::function<bool()> isCancelled) { m_isCancelled = std::move(isCancelled); }
+
+    // Копия в файл; compress — сжатый формат (.db.qz), иначе обычный файл SQLite
+    BackupResult backupToFile(const QString &path, bool compress);
+    // Плановая копия в каталог: tracker-ГГГГММДД-ччммсс.db.qz, старше keep последних — удаляются
+    BackupResult backupToDirectory(const QString &dir, int keep);
+
+    // Восстановление из копии (сжатой или обычной) на место databasePath. База не должна быть
+    // открыта: копия сначала распаковывается и проверяется рядом, прежняя база сохраняется
+    // как <databasePath>.before-restore и заменяется только после успешной проверки.
+    static BackupResult restore(const QString &backupPath, const QString &databasePath);
+
+private:
+    bool copyDatabase(const QString &path, BackupResult &result);
+    bool isCancelled() const { return m_isCancelled && m_isCancelled(); }
+
+    TaskRepository &m_repository;
+    std::function<void(qint64, qint64)> m_progress;
+    std::function<bool()> m_isCancelled;
+};
+
+Q_DECLARE_METATYPE(BackupResult)
+
+#endif // TASKBACKUP_H
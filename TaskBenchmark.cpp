@@ -0,0 +1,470 @@
+#include "TaskBenchmark.h"
+#include "StatusColorDelegate.h"
+#include "TaskDataGenerator.h"
+#include "TaskPage.h"
+#include "TaskScrollModel.h"
+#include "TaskTableModel.h"
+#include "TaskTableView.h"
+#include "TimestampFormat.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFontMetrics>
+#include <QHeaderView>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QPixmap>
+#include <QSaveFile>
+#include <QSqlQuery>
+#include <QSysInfo>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+// Соединения бенчмарка (основное и для замеров открытия)
+const char *const ConnectionName = "tracker_bench";
+const char *const OpenConnectionName = "tracker_bench_open";
+// Размер окна таблицы при замере отрисовки
+constexpr int RenderWidth = 1280;
+constexpr int RenderHeight = 800;
+
+struct SortCase {
+    int column;
+    const char *name;
+};
+const SortCase SortCases[] = {
+    { -1, "default" },
+    { TaskTableModel::COL_DESC, "description" },
+    { TaskTableModel::COL_DETAILS, "details" },
+    { TaskTableModel::COL_CREATION_DT, "created" },
+    { TaskTableModel::COL_COMPLETION_DT, "completed" },
+    { TaskTableModel::COL_STATUS, "status" }
+};
+
+bool removeDatabaseFiles(const QString &path)
+{
+    bool ok = true;
+    for (const QString &suffix : { QString(), QStringLiteral("-wal"), QStringLiteral("-shm") }) {
+        if (QFile::exists(path + suffix))
+            ok = QFile::remove(path + suffix) && ok;
+    }
+    return ok;
+}
+
+double toMs(qint64 ns)
+{
+    return double(ns) / 1e6;
+}
+
+// Делегат статуса в том виде, что был до кэширования текста: QFontMetrics и elide на каждую
+// ячейку каждого кадра. Нужен только замерам *_legacy — для сравнения путей в одной сборке.
+class LegacyStatusDelegate : public QStyledItemDelegate
+{
+public:
+    explicit LegacyStatusDelegate(const StatusRegistry *statuses)
+        : m_statuses(statuses)
+    {
+    }
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override
+    {
+        if (index.column() != TaskTableModel::COL_STATUS || (option.state & QStyle::State_Selected)) {
+            QStyledItemDelegate::paint(painter, option, index);
+            return;
+        }
+        const int statusId = index.data(TaskTableModel::StatusIdRole).toInt();
+        const QColor color = QColor::fromRgba(m_statuses->color(statusId));
+        const QString status = index.data(Qt::DisplayRole).toString();
+
+        painter->save();
+        painter->fillRect(option.rect, color);
+        painter->setFont(option.font);
+        QFontMetrics fm(option.font);
+        const QString elided = fm.elidedText(status, Qt::ElideRight, option.rect.width() - 8);
+        painter->setPen(Qt::black);
+        painter->drawText(option.rect.adjusted(4, 0, -4, 0), Qt::AlignVCenter | Qt::AlignLeft, elided);
+        painter->restore();
+    }
+
+private:
+    const StatusRegistry *m_statuses;
+};
+}
+
+TaskBenchmark::TaskBenchmark(const Options &options, QTextStream &log)
+    : m_options(options)
+    , m_log(log)
+    , m_repository(QString::fromLatin1(ConnectionName))
+{
+    if (m_options.dbPath.isEmpty()) {
+        m_options.dbPath = QDir::temp().filePath(QStringLiteral("tracker-bench-%1-%2.db")
+                                                     .arg(m_options.tasks).arg(m_options.seed));
+    }
+}
+
+int TaskBenchmark::run()
+{
+    const bool ok = prepareDatabase()
+        && benchOpen()
+        && benchPages()
+        && benchModel()
+        && benchWrites()
+        && writeReport();
+    m_repository.close();
+    if (!ok) {
+        m_log << "error: " << m_error << Qt::endl;
+        return 1;
+    }
+    return 0;
+}
+
+bool TaskBenchmark::fail(const QString &message)
+{
+    m_error = message;
+    return false;
+}
+
+template <typename Body>
+bool TaskBenchmark::measure(const QString &name, int iterations, Body &&body)
+{
+    // Повторный вызов с тем же именем дописывает итерации в тот же замер
+    auto it = std::find_if(m_results.begin(), m_results.end(), [&](const Result &r) { return r.name == name; });
+    if (it == m_results.end()) {
+        m_results.append(Result{ name, {} });
+        it = m_results.end() - 1;
+    }
+    QElapsedTimer timer;
+    for (int i = 0; i < iterations; ++i) {
+        timer.start();
+        const bool ok = body(i);
+        const qint64 ns = timer.nsecsElapsed();
+        if (!ok)
+            return false;
+        it->ns.append(ns);
+    }
+    return true;
+}
+
+bool TaskBenchmark::prepareDatabase()
+{
+    // База с тем же числом задач и seed детерминирована — её можно переиспользовать между запусками
+    if (m_options.regenerate && !removeDatabaseFiles(m_options.dbPath))
+        return fail(QStringLiteral("не удалось удалить %1").arg(m_options.dbPath));
+    if (!m_repository.open(m_options.dbPath, ConnectionRole::Standalone, m_options.profile) || !m_repository.initSchema())
+        return fail(m_repository.lastError());
+
+    const TaskCounts counts = m_repository.counts();
+    const qint64 existing = qint64(counts.live) + counts.deleted;
+    if (existing != 0 && existing != m_options.tasks) {
+        m_log << "Existing database has " << existing << " tasks, regenerating" << Qt::endl;
+        m_repository.close();
+        if (!removeDatabaseFiles(m_options.dbPath))
+            return fail(QStringLiteral("не удалось удалить %1").arg(m_options.dbPath));
+        if (!m_repository.open(m_options.dbPath, ConnectionRole::Standalone, m_options.profile) || !m_repository.initSchema())
+            return fail(m_repository.lastError());
+    }
+    if (existing != m_options.tasks) {
+        m_log << "Generating " << m_options.tasks << " tasks (seed " << m_options.seed << ") into "
+              << QDir::toNativeSeparators(m_options.dbPath) << Qt::endl;
+        QElapsedTimer timer;
+        timer.start();
+        TaskDataGenerator generator(m_options.seed);
+        QString error;
+        const bool generated = generator.fill(m_repository, m_options.tasks, &error, [this](qint64 rows) {
+            if (rows % 100000 == 0)
+                m_log << "  " << rows << " / " << m_options.tasks << Qt::endl;
+        });
+        if (!generated)
+            return fail(error);
+        m_log << "Generated in " << timer.elapsed() << " ms" << Qt::endl;
+    }
+    // Замеры начинаются с пустого WAL
+    m_repository.checkpoint(true);
+
+    QSqlQuery q(m_repository.database());
+    if (q.exec(QStringLiteral("SELECT sqlite_version()")) && q.next())
+        m_sqliteVersion = q.value(0).toString();
+    return true;
+}
+
+bool TaskBenchmark::benchOpen()
+{
+    m_repository.close();
+
+    // Открытие готовой базы: одно чтение user_version и справочник статусов
+    for (int i = 0; i < m_options.repeat; ++i) {
+        TaskRepository repository(QString::fromLatin1(OpenConnectionName));
+        const bool ok = measure(QStringLiteral("open_init_schema"), 1, [&](int) {
+            return repository.open(m_options.dbPath, ConnectionRole::Writer, m_options.profile)
+                && repository.initSchema();
+        });
+        if (!ok)
+            return fail(repository.lastError());
+        repository.close();
+    }
+
+    // Новая база: все миграции по порядку
+    const QString emptyPath = QDir::temp().filePath(QStringLiteral("tracker-bench-empty.db"));
+    for (int i = 0; i < m_options.repeat; ++i) {
+        removeDatabaseFiles(emptyPath);
+        TaskRepository repository(QString::fromLatin1(OpenConnectionName));
+        const bool ok = measure(QStringLiteral("init_schema_empty"), 1, [&](int) {
+            return repository.open(emptyPath, ConnectionRole::Writer, m_options.profile)
+                && repository.initSchema();
+        });
+        if (!ok)
+            return fail(repository.lastError());
+        repository.close();
+    }
+    removeDatabaseFiles(emptyPath);
+
+    if (!m_repository.open(m_options.dbPath, ConnectionRole::Standalone, m_options.profile) || !m_repository.initSchema())
+        return fail(m_repository.lastError());
+    return true;
+}
+
+bool TaskBenchmark::benchPages()
+{
+    const int pageSize = qMax(1, m_options.pageSize);
+    const int live = m_repository.countLive();
+    const int lastPage = qMax(0, (live - 1) / pageSize);
+    const struct { int page; const char *name; } positions[] = {
+        { 0, "first" }, { lastPage / 2, "middle" }, { lastPage, "last" }
+    };
+
+    for (const SortCase &sort : SortCases) {
+        for (const auto &position : positions) {
+            PageRequest request;
+            request.sortColumn = sort.column;
+            request.sortOrder = Qt::AscendingOrder;
+            request.pageSize = pageSize;
+            request.page = position.page;
+            if (position.page > 0) {
+                // Якорь — последняя строка предыдущей страницы (её читаем без замера через OFFSET),
+                // дальше — тот же переход "вперёд", что делает MainWindow
+                PageRequest previous = request;
+                previous.page = previous.steps = position.page - 1;
+                const PageResult before = m_repository.fetchPage(previous);
+                if (!before.ok)
+                    return fail(before.error);
+                const int rows = before.page->rowCount();
+                if (rows > 0) {
+                    request.seek = PageSeek::Forward;
+                    request.steps = 1;
+                    request.lastId = before.page->taskId(rows - 1);
+                    request.lastKey = TaskRepository::sortKeyValue(*before.page, rows - 1, sort.column);
+                }
+            }
+            const QString name = QStringLiteral("page_%1_%2").arg(QLatin1String(sort.name), QLatin1String(position.name));
+            const bool ok = measure(name, m_options.repeat, [&](int) {
+                const PageResult result = m_repository.fetchPage(request);
+                if (!result.ok)
+                    m_error = result.error;
+                return result.ok;
+            });
+            if (!ok)
+                return false;
+        }
+    }
+    return true;
+}
+
+bool TaskBenchmark::benchModel()
+{
+    const StatusRegistry statuses = m_repository.statuses();
+    TaskTableModel model;
+
+    // Сборка модели: страница GUI и блок ленты; чтение всех ячеек — как при первой отрисовке
+    for (int size : { qMax(1, m_options.pageSize), int(TaskScrollModel::BlockSize) }) {
+        PageRequest request;
+        request.pageSize = size;
+        const PageResult result = m_repository.fetchPage(request);
+        if (!result.ok)
+            return fail(result.error);
+        const bool ok = measure(QStringLiteral("model_set_page_%1").arg(size), m_options.repeat, [&](int) {
+            model.setPage(result.page);
+            qint64 cells = 0;
+            for (int row = 0; row < model.rowCount(); ++row) {
+                for (int column = 0; column < TaskTableModel::COLUMN_COUNT; ++column)
+                    cells += model.data(model.index(row, column)).isValid() ? 1 : 0;
+            }
+            return cells >= 0;
+        });
+        if (!ok)
+            return false;
+    }
+
+    // Отрисовка (платформа offscreen). Две страницы: render_page — перерисовка той же страницы,
+    // render_new_page — смена страницы с перерисовкой, где ResizeToContents меряет все строки.
+    // Варианты *_legacy воспроизводят прежний путь (ResizeToContents по столбцам и строкам,
+    // перенос слов, elide статуса на каждый кадр) — кадры до и после сравниваются в одном отчёте.
+    PageRequest request;
+    request.pageSize = qMax(1, m_options.pageSize);
+    const PageResult first = m_repository.fetchPage(request);
+    if (!first.ok)
+        return fail(first.error);
+    if (first.page->rowCount() > 0) {
+        request.page = 1;
+        request.seek = PageSeek::Forward;
+        request.steps = 1;
+        request.lastId = first.page->taskId(first.page->rowCount() - 1);
+        request.lastKey = TaskRepository::sortKeyValue(*first.page, first.page->rowCount() - 1, request.sortColumn);
+    }
+    const PageResult second = m_repository.fetchPage(request);
+    if (!second.ok)
+        return fail(second.error);
+
+    for (const bool legacy : { false, true }) {
+        const QString suffix = legacy ? QStringLiteral("_legacy") : QString();
+        TaskTableModel viewModel;
+        viewModel.setPage(first.page);
+        TaskTableView view;
+        StatusColorDelegate statusDelegate(&statuses);
+        LegacyStatusDelegate legacyDelegate(&statuses);
+        view.setModel(&viewModel);
+        view.hideColumn(TaskTableModel::COL_ID);
+        view.hideColumn(TaskTableModel::COL_IS_DELETED);
+        QHeaderView *header = view.horizontalHeader();
+        header->setStretchLastSection(true);
+        if (legacy) {
+            view.setItemDelegateForColumn(TaskTableModel::COL_STATUS, &legacyDelegate);
+            for (int column : { int(TaskTableModel::COL_DESC), int(TaskTableModel::COL_CREATION_DT),
+                                int(TaskTableModel::COL_COMPLETION_DT), int(TaskTableModel::COL_STATUS) })
+                header->setSectionResizeMode(column, QHeaderView::ResizeToContents);
+            header->setSectionResizeMode(TaskTableModel::COL_DETAILS, QHeaderView::Stretch);
+            view.verticalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+        } else {
+            // Как в MainWindow: фиксированная высота строк, без переноса
+            view.setItemDelegateForColumn(TaskTableModel::COL_STATUS, &statusDelegate);
+            header->setSectionResizeMode(QHeaderView::Interactive);
+            header->setSectionResizeMode(TaskTableModel::COL_DETAILS, QHeaderView::Stretch);
+            QHeaderView *rows = view.verticalHeader();
+            rows->setSectionResizeMode(QHeaderView::Fixed);
+            rows->setDefaultSectionSize(view.fontMetrics().height() + 10);
+            view.setWordWrap(false);
+        }
+        view.resize(RenderWidth, RenderHeight);
+        view.show();
+        QCoreApplication::processEvents();
+
+        bool ok = measure(QStringLiteral("render_page") + suffix, m_options.repeat, [&](int) {
+            return !view.grab().isNull();
+        });
+        if (!ok)
+            return false;
+        ok = measure(QStringLiteral("render_new_page") + suffix, m_options.repeat, [&](int iteration) {
+            viewModel.setPage((iteration % 2) ? first.page : second.page);
+            return !view.grab().isNull();
+        });
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+bool TaskBenchmark::benchWrites()
+{
+    // Записи по одной, в autocommit — как их выполняет писатель GUI. Вставленные задачи
+    // в конце удаляются, так что база остаётся пригодной для следующего запуска.
+    const int ops = qMax(1, m_options.writeOps);
+    const int plannedId = m_repository.statusIdByName(StatusRegistry::plannedName());
+    const int doneId = m_repository.doneStatusId();
+    QVector<int> ids;
+    ids.reserve(ops);
+
+    auto check = [this](bool ok) {
+        if (!ok)
+            m_error = m_repository.lastError();
+        return ok;
+    };
+    return measure(QStringLiteral("insert"), ops, [&](int i) {
+            TaskRecord task;
+            task.description = QStringLiteral("bench task %1").arg(i);
+            task.details = QStringLiteral("inserted by SelfImprovementBench");
+            task.statusId = plannedId;
+            if (!check(m_repository.insertTask(task)))
+                return false;
+            ids.append(task.id);
+            return true;
+        })
+        && measure(QStringLiteral("update"), ops, [&](int i) {
+            TaskRecord task;
+            task.id = ids.at(i);
+            task.description = QStringLiteral("bench task %1 (edited)").arg(i);
+            task.details = QStringLiteral("updated by SelfImprovementBench");
+            task.statusId = doneId;
+            return check(m_repository.updateTask(task));
+        })
+        && measure(QStringLiteral("set_status"), ops, [&](int i) {
+            return check(m_repository.setTaskStatus(ids.at(i), plannedId));
+        })
+        && measure(QStringLiteral("soft_delete"), ops, [&](int i) {
+            return check(m_repository.softDeleteTask(ids.at(i)));
+        })
+        && measure(QStringLiteral("hard_delete"), ops, [&](int i) {
+            return check(m_repository.hardDeleteTask(ids.at(i)));
+        })
+        && check(m_repository.checkpoint(true));
+}
+
+bool TaskBenchmark::writeReport()
+{
+    QJsonArray results;
+    for (const Result &result : m_results) {
+        QVector<qint64> sorted = result.ns;
+        std::sort(sorted.begin(), sorted.end());
+        const int n = int(sorted.size());
+        if (n == 0)
+            continue;
+        qint64 sum = 0;
+        for (qint64 ns : sorted)
+            sum += ns;
+        const int p95 = qBound(0, (n * 95 + 99) / 100 - 1, n - 1);
+
+        QJsonObject entry;
+        entry.insert(QStringLiteral("name"), result.name);
+        entry.insert(QStringLiteral("iterations"), n);
+        entry.insert(QStringLiteral("min_ms"), toMs(sorted.first()));
+        entry.insert(QStringLiteral("median_ms"), toMs(sorted.at(n / 2)));
+        entry.insert(QStringLiteral("p95_ms"), toMs(sorted.at(p95)));
+        entry.insert(QStringLiteral("mean_ms"), toMs(sum / n));
+        entry.insert(QStringLiteral("max_ms"), toMs(sorted.last()));
+        results.append(entry);
+
+        m_log << QStringLiteral("%1 median %2 ms, p95 %3 ms")
+                     .arg(result.name, -28).arg(toMs(sorted.at(n / 2)), 0, 'f', 3).arg(toMs(sorted.at(p95)), 0, 'f', 3)
+              << Qt::endl;
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("benchmark"), QStringLiteral("SelfImprovementBench"));
+    root.insert(QStringLiteral("format"), 1);
+    root.insert(QStringLiteral("started"), TimestampFormat::toIso(TimestampFormat::now()));
+    root.insert(QStringLiteral("tasks"), m_options.tasks);
+    root.insert(QStringLiteral("seed"), QString::number(m_options.seed));
+    root.insert(QStringLiteral("page_size"), m_options.pageSize);
+    root.insert(QStringLiteral("repeat"), m_options.repeat);
+    root.insert(QStringLiteral("write_ops"), m_options.writeOps);
+    root.insert(QStringLiteral("profile"), m_options.profile.name);
+    root.insert(QStringLiteral("qt"), QString::fromLatin1(qVersion()));
+    root.insert(QStringLiteral("sqlite"), m_sqliteVersion);
+    root.insert(QStringLiteral("os"), QSysInfo::prettyProductName());
+    root.insert(QStringLiteral("cpu"), QSysInfo::currentCpuArchitecture());
+    root.insert(QStringLiteral("results"), results);
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+
+    if (m_options.outputPath.isEmpty()) {
+        fwrite(json.constData(), 1, size_t(json.size()), stdout);
+        fflush(stdout);
+        return true;
+    }
+    QSaveFile file(m_options.outputPath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit())
+        return fail(file.errorString());
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef TASKBENCHMARK_H
+#define TASKBENCHMARK_H
+
+#include "StorageProfile.h"
+#include "TaskRepository.h"
+
+#include <QString>
+#include <QTextStream>
+#include <QVector>
+
+// Набор замеров SelfImprovementBench: та же работа, что делают поток БД и модель GUI, на
+// синтетической базе (TaskDataGenerator) заданного размера.
+//   open_init_schema / init_schema_empty — открытие с актуальной схемой и с нуля;
+//   page_<столбец>_<first|middle|last> — fetchPage() для каждого столбца сортировки
+//     (first — первая страница, middle/last — переход "вперёд" от предыдущей страницы по якорю,
+//     как кнопка "След >");
+//   model_set_page_<N> — TaskTableModel::setPage() и чтение всех ячеек (DisplayRole);
+//   render_page — полная перерисовка TaskTableView со страницей (offscreen QPA);
+//   insert / update / set_status / soft_delete / hard_delete — записи по одной, в autocommit.
+// Итог — JSON (см. writeReport()): на каждый замер min/median/p95/mean/max в миллисекундах.
+class TaskBenchmark
+{
+public:
+    struct Options {
+        qint64 tasks = 100000;
+        quint64 seed = 1;
+        QString dbPath;     // пусто — файл во временном каталоге по числу задач и seed
+        QString outputPath; // пусто — stdout
+        int repeat = 5;     // повторов каждого замера чтения
+        int writeOps = 200; // задач на каждый замер записи
+        int pageSize = 50;
+        bool regenerate = false;
+        StorageProfile profile;
+    };
+
+    TaskBenchmark(const Options &options, QTextStream &log);
+
+    // Код завершения процесса: 0 — все замеры выполнены и отчёт записан
+    int run();
+
+private:
+    struct Result {
+        QString name;
+        QVector<qint64> ns; // время каждой итерации
+    };
+
+    bool prepareDatabase();
+    bool benchOpen();
+    bool benchPages();
+    bool benchModel();
+    bool benchWrites();
+    bool writeReport();
+
+    // Одна итерация замера; false из body прерывает бенчмарк (ошибка уже в m_error)
+    template <typename Body>
+    bool measure(const QString &name, int iterations, Body &&body);
+    bool fail(const QString &message);
+
+    Options m_options;
+    QTextStream &m_log;
+    TaskRepository m_repository;
+    QVector<Result> m_results;
+    QString m_error;
+    QString m_sqliteVersion;
+};
+
+#endif // TASKBENCHMARK_H
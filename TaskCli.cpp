@@ -0,0 +1,576 @@
+#include "TaskCli.h"
+#include "TaskBackup.h"
+#include "TaskPage.h"
+#include "TaskSync.h"
+#include "TaskTableModel.h"
+#include "TimestampFormat.h"
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QSqlDatabase>
+#include <QSqlError>
+
+#include <cstdio>
+#include <limits>
+
+namespace {
+// Соединение консольного режима (у GUI своё — в потоке БД)
+const char *const ConnectionName = "tracker_cli";
+constexpr int DefaultPageSize = 20;
+// Копий в каталоге по умолчанию — как у плановых копий GUI
+constexpr int DefaultBackupKeep = 7;
+
+int sortColumnByName(const QString &name)
+{
+    static const QHash<QString, int> columns = {
+        { QStringLiteral("description"), TaskTableModel::COL_DESC },
+        { QStringLiteral("details"), TaskTableModel::COL_DETAILS },
+        { QStringLiteral("created"), TaskTableModel::COL_CREATION_DT },
+        { QStringLiteral("completed"), TaskTableModel::COL_COMPLETION_DT },
+        { QStringLiteral("status"), TaskTableModel::COL_STATUS }
+    };
+    return columns.value(name.toLower(), -2);
+}
+
+QJsonValue jsonText(const TaskPage &page, int row, int column)
+{
+    return page.isNull(row, column) ? QJsonValue() : QJsonValue(page.text(row, column));
+}
+
+// Даты в выводе — ISO 8601 в UTC, независимо от часового пояса машины
+QJsonValue jsonDate(const TaskPage &page, int row, int column)
+{
+    return page.isNull(row, column) ? QJsonValue() : QJsonValue(TimestampFormat::toIso(page.dateMs(row, column)));
+}
+
+// Список id задач; false, если пуст или есть не число
+bool parseIds(const QStringList &args, QVector<int> *ids)
+{
+    ids->clear();
+    for (const QString &arg : args) {
+        bool ok = false;
+        const int id = arg.toInt(&ok);
+        if (!ok)
+            return false;
+        ids->append(id);
+    }
+    return !ids->isEmpty();
+}
+}
+
+TaskCli::TaskCli(QTextStream &out, QTextStream &err)
+    : m_out(out)
+    , m_err(err)
+    , m_repository(QString::fromLatin1(ConnectionName))
+    , m_inBatch(false)
+{
+}
+
+int TaskCli::run(const QStringList &arguments)
+{
+    QString dbPath;
+    StorageProfile profile = StorageProfile::fromEnvironment();
+    bool verbose = false;
+    int i = 0;
+    for (; i < arguments.size(); ++i) {
+        const QString &arg = arguments.at(i);
+        if (arg == QLatin1String("--db") && i + 1 < arguments.size())
+            dbPath = arguments.at(++i);
+        else if (arg == QLatin1String("--profile") && i + 1 < arguments.size()) {
+            bool known = false;
+            profile = StorageProfile::byName(arguments.at(++i), &known);
+            if (!known)
+                return usage(QStringLiteral("неизвестный профиль \"%1\" (balanced, durable, fast)").arg(arguments.at(i)));
+        } else if (arg == QLatin1String("--verbose"))
+            verbose = true;
+        else if (arg == QLatin1String("--help") || arg == QLatin1String("-h")) {
+            printUsage();
+            return ExitOk;
+        } else
+            break;
+    }
+    const QStringList command = arguments.mid(i);
+    if (command.isEmpty())
+        return usage(QStringLiteral("не указана команда"));
+
+    // Отладочный вывод репозитория ("Database connected..." и т.п.) мешает разбирать stdout/stderr
+    if (!verbose)
+        QLoggingCategory::setFilterRules(QStringLiteral("*.debug=false\n*.warning=false"));
+
+    if (command.first() == QLatin1String("restore-backup"))
+        return restoreBackup(dbPath.isEmpty() ? TaskRepository::defaultDatabasePath() : dbPath, command.mid(1));
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!openDatabase(dbPath.isEmpty() ? TaskRepository::defaultDatabasePath() : dbPath, profile))
+        return ExitFailed;
+    if (verbose)
+        m_err << "database ready in " << timer.nsecsElapsed() / 1000 << " us" << Qt::endl;
+
+    const int code = (command.first() == QLatin1String("batch")) ? runBatch() : execute(command);
+    if (verbose)
+        m_err << "done in " << timer.nsecsElapsed() / 1000 << " us" << Qt::endl;
+    return code;
+}
+
+bool TaskCli::openDatabase(const QString &path, const StorageProfile &profile)
+{
+    if (!m_repository.open(path, ConnectionRole::Standalone, profile)) {
+        fail(m_repository.lastError());
+        return false;
+    }
+    // Актуальная схема — одно чтение PRAGMA user_version
+    if (!m_repository.initSchema()) {
+        fail(m_repository.lastError());
+        return false;
+    }
+    return true;
+}
+
+int TaskCli::execute(const QStringList &args)
+{
+    const QString name = args.first();
+    const QStringList rest = args.mid(1);
+    if (name == QLatin1String("add"))
+        return add(rest);
+    if (name == QLatin1String("list"))
+        return list(rest);
+    if (name == QLatin1String("set-status"))
+        return setStatus(rest);
+    if (name == QLatin1String("delete"))
+        return remove(rest);
+    if (name == QLatin1String("restore"))
+        return restore(rest);
+    if (name == QLatin1String("stats"))
+        return stats(rest);
+    if (name == QLatin1String("vacuum"))
+        return vacuum(rest);
+    if (name == QLatin1String("backup"))
+        return backup(rest);
+    if (name == QLatin1String("sync") || name == QLatin1String("sync-export") || name == QLatin1String("sync-import"))
+        return sync(name, rest);
+    return usage(QStringLiteral("неизвестная команда \"%1\"").arg(name));
+}
+
+int TaskCli::runBatch()
+{
+    // Одна транзакция на весь пакет: тысячи команд — одна запись журнала вместо тысячи fsync
+    QSqlDatabase db = m_repository.database();
+    if (!db.transaction())
+        return fail(db.lastError().text());
+
+    m_inBatch = true;
+    QTextStream in(stdin);
+    int lineNumber = 0;
+    int executed = 0;
+    QString line;
+    while (in.readLineInto(&line)) {
+        ++lineNumber;
+        const QString trimmed = line.trimmed();
+        if (trimmed.isEmpty() || trimmed.startsWith(QLatin1Char('#')))
+            continue;
+
+        bool ok = false;
+        const QStringList args = splitCommandLine(trimmed, &ok);
+        int code = ExitUsage;
+        if (!ok)
+            m_err << "error: unbalanced quotes" << Qt::endl;
+        else if (args.first() == QLatin1String("batch"))
+            m_err << "error: nested batch" << Qt::endl;
+        else
+            code = execute(args);
+
+        if (code != ExitOk) {
+            db.rollback();
+            m_inBatch = false;
+            m_err << "batch line " << lineNumber << " failed, " << executed << " previous command(s) rolled back" << Qt::endl;
+            return code;
+        }
+        ++executed;
+    }
+    m_inBatch = false;
+
+    if (!db.commit()) {
+        const QString error = db.lastError().text();
+        db.rollback();
+        return fail(error);
+    }
+    return ExitOk;
+}
+
+int TaskCli::add(const QStringList &args)
+{
+    QCommandLineParser parser;
+    const QCommandLineOption detailsOption(QStringLiteral("details"), QString(), QStringLiteral("text"));
+    const QCommandLineOption statusOption(QStringLiteral("status"), QString(), QStringLiteral("name"));
+    parser.addOptions({ detailsOption, statusOption });
+    if (!parser.parse(QStringList{ QStringLiteral("add") } + args))
+        return usage(parser.errorText());
+    const QStringList positional = parser.positionalArguments();
+    if (positional.size() != 1 || positional.first().trimmed().isEmpty())
+        return usage(QStringLiteral("add: нужен текст задания (одним аргументом)"));
+
+    TaskRecord task;
+    task.description = positional.first();
+    task.details = parser.value(detailsOption);
+    task.statusId = statusIdFor(parser.isSet(statusOption) ? parser.value(statusOption) : StatusRegistry::plannedName());
+    if (task.statusId < 0)
+        return ExitFailed;
+    if (!m_repository.insertTask(task))
+        return fail(m_repository.lastError());
+
+    m_out << task.id << Qt::endl;
+    return ExitOk;
+}
+
+int TaskCli::list(const QStringList &args)
+{
+    QCommandLineParser parser;
+    const QCommandLineOption sortOption(QStringLiteral("sort"), QString(), QStringLiteral("column"));
+    const QCommandLineOption ascOption(QStringLiteral("asc"));
+    const QCommandLineOption descOption(QStringLiteral("desc"));
+    const QCommandLineOption pageOption(QStringLiteral("page"), QString(), QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption pageSizeOption(QStringLiteral("page-size"), QString(), QStringLiteral("n"),
+                                            QString::number(DefaultPageSize));
+    const QCommandLineOption searchOption(QStringLiteral("search"), QString(), QStringLiteral("text"));
+    const QCommandLineOption jsonOption(QStringLiteral("json"));
+    const QCommandLineOption dateOption(QStringLiteral("date"), QString(), QStringLiteral("column"));
+    const QCommandLineOption fromOption(QStringLiteral("from"), QString(), QStringLiteral("time"));
+    const QCommandLineOption toOption(QStringLiteral("to"), QString(), QStringLiteral("time"));
+    const QCommandLineOption trashOption(QStringLiteral("trash"));
+    parser.addOptions({ sortOption, ascOption, descOption, pageOption, pageSizeOption, searchOption, jsonOption,
+                        dateOption, fromOption, toOption, trashOption });
+    if (!parser.parse(QStringList{ QStringLiteral("list") } + args))
+        return usage(parser.errorText());
+    if (!parser.positionalArguments().isEmpty())
+        return usage(QStringLiteral("list: лишние аргументы"));
+
+    PageRequest request;
+    if (parser.isSet(sortOption)) {
+        request.sortColumn = sortColumnByName(parser.value(sortOption));
+        if (request.sortColumn == -2)
+            return usage(QStringLiteral("list: сортировка по description, details, created, completed или status"));
+    }
+    request.sortOrder = parser.isSet(descOption) ? Qt::DescendingOrder : Qt::AscendingOrder;
+    if (request.sortColumn < 0 && parser.isSet(ascOption)) {
+        // Порядок по умолчанию (новые сверху) — это created по убыванию; --asc его разворачивает
+        request.sortColumn = TaskTableModel::COL_CREATION_DT;
+    }
+    bool pageOk = false;
+    bool sizeOk = false;
+    const int page = parser.value(pageOption).toInt(&pageOk);
+    request.pageSize = parser.value(pageSizeOption).toInt(&sizeOk);
+    if (!pageOk || page < 1 || !sizeOk || request.pageSize < 1)
+        return usage(QStringLiteral("list: --page и --page-size — целые числа от 1"));
+    request.page = request.steps = page - 1;
+    request.seek = PageSeek::First;
+    request.search = parser.value(searchOption);
+    request.trash = parser.isSet(trashOption);
+    if (parser.isSet(dateOption)) {
+        request.dateColumn = sortColumnByName(parser.value(dateOption));
+        if (request.dateColumn != TaskTableModel::COL_CREATION_DT && request.dateColumn != TaskTableModel::COL_COMPLETION_DT)
+            return usage(QStringLiteral("list: фильтр --date по created или completed"));
+        request.dateFrom = 0;
+        request.dateTo = std::numeric_limits<qint64>::max();
+        if ((parser.isSet(fromOption) && !TimestampFormat::parse(parser.value(fromOption), &request.dateFrom))
+            || (parser.isSet(toOption) && !TimestampFormat::parse(parser.value(toOption), &request.dateTo)))
+            return usage(QStringLiteral("list: --from/--to — ISO 8601, \"yyyy-MM-dd HH:mm:ss\" или мс от эпохи"));
+    } else if (parser.isSet(fromOption) || parser.isSet(toOption)) {
+        return usage(QStringLiteral("list: --from/--to задаются вместе с --date"));
+    }
+
+    // fetchBlock(), а не fetchPage(): страница за концом списка должна прийти пустой, а не первой
+    const PageResult result = m_repository.fetchBlock(request);
+    if (!result.ok)
+        return fail(result.error);
+    const TaskPage &rows = *result.page;
+
+    if (parser.isSet(jsonOption)) {
+        QJsonArray tasks;
+        for (int row = 0; row < rows.rowCount(); ++row) {
+            QJsonObject task;
+            task.insert(QStringLiteral("id"), rows.taskId(row));
+            task.insert(QStringLiteral("description"), jsonText(rows, row, TaskPage::TEXT_DESC));
+            // В странице лишь начало длинного "Описания" — полный текст отдельным запросом
+            QJsonValue details = jsonText(rows, row, TaskPage::TEXT_DETAILS);
+            if (rows.hasMoreDetails(row)) {
+                bool ok = false;
+                const QString full = m_repository.loadDetails(rows.taskId(row), &ok);
+                if (!ok)
+                    return fail(m_repository.lastError());
+                details = full;
+            }
+            task.insert(QStringLiteral("details"), details);
+            task.insert(QStringLiteral("status"), rows.statusName(row));
+            task.insert(QStringLiteral("creation_dt"), jsonDate(rows, row, TaskPage::TEXT_CREATION_DT));
+            task.insert(QStringLiteral("completion_dt"), jsonDate(rows, row, TaskPage::TEXT_COMPLETION_DT));
+            tasks.append(task);
+        }
+        QJsonObject root;
+        root.insert(QStringLiteral("page"), page);
+        root.insert(QStringLiteral("page_size"), request.pageSize);
+        root.insert(QStringLiteral("total"), result.total);
+        root.insert(QStringLiteral("tasks"), tasks);
+        m_out << QJsonDocument(root).toJson(QJsonDocument::Compact) << Qt::endl;
+        return ExitOk;
+    }
+
+    // Текст: одна задача на строку, поля через табуляцию (удобно для cut/awk)
+    for (int row = 0; row < rows.rowCount(); ++row) {
+        m_out << rows.taskId(row) << '\t' << rows.statusName(row) << '\t'
+              << TimestampFormat::toIso(rows.dateMs(row, TaskPage::TEXT_CREATION_DT)) << '\t'
+              << TimestampFormat::toIso(rows.dateMs(row, TaskPage::TEXT_COMPLETION_DT)) << '\t'
+              << rows.textView(row, TaskPage::TEXT_DESC) << '\n';
+    }
+    m_out.flush();
+    return ExitOk;
+}
+
+int TaskCli::setStatus(const QStringList &args)
+{
+    QVector<int> ids;
+    if (args.size() < 2 || !parseIds(args.mid(0, args.size() - 1), &ids))
+        return usage(QStringLiteral("set-status: нужны id задач и имя статуса"));
+    const int statusId = statusIdFor(args.last());
+    if (statusId < 0)
+        return ExitFailed;
+    if (ids.size() == 1)
+        return m_repository.setTaskStatus(ids.first(), statusId) ? int(ExitOk) : fail(m_repository.lastError());
+    return runBulk([this, &ids, statusId]() { return m_repository.setTasksStatus(ids, statusId); });
+}
+
+int TaskCli::remove(const QStringList &args)
+{
+    QStringList rest = args;
+    const bool hard = rest.removeAll(QStringLiteral("--hard")) > 0;
+    QVector<int> ids;
+    if (!parseIds(rest, &ids))
+        return usage(QStringLiteral("delete: нужны id задач"));
+    if (ids.size() == 1) {
+        const bool ok = hard ? m_repository.hardDeleteTask(ids.first()) : m_repository.softDeleteTask(ids.first());
+        return ok ? int(ExitOk) : fail(m_repository.lastError());
+    }
+    return runBulk([this, &ids, hard]() {
+        return hard ? m_repository.hardDeleteTasks(ids) : m_repository.softDeleteTasks(ids);
+    });
+}
+
+int TaskCli::restore(const QStringList &args)
+{
+    QVector<int> ids;
+    if (!parseIds(args, &ids))
+        return usage(QStringLiteral("restore: нужны id задач"));
+    return runBulk([this, &ids]() { return m_repository.restoreTasks(ids); });
+}
+
+int TaskCli::runBulk(const std::function<bool()> &operation)
+{
+    // Большой набор id идёт через временную таблицу — несколько операторов; вне пакета
+    // оборачиваем их в свою транзакцию (внутри пакета транзакция уже открыта)
+    QSqlDatabase db = m_repository.database();
+    if (!m_inBatch && !db.transaction())
+        return fail(db.lastError().text());
+    if (!operation()) {
+        if (!m_inBatch)
+            db.rollback();
+        return fail(m_repository.lastError());
+    }
+    if (!m_inBatch && !db.commit()) {
+        const QString error = db.lastError().text();
+        db.rollback();
+        return fail(error);
+    }
+    return ExitOk;
+}
+
+int TaskCli::stats(const QStringList &args)
+{
+    const bool json = args.contains(QStringLiteral("--json"));
+    if (args.size() > (json ? 1 : 0))
+        return usage(QStringLiteral("stats: лишние аргументы"));
+
+    // Счётчики TASK_STATS — O(1), без прохода по TASK
+    const TaskCounts counts = m_repository.counts();
+    const StatusRegistry &statuses = m_repository.statuses();
+    if (json) {
+        QJsonObject byStatus;
+        for (auto it = counts.liveByStatus.cbegin(); it != counts.liveByStatus.cend(); ++it)
+            byStatus.insert(statuses.name(it.key()), it.value());
+        QJsonObject root;
+        root.insert(QStringLiteral("live"), counts.live);
+        root.insert(QStringLiteral("deleted"), counts.deleted);
+        root.insert(QStringLiteral("by_status"), byStatus);
+        m_out << QJsonDocument(root).toJson(QJsonDocument::Compact) << Qt::endl;
+        return ExitOk;
+    }
+
+    m_out << "live\t" << counts.live << '\n' << "deleted\t" << counts.deleted << '\n';
+    for (const QString &name : statuses.names())
+        m_out << name << '\t' << counts.liveByStatus.value(statuses.id(name)) << '\n';
+    m_out.flush();
+    return ExitOk;
+}
+
+int TaskCli::vacuum(const QStringList &args)
+{
+    if (!args.isEmpty())
+        return usage(QStringLiteral("vacuum: лишние аргументы"));
+    // VACUUM не выполняется внутри транзакции
+    if (m_inBatch)
+        return fail(QStringLiteral("vacuum: недоступен внутри batch"));
+    const int before = m_repository.autoVacuumMode();
+    if (!m_repository.vacuum())
+        return fail(m_repository.lastError());
+    if (before != 2)
+        m_out << "auto_vacuum: incremental" << Qt::endl;
+    return ExitOk;
+}
+
+int TaskCli::sync(const QString &command, const QStringList &args)
+{
+    const bool all = (command == QLatin1String("sync-export")) && args.contains(QStringLiteral("--all"));
+    if (args.size() != (all ? 2 : 1) || args.first().startsWith(QLatin1String("--")))
+        return usage(QStringLiteral("%1: нужен путь").arg(command));
+    if (m_inBatch)
+        return fail(QStringLiteral("%1: недоступен внутри batch").arg(command));
+
+    TaskSync sync(m_repository);
+    SyncResult result;
+    if (command == QLatin1String("sync"))
+        result = sync.syncDirectory(args.first());
+    else if (command == QLatin1String("sync-export"))
+        result = sync.exportChanges(args.first(), all ? 0 : sync.exportedMark());
+    else
+        result = sync.importChanges(args.first());
+    if (!result.ok)
+        return fail(result.error);
+    m_out << "exported\t" << result.exported << '\n'
+          << "applied\t" << result.applied << '\n'
+          << "skipped\t" << result.skipped << '\n'
+          << "files\t" << result.files << Qt::endl;
+    return ExitOk;
+}
+
+int TaskCli::backup(const QStringList &args)
+{
+    bool raw = false;
+    QStringList paths;
+    for (const QString &arg : args) {
+        if (arg == QLatin1String("--raw"))
+            raw = true;
+        else if (arg.startsWith(QLatin1String("--")))
+            return usage(QStringLiteral("backup: неизвестный параметр %1").arg(arg));
+        else
+            paths << arg;
+    }
+    if (paths.size() > 1)
+        return usage(QStringLiteral("backup: ожидается [<файл>] [--raw]"));
+    // Копия читает согласованный снимок базы — внутри открытой транзакции пакета это был бы её снимок
+    if (m_inBatch)
+        return fail(QStringLiteral("backup: недоступен внутри batch"));
+
+    TaskBackup backup(m_repository);
+    const BackupResult result = paths.isEmpty()
+        ? backup.backupToDirectory(TaskBackup::defaultDirectory(), DefaultBackupKeep)
+        : backup.backupToFile(paths.first(), !raw);
+    if (!result.ok)
+        return fail(result.error);
+    m_out << result.path << '\t' << result.bytes << Qt::endl;
+    return ExitOk;
+}
+
+int TaskCli::restoreBackup(const QString &databasePath, const QStringList &args)
+{
+    if (args.size() != 1)
+        return usage(QStringLiteral("restore-backup: нужен файл копии"));
+    const BackupResult result = TaskBackup::restore(args.first(), databasePath);
+    if (!result.ok)
+        return fail(result.error);
+    m_out << "restored\t" << result.path << Qt::endl;
+    return ExitOk;
+}
+
+int TaskCli::statusIdFor(const QString &name)
+{
+    int id = m_repository.statusIdByName(name);
+    // STATUS могли дополнить из другого процесса — перечитываем справочник один раз
+    if (id < 0 && m_repository.reloadStatuses())
+        id = m_repository.statusIdByName(name);
+    if (id < 0)
+        fail(QStringLiteral("неизвестный статус \"%1\" (есть: %2)").arg(name, m_repository.statusNames().join(QStringLiteral(", "))));
+    return id;
+}
+
+int TaskCli::fail(const QString &message)
+{
+    m_err << "error: " << message << Qt::endl;
+    return ExitFailed;
+}
+
+int TaskCli::usage(const QString &message)
+{
+    m_err << "error: " << message << Qt::endl;
+    if (!m_inBatch)
+        printUsage();
+    return ExitUsage;
+}
+
+void TaskCli::printUsage()
+{
+    m_err << "usage: SelfImprovementCli [--db PATH] [--profile balanced|durable|fast] [--verbose] <command> [args]\n"
+             "  add <description> [--details TEXT] [--status NAME]\n"
+             "  list [--sort description|details|created|completed|status] [--asc|--desc]\n"
+             "       [--page N] [--page-size N] [--search TEXT] [--json]\n"
+             "       [--date created|completed [--from TIME] [--to TIME]]   range [from, to)\n"
+             "       [--trash]   deleted tasks instead of live ones\n"
+             "  set-status <id>... <status>\n"
+             "  delete <id>... [--hard]\n"
+             "  restore <id>...\n"
+             "  stats [--json]\n"
+             "  sync <dir>   exchange changes with other devices through a shared directory\n"
+             "  sync-export <file> [--all]   own changes since the last export (--all: whole log)\n"
+             "  sync-import <file>   apply changes exported by another device\n"
+             "  backup [<file>] [--raw]   online backup (default: compressed, into the backup directory with rotation)\n"
+             "  restore-backup <file>   replace the database with a verified backup (app must be closed)\n"
+             "  vacuum   rebuild the file and switch it to incremental auto_vacuum\n"
+             "  batch   read commands from stdin, one per line, in a single transaction\n";
+    m_err.flush();
+}
+
+QStringList TaskCli::splitCommandLine(const QString &line, bool *ok)
+{
+    QStringList args;
+    QString current;
+    bool inWord = false;
+    QChar quote;
+    for (int i = 0; i < line.size(); ++i) {
+        const QChar c = line.at(i);
+        if (!quote.isNull()) {
+            if (c == quote)
+                quote = QChar();
+            else if (c == QLatin1Char('\\') && quote == QLatin1Char('"') && i + 1 < line.size())
+                current += line.at(++i);
+            else
+                current += c;
+        } else if (c == QLatin1Char('"') || c == QLatin1Char('\'')) {
+            quote = c;
+            inWord = true;
+        } else if (c.isSpace()) {
+            if (inWord)
+                args << current;
+            current.clear();
+            inWord = false;
+        } else {
+            current += c;
+            inWord = true;
+        }
+    }
+    if (inWord)
+        args << current;
+    *ok = quote.isNull();
+    return args;
+}
@@ -0,0 +1,76 @@
+#ifndef TASKCLI_H
+#define TASKCLI_H
+
+#include "TaskRepository.h"
+
+#include <QStringList>
+#include <QTextStream>
+
+// Консольный режим без виджетов (SelfImprovementCli): команды выполняются синхронно на том же
+// TaskRepository, что и в GUI, но без потока БД.
+//
+//   add <задание> [--details ТЕКСТ] [--status ИМЯ]
+//   list [--sort столбец] [--asc|--desc] [--page N] [--page-size N] [--search ТЕКСТ] [--json]
+//        [--date created|completed [--from ВРЕМЯ] [--to ВРЕМЯ]] — полуинтервал [from, to)
+//        [--trash] — корзина вместо живых задач
+//   set-status <id>... <статус>
+//   delete <id>... [--hard]
+//   restore <id>... — вернуть из корзины
+//   (несколько id — один UPDATE/DELETE на весь набор, см. TaskRepository::setTasksStatus())
+//   stats [--json]
+//   sync <каталог> — обмен изменениями через общий каталог (см. TaskSync)
+//   sync-export <файл> [--all] — свои изменения после прошлого экспорта (--all — весь журнал)
+//   sync-import <файл> — применить изменения другого устройства
+//   backup [<файл>] [--raw] — резервная копия на ходу (по умолчанию — сжатая, в каталог копий с ротацией)
+//   restore-backup <файл> — восстановить базу из копии (приложение должно быть закрыто)
+//   vacuum — полный VACUUM с переводом базы в auto_vacuum = INCREMENTAL (долгий, блокирует запись)
+//   batch — команды построчно из stdin, все в одной транзакции (ошибка — откат всего пакета)
+//
+// Общие параметры перед командой: --db ПУТЬ, --profile ИМЯ (см. StorageProfile), --verbose.
+class TaskCli
+{
+public:
+    TaskCli(QTextStream &out, QTextStream &err);
+
+    // arguments — без имени программы; возвращает код завершения процесса
+    int run(const QStringList &arguments);
+
+    // Разбивает строку пакета на аргументы: пробелы — разделители, "..." и '...' — одно слово,
+    // \ внутри двойных кавычек экранирует следующий символ
+    static QStringList splitCommandLine(const QString &line, bool *ok);
+
+private:
+    enum ExitCode { ExitOk = 0, ExitFailed = 1, ExitUsage = 2 };
+
+    bool openDatabase(const QString &path, const StorageProfile &profile);
+    int execute(const QStringList &args);
+    int runBatch();
+
+    int add(const QStringList &args);
+    int list(const QStringList &args);
+    int setStatus(const QStringList &args);
+    int remove(const QStringList &args);
+    int restore(const QStringList &args);
+    // Массовая операция — в своей транзакции, если не внутри batch
+    int runBulk(const std::function<bool()> &operation);
+    int stats(const QStringList &args);
+    int vacuum(const QStringList &args);
+    // sync, sync-export, sync-import: свои транзакции, поэтому не внутри batch
+    int sync(const QString &command, const QStringList &args);
+    int backup(const QStringList &args);
+    // Выполняется до открытия базы: файл заменяется целиком
+    int restoreBackup(const QString &databasePath, const QStringList &args);
+
+    // Имя статуса → id; незнакомое имя — ошибка (в отличие от GUI, без подстановки по умолчанию)
+    int statusIdFor(const QString &name);
+    int fail(const QString &message);
+    int usage(const QString &message);
+    void printUsage();
+
+    QTextStream &m_out;
+    QTextStream &m_err;
+    TaskRepository m_repository;
+    bool m_inBatch;
+};
+
+#endif // TASKCLI_H
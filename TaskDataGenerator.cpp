@@ -0,0 +1,142 @@
+#include "TaskDataGenerator.h"
+#include "TaskRepository.h"
+
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace {
+// Строк между вызовами progress
+constexpr qint64 ProgressRows = 10000;
+// Порция сжатия длинных описаний после вставки
+constexpr int CompactRows = 1000;
+constexpr qint64 DayMs = 24LL * 60 * 60 * 1000;
+constexpr qint64 HistoryMs = 3 * 365 * DayMs;
+
+const char *const Vocabulary[] = {
+    "прочитать", "книгу", "главу", "написать", "отчёт", "позвонить", "маме", "пробежка", "утром",
+    "купить", "продукты", "выучить", "слова", "повторить", "конспект", "медитация", "десять", "минут",
+    "разобрать", "почту", "спланировать", "неделю", "тренировка", "зал", "курс", "английского",
+    "review", "pull", "request", "refactor", "parser", "fix", "build", "deploy", "notes", "draft",
+    "лекция", "по", "алгоритмам", "задача", "проект", "дома", "сон", "до", "полуночи", "вода"
+};
+constexpr int VocabularySize = int(sizeof(Vocabulary) / sizeof(Vocabulary[0]));
+}
+
+TaskDataGenerator::TaskDataGenerator(quint64 seed)
+    : m_state(seed)
+{
+}
+
+quint64 TaskDataGenerator::next()
+{
+    // splitmix64
+    quint64 z = (m_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+int TaskDataGenerator::below(int n)
+{
+    return n > 0 ? int(next() % quint64(n)) : 0;
+}
+
+QString TaskDataGenerator::words(int minChars, int maxChars)
+{
+    const int target = minChars + below(maxChars - minChars + 1);
+    QString text;
+    text.reserve(target + 16);
+    while (text.size() < target) {
+        if (!text.isEmpty())
+            text += QLatin1Char(' ');
+        text += QString::fromUtf8(Vocabulary[below(VocabularySize)]);
+    }
+    return text;
+}
+
+bool TaskDataGenerator::fill(TaskRepository &repository, qint64 count, QString *error,
+                             const std::function<void(qint64)> &progress)
+{
+    const StatusRegistry &statuses = repository.statuses();
+    const int plannedId = qMax(1, statuses.id(StatusRegistry::plannedName()));
+    const int doneId = repository.doneStatusId();
+    auto idOr = [&](const char *name) {
+        const int id = statuses.id(QString::fromUtf8(name));
+        return id != -1 ? id : plannedId;
+    };
+    const int inProgressId = idOr("В процессе");
+    const int postponedId = idOr("Отложено");
+    const int cancelledId = idOr("Отменено");
+
+    QSqlDatabase db = repository.database();
+    if (!db.transaction()) {
+        *error = db.lastError().text();
+        return false;
+    }
+    QSqlQuery insert(db);
+    if (!insert.prepare("INSERT INTO TASK (description, details, creation_dt, completion_dt, status_id, is_deleted, deleted_dt) "
+                        "VALUES (?, ?, ?, ?, ?, ?, ?)")) {
+        *error = insert.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    for (qint64 i = 0; i < count; ++i) {
+        const int statusRoll = below(100);
+        const int statusId = statusRoll < 45 ? doneId
+                           : statusRoll < 70 ? inProgressId
+                           : statusRoll < 90 ? plannedId
+                           : statusRoll < 95 ? postponedId
+                           : cancelledId;
+
+        QVariant details;
+        const int detailsRoll = below(100);
+        if (detailsRoll >= 95)
+            details = words(2000, 8000);
+        else if (detailsRoll >= 80)
+            details = words(200, 1000);
+        else if (detailsRoll >= 30)
+            details = words(20, 120);
+
+        const qint64 created = EndOfHistoryMs - qint64(next() % quint64(HistoryMs));
+        QVariant completed;
+        if (statusId == doneId)
+            completed = created + qint64(next() % quint64(30 * DayMs));
+
+        insert.bindValue(0, words(8, 60));
+        insert.bindValue(1, details);
+        insert.bindValue(2, created);
+        insert.bindValue(3, completed);
+        insert.bindValue(4, statusId);
+        const bool deleted = below(100) < 2;
+        insert.bindValue(5, deleted ? 1 : 0);
+        // Время удаления — без лишних случайных чисел: последовательность для seed не меняется
+        insert.bindValue(6, deleted ? QVariant(created + DayMs) : QVariant());
+        if (!insert.exec()) {
+            *error = insert.lastError().text();
+            db.rollback();
+            return false;
+        }
+        if (progress && (i + 1) % ProgressRows == 0)
+            progress(i + 1);
+    }
+
+    if (!db.commit()) {
+        *error = db.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    // Длинные описания — в том виде, в каком их хранит приложение (сжатыми, см.
+    // TaskRepository::compactDetails()): замеры страниц идут на тех же данных
+    int compacted = 0;
+    do {
+        compacted = repository.compactDetails(CompactRows);
+    } while (compacted == CompactRows);
+    if (compacted < 0) {
+        *error = repository.lastError();
+        return false;
+    }
+    return true;
+}
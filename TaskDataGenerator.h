@@ -0,0 +1,44 @@
+#ifndef TASKDATAGENERATOR_H
+#define TASKDATAGENERATOR_H
+
+#include <QString>
+
+#include <functional>
+
+class TaskRepository;
+
+// Синтетические задачи для бенчмарков (SelfImprovementBench). Результат зависит только от seed
+// и числа задач: собственный генератор (splitmix64) и целочисленная арифметика вместо
+// std::*_distribution, которые на разных стандартных библиотеках дают разные значения.
+//
+// Смесь приближена к живой базе:
+//   статусы — Сделано 45%, В процессе 25%, Запланировано 20%, Отложено/Отменено по 5%;
+//   описание — 8–60 символов; детали — пусто 30%, короткие (до 120 символов) 50%,
+//   средние (до 1000) 15%, длинные (до 8000) 5%;
+//   даты создания — равномерно за три года до фиксированного момента, выполнение — через
+//   0–30 дней после создания; мягко удалено 2% задач.
+class TaskDataGenerator
+{
+public:
+    // Конец интервала дат создания (2024-01-01T00:00:00Z) — не текущее время, чтобы данные
+    // с тем же seed не зависели от дня запуска
+    static constexpr qint64 EndOfHistoryMs = 1704067200000LL;
+
+    explicit TaskDataGenerator(quint64 seed);
+
+    // Дописывает count задач в TASK одной транзакцией (схема уже приведена initSchema()).
+    // progress вызывается раз в пачку строк с числом уже вставленных.
+    bool fill(TaskRepository &repository, qint64 count, QString *error,
+              const std::function<void(qint64)> &progress = {});
+
+private:
+    quint64 next();
+    // Равномерно в [0, n)
+    int below(int n);
+    // Текст из словаря длиной от minChars до maxChars символов (по границе слова)
+    QString words(int minChars, int maxChars);
+
+    quint64 m_state;
+};
+
+#endif // TASKDATAGENERATOR_H
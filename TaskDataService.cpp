@@ -0,0 +1,260 @@
+#include "TaskDataService.h"
+
+#include <QDebug>
+#include <QTimer>
+
+namespace {
+// Первая проверка расписания копий после открытия (не мешает запуску) и период проверок, мс
+constexpr int BackupFirstCheckMs = 2 * 60 * 1000;
+constexpr int BackupCheckIntervalMs = 60 * 60 * 1000;
+constexpr int DefaultBackupHours = 24;
+constexpr int DefaultBackupKeep = 7;
+
+int environmentInt(const char *name, int defaultValue)
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue(name, &ok);
+    return (ok && value >= 0) ? value : defaultValue;
+}
+}
+
+TaskDataService::TaskDataService(QObject *parent)
+    : QObject(parent)
+    , m_writer(nullptr)
+    , m_readers{}
+    , m_latestPage(0)
+    , m_blockEpoch(0)
+    , m_importCancel(false)
+    , m_exportCancel(false)
+    , m_backupCancel(false)
+    , m_backupTimer(new QTimer(this))
+    , m_backupHours(environmentInt("TRACKER_BACKUP_HOURS", DefaultBackupHours))
+    , m_backupKeep(environmentInt("TRACKER_BACKUP_KEEP", DefaultBackupKeep))
+{
+    qRegisterMetaType<PageRequest>();
+    qRegisterMetaType<PageResult>();
+    qRegisterMetaType<TaskRecord>();
+    qRegisterMetaType<WriteResult>();
+    qRegisterMetaType<StatusRegistry>();
+    qRegisterMetaType<ImportResult>();
+    qRegisterMetaType<ExportResult>();
+    qRegisterMetaType<BackupResult>();
+
+    m_writer = createWorker(m_writerThread, QStringLiteral("tracker-writer"), ConnectionRole::Writer);
+    for (int i = 0; i < ReaderCount; ++i)
+        m_readers[i] = createWorker(m_readerThreads[i], QStringLiteral("tracker-reader-%1").arg(i), ConnectionRole::Reader);
+
+    connect(m_writer, &DatabaseWorker::opened, this, [this](bool ok, const QString &error, const StatusRegistry &statuses) {
+        // Читатели открываются после того, как писатель привёл схему; запросы GUI встают
+        // в их очереди уже после открытия
+        if (ok) {
+            for (DatabaseWorker *reader : m_readers)
+                QMetaObject::invokeMethod(reader, [reader, path = m_path]() { reader->open(path); }, Qt::QueuedConnection);
+            if (m_backupHours > 0)
+                m_backupTimer->start(BackupFirstCheckMs);
+        }
+        emit opened(ok, error, statuses);
+    });
+    for (DatabaseWorker *reader : m_readers) {
+        connect(reader, &DatabaseWorker::opened, this, [](bool ok, const QString &error) {
+            if (!ok)
+                qCritical() << "Failed to open reader connection:" << error;
+        });
+    }
+
+    connect(m_writer, &DatabaseWorker::taskWritten, this, &TaskDataService::taskWritten);
+    connect(m_writer, &DatabaseWorker::writesFlushed, this, &TaskDataService::writesFlushed);
+    connect(m_writer, &DatabaseWorker::countersRepaired, this, &TaskDataService::countersRepaired);
+    connect(m_writer, &DatabaseWorker::trashPurged, this, &TaskDataService::trashPurged);
+    connect(m_writer, &DatabaseWorker::externalChange, this, &TaskDataService::externalChange);
+    connect(m_writer, &DatabaseWorker::importProgress, this, &TaskDataService::importProgress);
+    connect(m_writer, &DatabaseWorker::importFinished, this, &TaskDataService::importFinished);
+    connect(m_readers[BulkReader], &DatabaseWorker::exportProgress, this, &TaskDataService::exportProgress);
+    connect(m_readers[BulkReader], &DatabaseWorker::exportFinished, this, &TaskDataService::exportFinished);
+    connect(m_readers[BackupReader], &DatabaseWorker::backupProgress, this, &TaskDataService::backupProgress);
+    connect(m_readers[BackupReader], &DatabaseWorker::backupFinished, this, &TaskDataService::backupFinished);
+    connect(m_backupTimer, &QTimer::timeout, this, [this]() {
+        m_backupTimer->start(BackupCheckIntervalMs);
+        requestBackup(qint64(m_backupHours) * 60 * 60 * 1000);
+    });
+    connect(m_readers[PageReader], &DatabaseWorker::pageReady, this, [this](const PageResult &result) {
+        // Результат мог устареть, пока шёл через очередь событий
+        if (result.request.generation == m_latestPage.load())
+            emit pageReady(result);
+    });
+    connect(m_readers[PageReader], &DatabaseWorker::detailsReady, this, &TaskDataService::detailsReady);
+    connect(m_readers[BlockReader], &DatabaseWorker::blockReady, this, [this](const PageResult &result) {
+        if (result.request.generation == m_blockEpoch.load())
+            emit blockReady(result);
+    });
+
+    m_writerThread.start();
+    for (QThread &thread : m_readerThreads)
+        thread.start();
+}
+
+TaskDataService::~TaskDataService()
+{
+    // Незавершённые импорт и экспорт прерываются, чтобы не ждать их окончания
+    m_importCancel.store(true);
+    m_exportCancel.store(true);
+    m_backupCancel.store(true);
+    m_backupTimer->stop();
+    // Блокирующий вызов встаёт в очередь за уже отправленными запросами — все записи
+    // успевают выполниться, затем соединение закрывается в своём потоке. Писатель — последним:
+    // его финальный checkpoint не должен ждать читателей.
+    for (DatabaseWorker *reader : m_readers)
+        QMetaObject::invokeMethod(reader, &DatabaseWorker::close, Qt::BlockingQueuedConnection);
+    QMetaObject::invokeMethod(m_writer, &DatabaseWorker::close, Qt::BlockingQueuedConnection);
+    for (QThread &thread : m_readerThreads) {
+        thread.quit();
+        thread.wait();
+    }
+    m_writerThread.quit();
+    m_writerThread.wait();
+    for (DatabaseWorker *reader : m_readers)
+        delete reader;
+    delete m_writer;
+}
+
+DatabaseWorker *TaskDataService::createWorker(QThread &thread, const QString &connectionName, ConnectionRole role)
+{
+    thread.setObjectName(connectionName);
+    auto *worker = new DatabaseWorker(connectionName, role, &m_latestPage, &m_blockEpoch);
+    worker->moveToThread(&thread);
+    connect(worker, &DatabaseWorker::statusesChanged, this, &TaskDataService::statusesChanged);
+    return worker;
+}
+
+void TaskDataService::open(const QString &path)
+{
+    m_path = path;
+    QMetaObject::invokeMethod(m_writer, [worker = m_writer, path]() { worker->open(path); }, Qt::QueuedConnection);
+}
+
+quint64 TaskDataService::requestPage(PageRequest request)
+{
+    request.generation = m_latestPage.fetch_add(1) + 1;
+    QMetaObject::invokeMethod(m_readers[PageReader], [worker = m_readers[PageReader], request]() { worker->fetchPage(request); }, Qt::QueuedConnection);
+    return request.generation;
+}
+
+void TaskDataService::requestBlock(PageRequest request)
+{
+    request.generation = m_blockEpoch.load();
+    QMetaObject::invokeMethod(m_readers[BlockReader], [worker = m_readers[BlockReader], request]() { worker->fetchBlock(request); }, Qt::QueuedConnection);
+}
+
+void TaskDataService::resetBlocks()
+{
+    m_blockEpoch.fetch_add(1);
+}
+
+void TaskDataService::loadDetails(int id)
+{
+    // Как экспорт: читатель видит правки, ещё лежавшие в журнале писателя
+    QMetaObject::invokeMethod(m_writer, [writer = m_writer, reader = m_readers[PageReader], id]() {
+        writer->flushWrites();
+        QMetaObject::invokeMethod(reader, [reader, id]() { reader->fetchDetails(id); }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void TaskDataService::addTask(const TaskRecord &task, int provisionalId)
+{
+    QMetaObject::invokeMethod(m_writer, [worker = m_writer, task, provisionalId]() { worker->addTask(task, provisionalId); },
+                              Qt::QueuedConnection);
+}
+
+void TaskDataService::updateTask(const TaskRecord &task)
+{
+    QMetaObject::invokeMethod(m_writer, [worker = m_writer, task]() { worker->updateTask(task); }, Qt::QueuedConnection);
+}
+
+void TaskDataService::setTasksStatus(const QVector<int> &ids, int statusId)
+{
+    QMetaObject::invokeMethod(m_writer, [worker = m_writer, ids, statusId]() { worker->setTasksStatus(ids, statusId); }, Qt::QueuedConnection);
+}
+
+void TaskDataService::softDeleteTasks(const QVector<int> &ids)
+{
+    QMetaObject::invokeMethod(m_writer, [worker = m_writer, ids]() { worker->softDeleteTasks(ids); }, Qt::QueuedConnection);
+}
+
+void TaskDataService::restoreTasks(const QVector<int> &ids)
+{
+    QMetaObject::invokeMethod(m_writer, [worker = m_writer, ids]() { worker->restoreTasks(ids); }, Qt::QueuedConnection);
+}
+
+void TaskDataService::hardDeleteTasks(const QVector<int> &ids)
+{
+    QMetaObject::invokeMethod(m_writer, [worker = m_writer, ids]() { worker->hardDeleteTasks(ids); }, Qt::QueuedConnection);
+}
+
+void TaskDataService::emptyTrash()
+{
+    QMetaObject::invokeMethod(m_writer, &DatabaseWorker::emptyTrash, Qt::QueuedConnection);
+}
+
+void TaskDataService::flushWrites()
+{
+    QMetaObject::invokeMethod(m_writer, &DatabaseWorker::flushWrites, Qt::QueuedConnection);
+}
+
+void TaskDataService::verifyCounters()
+{
+    QMetaObject::invokeMethod(m_writer, &DatabaseWorker::verifyCounters, Qt::QueuedConnection);
+}
+
+void TaskDataService::importTasks(const QString &path)
+{
+    m_importCancel.store(false);
+    QMetaObject::invokeMethod(m_writer, [worker = m_writer, path, cancel = &m_importCancel]() {
+        worker->importTasks(path, cancel);
+    }, Qt::QueuedConnection);
+}
+
+void TaskDataService::cancelImport()
+{
+    m_importCancel.store(true);
+}
+
+void TaskDataService::exportTasks(const QString &path, const PageRequest &request)
+{
+    m_exportCancel.store(false);
+    // Сначала писатель фиксирует журнал правок, и только потом экспорт встаёт в очередь
+    // читателя — выгрузка видит все правки, сделанные до неё
+    QMetaObject::invokeMethod(m_writer, [writer = m_writer, reader = m_readers[BulkReader], path, request, cancel = &m_exportCancel]() {
+        writer->flushWrites();
+        QMetaObject::invokeMethod(reader, [reader, path, request, cancel]() {
+            reader->exportTasks(path, request, cancel);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void TaskDataService::cancelExport()
+{
+    m_exportCancel.store(true);
+}
+
+void TaskDataService::backupNow()
+{
+    requestBackup(0);
+}
+
+void TaskDataService::requestBackup(qint64 minAgeMs)
+{
+    m_backupCancel.store(false);
+    // Как экспорт: копия снимается после фиксации журнала правок
+    QMetaObject::invokeMethod(m_writer, [writer = m_writer, reader = m_readers[BackupReader], minAgeMs,
+                                         keep = m_backupKeep, cancel = &m_backupCancel]() {
+        writer->flushWrites();
+        QMetaObject::invokeMethod(reader, [reader, minAgeMs, keep, cancel]() {
+            reader->backupDatabase(TaskBackup::defaultDirectory(), keep, minAgeMs, cancel);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void TaskDataService::cancelBackup()
+{
+    m_backupCancel.store(true);
+}
@@ -0,0 +1,115 @@
+#ifndef TASKDATASERVICE_H
+#define TASKDATASERVICE_H
+
+#include "DatabaseWorker.h"
+
+#include <QObject>
+#include <QThread>
+
+#include <atomic>
+
+class QTimer;
+
+// Асинхронный слой данных для GUI: запросы уходят в DatabaseWorker на фоновых потоках,
+// результаты возвращаются сигналами. Запросы страниц схлопываются — выполняется только
+// последний, более старые пропускаются или прерываются.
+//
+// Соединения с tracker.db (файл в режиме WAL, см. StorageProfile): один писатель — все записи
+// идут через него по очереди, он же делает checkpoint'ы — и пул читателей, по потоку на
+// соединение: страницы, блоки ленты и экспорт. Долгое чтение не задерживает запись и наоборот.
+//
+// Правки пишутся с отложенной фиксацией (см. DatabaseWorker): GUI показывает их сразу, в базу
+// они уходят пачкой. Экспорт, резервная копия и закрытие сначала фиксируют журнал правок.
+//
+// Резервные копии (TaskBackup) снимает отдельный читатель: долгое копирование большой базы не
+// задерживает ни страницы, ни экспорт. Плановая копия — раз в TRACKER_BACKUP_HOURS часов
+// (по умолчанию 24, 0 — не делать) в TaskBackup::defaultDirectory(), хранятся последние
+// TRACKER_BACKUP_KEEP (по умолчанию 7).
+class TaskDataService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TaskDataService(QObject *parent = nullptr);
+    // Дожидается выполнения уже поставленных записей (журнал правок фиксируется) и закрывает соединение
+    ~TaskDataService() override;
+
+    void open(const QString &path);
+    // Возвращает номер запроса; результат придёт в pageReady(), если не устареет раньше
+    quint64 requestPage(PageRequest request);
+    // Лента: блоки текущего поколения выполняются все по порядку; resetBlocks() объявляет
+    // все ранее запрошенные блоки устаревшими (новая сортировка/поиск).
+    void requestBlock(PageRequest request);
+    void resetBlocks();
+    // Полный текст "Описания" (страницы хранят только начало длинного, см. TaskPage::hasMoreDetails());
+    // итог — detailsReady()
+    void loadDetails(int id);
+    void addTask(const TaskRecord &task, int provisionalId = -1);
+    void updateTask(const TaskRecord &task);
+    // Массовые операции над набором id (выделение в таблице)
+    void setTasksStatus(const QVector<int> &ids, int statusId);
+    void softDeleteTasks(const QVector<int> &ids);
+    void restoreTasks(const QVector<int> &ids);
+    void hardDeleteTasks(const QVector<int> &ids);
+    // Удалить из корзины всё (порциями в потоке писателя); итог — trashPurged()
+    void emptyTrash();
+    // Зафиксировать журнал правок, не дожидаясь таймера
+    void flushWrites();
+    // Фоновая сверка счётчиков TASK_STATS с таблицей (один раз после запуска)
+    void verifyCounters();
+    // Потоковый импорт CSV/NDJSON в потоке БД; ход — importProgress(), итог — importFinished()
+    void importTasks(const QString &path);
+    void cancelImport();
+    // Потоковый экспорт списка (порядок и поиск — из request) в CSV/JSON/NDJSON
+    void exportTasks(const QString &path, const PageRequest &request);
+    void cancelExport();
+    // Резервная копия сейчас (вне расписания); ход — backupProgress(), итог — backupFinished()
+    void backupNow();
+    void cancelBackup();
+
+signals:
+    // Схема готова; открытие читателей уже стоит в их очередях — запросы страниц, блоков и
+    // экспорта отправлять не раньше этого сигнала (до него читатель их молча пропускает)
+    void opened(bool ok, const QString &error, const StatusRegistry &statuses);
+    void statusesChanged(const StatusRegistry &statuses);
+    void pageReady(const PageResult &result);
+    void blockReady(const PageResult &result);
+    void detailsReady(int id, const QString &details, bool ok, const QString &error);
+    void taskWritten(const WriteResult &result);
+    void writesFlushed(int written, int failed);
+    void countersRepaired();
+    void trashPurged(int rows);
+    // Базу изменил другой процесс (см. DatabaseWorker)
+    void externalChange();
+    void importProgress(qint64 rows, qint64 bytesRead, qint64 totalBytes);
+    void importFinished(const ImportResult &result);
+    void exportProgress(qint64 rows, qint64 expectedRows);
+    void exportFinished(const ExportResult &result);
+    void backupProgress(qint64 pages, qint64 totalPages);
+    // skipped — плановая проверка: свежая копия уже есть
+    void backupFinished(const BackupResult &result);
+
+private:
+    // Читатели пула по назначению
+    enum Reader { PageReader, BlockReader, BulkReader, BackupReader, ReaderCount };
+
+    DatabaseWorker *createWorker(QThread &thread, const QString &connectionName, ConnectionRole role);
+    // minAgeMs > 0 — плановая копия (см. DatabaseWorker::backupDatabase())
+    void requestBackup(qint64 minAgeMs);
+
+    QThread m_writerThread;
+    DatabaseWorker *m_writer;
+    QThread m_readerThreads[ReaderCount];
+    DatabaseWorker *m_readers[ReaderCount];
+    std::atomic<quint64> m_latestPage;
+    std::atomic<quint64> m_blockEpoch;
+    std::atomic<bool> m_importCancel;
+    std::atomic<bool> m_exportCancel;
+    std::atomic<bool> m_backupCancel;
+    QTimer *m_backupTimer;
+    int m_backupHours;
+    int m_backupKeep;
+    QString m_path;
+};
+
+#endif // TASKDATASERVICE_H
@@ -0,0 +1,403 @@
+#include "TaskExporter.h"
+#include "Trace.h"
+
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVector>
+
+#include <cstring>
+#include <memory>
+
+#ifdef TRACKER_HAVE_SQLITE_API
+#include <sqlite3.h>
+#endif
+
+namespace {
+// Размер буфера вывода: запись в файл крупными кусками
+constexpr int WriteBufferBytes = 1024 * 1024;
+// Строк между проверками отмены и отчётами о прогрессе
+constexpr int BatchRows = 10000;
+
+enum { ColumnCount = 6 };
+const char *const FieldNames[ColumnCount] = { "id", "description", "details", "status", "creation_dt", "completion_dt" };
+// Столбцы запроса (TaskRepository::listQuery()): после выгружаемых — сжатый полный текст "Описания"
+enum { DetailsColumn = 2, BodyColumn = ColumnCount, QueryColumnCount = ColumnCount + 1 };
+
+// Значение столбца: байты UTF-8 без копирования; data == nullptr — NULL
+struct Cell {
+    const char *data = nullptr;
+    int size = 0;
+};
+
+// Источник строк: либо sqlite3_stmt напрямую, либо QSqlQuery
+class RowSource
+{
+public:
+    virtual ~RowSource() = default;
+    virtual bool next() = 0;
+    virtual Cell cell(int column) = 0;
+    virtual QString error() const = 0;
+};
+
+#ifdef TRACKER_HAVE_SQLITE_API
+class SqliteRowSource : public RowSource
+{
+public:
+    SqliteRowSource(sqlite3 *handle, const QString &sql, const QString &match)
+        : m_handle(handle), m_stmt(nullptr), m_failed(false)
+    {
+        const QByteArray sqlUtf8 = sql.toUtf8();
+        if (sqlite3_prepare_v2(handle, sqlUtf8.constData(), sqlUtf8.size(), &m_stmt, nullptr) != SQLITE_OK) {
+            m_error = QString::fromUtf8(sqlite3_errmsg(handle));
+            m_failed = true;
+            return;
+        }
+        const int matchIndex = sqlite3_bind_parameter_index(m_stmt, ":match");
+        if (matchIndex > 0) {
+            const QByteArray matchUtf8 = match.toUtf8();
+            sqlite3_bind_text(m_stmt, matchIndex, matchUtf8.constData(), matchUtf8.size(), SQLITE_TRANSIENT);
+        }
+    }
+    ~SqliteRowSource() override { sqlite3_finalize(m_stmt); }
+
+    bool next() override
+    {
+        if (m_failed)
+            return false;
+        const int rc = sqlite3_step(m_stmt);
+        if (rc == SQLITE_ROW)
+            return true;
+        if (rc != SQLITE_DONE) {
+            m_error = QString::fromUtf8(sqlite3_errmsg(m_handle));
+            m_failed = true;
+        }
+        return false;
+    }
+    Cell cell(int column) override
+    {
+        Cell c;
+        if (sqlite3_column_type(m_stmt, column) == SQLITE_NULL)
+            return c;
+        c.data = reinterpret_cast<const char *>(sqlite3_column_text(m_stmt, column));
+        c.size = sqlite3_column_bytes(m_stmt, column);
+        return c;
+    }
+    QString error() const override { return m_failed ? m_error : QString(); }
+
+private:
+    sqlite3 *m_handle;
+    sqlite3_stmt *m_stmt;
+    bool m_failed;
+    QString m_error;
+};
+#endif
+
+// Запасной путь без SQLite C API: QVariant → UTF-8 на каждую ячейку
+class QtRowSource : public RowSource
+{
+public:
+    QtRowSource(const QSqlDatabase &db, const QString &sql, const QString &match)
+        : m_query(db), m_failed(false)
+    {
+        m_query.setForwardOnly(true);
+        m_query.prepare(sql);
+        if (sql.contains(QLatin1String(":match")))
+            m_query.bindValue(":match", match);
+        if (!m_query.exec())
+            m_failed = true;
+    }
+    bool next() override { return !m_failed && m_query.next(); }
+    Cell cell(int column) override
+    {
+        Cell c;
+        const QVariant v = m_query.value(column);
+        if (v.isNull())
+            return c;
+        // BLOB (сжатое "Описание") — байты как есть
+        m_cells[column] = (v.typeId() == QMetaType::QByteArray) ? v.toByteArray() : v.toString().toUtf8();
+        c.data = m_cells[column].constData();
+        c.size = int(m_cells[column].size());
+        return c;
+    }
+    QString error() const override { return m_query.lastError().isValid() ? m_query.lastError().text() : QString(); }
+
+private:
+    QSqlQuery m_query;
+    bool m_failed;
+    QByteArray m_cells[QueryColumnCount];
+};
+
+// "Описание", хранящееся сжатым (см. TaskRepository::DetailsCompressChars), — распакованным.
+// В TASK_DETAILS.body сжат UTF-8, поэтому распакованные байты выгружаются без перекодирования.
+class DetailsRowSource : public RowSource
+{
+public:
+    explicit DetailsRowSource(std::unique_ptr<RowSource> rows)
+        : m_rows(std::move(rows)), m_expanded(false)
+    {
+    }
+    bool next() override
+    {
+        m_expanded = false;
+        return m_rows->next();
+    }
+    Cell cell(int column) override
+    {
+        if (column != DetailsColumn)
+            return m_rows->cell(column);
+        if (!m_expanded) {
+            const Cell body = m_rows->cell(BodyColumn);
+            m_details = body.data ? qUncompress(reinterpret_cast<const uchar *>(body.data), body.size) : QByteArray();
+            m_expanded = true;
+        }
+        if (m_details.isNull())
+            return m_rows->cell(column);
+        Cell c;
+        c.data = m_details.constData();
+        c.size = int(m_details.size());
+        return c;
+    }
+    QString error() const override { return m_rows->error(); }
+
+private:
+    std::unique_ptr<RowSource> m_rows;
+    bool m_expanded;       // m_details относится к текущей строке
+    QByteArray m_details;  // null — текст не сжат, details из TASK
+};
+
+// Буфер вывода поверх файла
+class BufferedWriter
+{
+public:
+    explicit BufferedWriter(QIODevice &device)
+        : m_device(device), m_written(0), m_failed(false)
+    {
+        m_buffer.reserve(WriteBufferBytes);
+    }
+
+    void append(const char *data, qsizetype size)
+    {
+        if (m_buffer.size() + size > WriteBufferBytes)
+            flush();
+        m_buffer.append(data, size);
+    }
+    void append(char c)
+    {
+        if (m_buffer.size() + 1 > WriteBufferBytes)
+            flush();
+        m_buffer.append(c);
+    }
+    void append(const char *text) { append(text, qsizetype(std::strlen(text))); }
+
+    bool flush()
+    {
+        if (!m_buffer.isEmpty() && !m_failed) {
+            if (m_device.write(m_buffer) != m_buffer.size())
+                m_failed = true;
+            m_written += m_buffer.size();
+        }
+        m_buffer.clear(); // ёмкость сохраняется
+        return !m_failed;
+    }
+    qint64 written() const { return m_written + m_buffer.size(); }
+    bool failed() const { return m_failed; }
+
+private:
+    QIODevice &m_device;
+    QByteArray m_buffer;
+    qint64 m_written;
+    bool m_failed;
+};
+
+// CSV: поле в кавычках, только если в нём есть разделитель, кавычка или перевод строки
+void writeCsvField(BufferedWriter &out, const Cell &cell)
+{
+    if (!cell.data)
+        return;
+    bool needsQuotes = false;
+    for (int i = 0; i < cell.size && !needsQuotes; ++i) {
+        const char c = cell.data[i];
+        needsQuotes = (c == ',' || c == '"' || c == '\n' || c == '\r');
+    }
+    if (!needsQuotes) {
+        out.append(cell.data, cell.size);
+        return;
+    }
+    out.append('"');
+    int start = 0;
+    for (int i = 0; i < cell.size; ++i) {
+        if (cell.data[i] == '"') {
+            out.append(cell.data + start, i - start + 1);
+            out.append('"');
+            start = i + 1;
+        }
+    }
+    out.append(cell.data + start, cell.size - start);
+    out.append('"');
+}
+
+// JSON-строка: экранируются только кавычка, обратная косая черта и управляющие символы;
+// многобайтовые последовательности UTF-8 копируются как есть
+void writeJsonString(BufferedWriter &out, const Cell &cell)
+{
+    if (!cell.data) {
+        out.append("null");
+        return;
+    }
+    static const char hex[] = "0123456789abcdef";
+    out.append('"');
+    int start = 0;
+    for (int i = 0; i < cell.size; ++i) {
+        const unsigned char c = static_cast<unsigned char>(cell.data[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        out.append(cell.data + start, i - start);
+        start = i + 1;
+        switch (c) {
+            case '"': out.append("\\\"", 2); break;
+            case '\\': out.append("\\\\", 2); break;
+            case '\n': out.append("\\n", 2); break;
+            case '\r': out.append("\\r", 2); break;
+            case '\t': out.append("\\t", 2); break;
+            default: {
+                const char escaped[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+                out.append(escaped, 6);
+                break;
+            }
+        }
+    }
+    out.append(cell.data + start, cell.size - start);
+    out.append('"');
+}
+
+void writeJsonObject(BufferedWriter &out, RowSource &rows)
+{
+    out.append('{');
+    for (int column = 0; column < ColumnCount; ++column) {
+        if (column > 0)
+            out.append(',');
+        out.append('"');
+        out.append(FieldNames[column]);
+        out.append("\":", 2);
+        const Cell cell = rows.cell(column);
+        if (column == 0 && cell.data)
+            out.append(cell.data, cell.size); // id — число
+        else
+            writeJsonString(out, cell);
+    }
+    out.append('}');
+}
+}
+
+TaskExporter::TaskExporter(TaskRepository &repository)
+    : m_repository(repository)
+{
+}
+
+TaskExporter::Format TaskExporter::formatForPath(const QString &path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == QLatin1String("json"))
+        return Json;
+    if (suffix == QLatin1String("ndjson") || suffix == QLatin1String("jsonl"))
+        return NdJson;
+    return Csv;
+}
+
+ExportResult TaskExporter::exportToFile(const QString &path, const PageRequest &request)
+{
+    TraceSpan span("db.export");
+    ExportResult result;
+    const Format format = formatForPath(path);
+
+    // Ожидаемое число строк — для прогресса (счётчики TASK_STATS, O(1)); при поиске и фильтре
+    // по дате заранее неизвестно
+    qint64 expected = 0;
+    if (request.search.trimmed().isEmpty() && !TaskRepository::hasDateFilter(request)) {
+        const TaskCounts counts = m_repository.counts();
+        expected = request.trash ? counts.deleted : counts.live;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        result.error = file.errorString();
+        return result;
+    }
+
+    const QString sql = TaskRepository::listQuery(request);
+    const QString match = TaskRepository::ftsMatchExpression(request.search);
+    std::unique_ptr<RowSource> rows;
+#ifdef TRACKER_HAVE_SQLITE_API
+    if (sqlite3 *handle = m_repository.handle())
+        rows = std::make_unique<SqliteRowSource>(handle, sql, match);
+#endif
+    if (!rows)
+        rows = std::make_unique<QtRowSource>(m_repository.database(), sql, match);
+    rows = std::make_unique<DetailsRowSource>(std::move(rows));
+
+    BufferedWriter out(file);
+    if (format == Csv) {
+        for (int column = 0; column < ColumnCount; ++column) {
+            if (column > 0)
+                out.append(',');
+            out.append(FieldNames[column]);
+        }
+        out.append('\n');
+    } else if (format == Json) {
+        out.append('[');
+    }
+
+    while (rows->next()) {
+        if (format == Csv) {
+            for (int column = 0; column < ColumnCount; ++column) {
+                if (column > 0)
+                    out.append(',');
+                writeCsvField(out, rows->cell(column));
+            }
+            out.append('\n');
+        } else {
+            if (format == Json && result.rows > 0)
+                out.append(',');
+            if (format == Json)
+                out.append('\n');
+            writeJsonObject(out, *rows);
+            if (format == NdJson)
+                out.append('\n');
+        }
+        ++result.rows;
+
+        if (result.rows % BatchRows == 0) {
+            if (m_progress)
+                m_progress(result.rows, expected);
+            if (m_isCancelled && m_isCancelled()) {
+                file.cancelWriting();
+                result.cancelled = true;
+                return result;
+            }
+            if (out.failed())
+                break;
+        }
+    }
+    if (format == Json)
+        out.append("\n]\n");
+
+    result.error = rows->error();
+    if (!out.flush() && result.error.isEmpty())
+        result.error = file.errorString();
+    if (!result.error.isEmpty()) {
+        file.cancelWriting();
+        return result;
+    }
+    if (!file.commit()) {
+        result.error = file.errorString();
+        return result;
+    }
+    result.bytes = out.written();
+    result.ok = true;
+    span.setRows(result.rows);
+    if (m_progress)
+        m_progress(result.rows, result.rows);
+    return result;
+}
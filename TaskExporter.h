@@ -0,0 +1,53 @@
+#ifndef TASKEXPORTER_H
+#define TASKEXPORTER_H
+
+#include "TaskRepository.h"
+
+#include <QMetaType>
+#include <QString>
+
+#include <functional>
+
+// Итог экспорта
+struct ExportResult {
+    qint64 rows = 0;
+    qint64 bytes = 0;
+    bool ok = false;
+    bool cancelled = false; // отменён; файл не создан (QSaveFile)
+    QString error;
+};
+
+// Потоковая выгрузка задач в CSV, JSON (массив объектов) или NDJSON.
+// Выгружается весь список в текущем порядке (TaskRepository::listQuery). Строки идут из
+// SQLite прямо в буфер вывода: с SQLite C API — из буферов столбцов sqlite3_column_text()
+// без QVariant/QString, иначе — через QSqlQuery. Память не зависит от размера таблицы.
+// Файл появляется только после успешного завершения. Вызывается в потоке репозитория.
+//
+// Поля: id, description, details, status, creation_dt, completion_dt — те же имена понимает
+// TaskImporter.
+class TaskExporter
+{
+public:
+    enum Format { Csv, Json, NdJson };
+
+    explicit TaskExporter(TaskRepository &repository);
+
+    // По расширению: .json — JSON, .ndjson/.jsonl — NDJSON, иначе CSV
+    static Format formatForPath(const QString &path);
+
+    // Вызывается раз в пачку строк: выгружено строк, всего ожидается (0 — неизвестно)
+    void setProgressCallback(std::function<void(qint64, qint64)> callback) { m_progress = std::move(callback); }
+    void setCancelCheck(std::function<bool()> isCancelled) { m_isCancelled = std::move(isCancelled); }
+
+    // request — сортировка и поиск, как у видимых страниц
+    ExportResult exportToFile(const QString &path, const PageRequest &request);
+
+private:
+    TaskRepository &m_repository;
+    std::function<void(qint64, qint64)> m_progress;
+    std::function<bool()> m_isCancelled;
+};
+
+Q_DECLARE_METATYPE(ExportResult)
+
+#endif // TASKEXPORTER_H
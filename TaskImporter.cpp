@@ -0,0 +1,371 @@
+#include "TaskImporter.h"
+#include "TaskRepository.h"
+#include "TimestampFormat.h"
+#include "Trace.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTextStream>
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+// Строк между проверками отмены и отчётами о прогрессе
+constexpr int BatchRows = 5000;
+// Размер куска входа в символах
+constexpr qint64 ChunkChars = 256 * 1024;
+// Кэш страниц на время импорта (КиБ, отрицательное значение для PRAGMA cache_size):
+// изменённые страницы индексов не вытесняются в журнал посреди большой транзакции
+constexpr int ImportCacheKiB = 64 * 1024;
+
+// Поля одной импортируемой задачи; null — значение не задано
+struct ImportRow {
+    QString description;
+    QString details;
+    QString status;
+    QString creationDt;
+    QString completionDt;
+};
+
+enum ImportField { F_DESC, F_DETAILS, F_STATUS, F_CREATED, F_COMPLETED, F_COUNT };
+
+// Имя столбца CSV / ключа NDJSON → поле. Русские заголовки — как в таблице приложения.
+int fieldForName(const QString &name)
+{
+    static const QHash<QString, int> fields = {
+        { QStringLiteral("description"), F_DESC }, { QStringLiteral("задание"), F_DESC },
+        { QStringLiteral("details"), F_DETAILS }, { QStringLiteral("описание"), F_DETAILS },
+        { QStringLiteral("status"), F_STATUS }, { QStringLiteral("статус"), F_STATUS },
+        { QStringLiteral("creation_dt"), F_CREATED }, { QStringLiteral("дата создания"), F_CREATED },
+        { QStringLiteral("completion_dt"), F_COMPLETED }, { QStringLiteral("дата выполнения"), F_COMPLETED }
+    };
+    return fields.value(name.trimmed().toLower(), -1);
+}
+
+// Дата из NDJSON как текст для TimestampFormat::parse(): число — миллисекунды от эпохи
+QString jsonDateText(const QJsonValue &value)
+{
+    return value.isDouble() ? QString::number(qint64(value.toDouble())) : value.toString();
+}
+
+// Потоковый разбор CSV (RFC 4180): поля в кавычках, "" внутри кавычек, переводы строк в полях.
+// Обычные символы копируются в поле отрезками, а не по одному.
+class CsvReader
+{
+public:
+    explicit CsvReader(QIODevice &device)
+        : m_stream(&device)
+        , m_pos(0)
+        , m_delimiter(QLatin1Char(','))
+    {
+        m_stream.setEncoding(QStringConverter::Utf8);
+    }
+
+    void setDelimiter(QChar delimiter) { m_delimiter = delimiter; }
+
+    // false — вход закончился
+    bool readRecord(QStringList &fields)
+    {
+        fields.clear();
+        QString field;
+        bool quoted = false;
+        bool started = false;
+        while (true) {
+            if (m_pos >= m_buffer.size() && !fill()) {
+                if (!started)
+                    return false;
+                fields << field;
+                return true;
+            }
+            started = true;
+            const QChar c = m_buffer[m_pos];
+            if (quoted) {
+                if (c == QLatin1Char('"')) {
+                    ++m_pos;
+                    if (m_pos >= m_buffer.size())
+                        fill();
+                    if (m_pos < m_buffer.size() && m_buffer[m_pos] == QLatin1Char('"')) {
+                        field += QLatin1Char('"');
+                        ++m_pos;
+                    } else {
+                        quoted = false;
+                    }
+                } else {
+                    appendRun(field, [](QChar ch) { return ch == QLatin1Char('"'); });
+                }
+            } else if (c == QLatin1Char('"') && field.isEmpty()) {
+                quoted = true;
+                ++m_pos;
+            } else if (c == m_delimiter) {
+                fields << field;
+                field.clear();
+                ++m_pos;
+            } else if (c == QLatin1Char('\n')) {
+                fields << field;
+                ++m_pos;
+                return true;
+            } else if (c == QLatin1Char('\r')) {
+                ++m_pos; // \r\n — перевод строки обработает \n
+            } else {
+                const QChar delimiter = m_delimiter;
+                appendRun(field, [delimiter](QChar ch) {
+                    return ch == delimiter || ch == QLatin1Char('\n') || ch == QLatin1Char('\r');
+                });
+            }
+        }
+    }
+
+private:
+    bool fill()
+    {
+        m_buffer = m_stream.read(ChunkChars);
+        m_pos = 0;
+        return !m_buffer.isEmpty();
+    }
+
+    template <typename Stop>
+    void appendRun(QString &field, Stop isStop)
+    {
+        const qsizetype start = m_pos;
+        while (m_pos < m_buffer.size() && !isStop(m_buffer[m_pos]))
+            ++m_pos;
+        field.append(QStringView(m_buffer).mid(start, m_pos - start));
+    }
+
+    QTextStream m_stream;
+    QString m_buffer;
+    qsizetype m_pos;
+    QChar m_delimiter;
+};
+
+// Настройки соединения на время импорта; прежние значения возвращаются в деструкторе
+class ImportTuning
+{
+public:
+    explicit ImportTuning(const QSqlDatabase &db)
+        : m_db(db)
+    {
+        QSqlQuery q(m_db);
+        if (q.exec("PRAGMA cache_size") && q.next())
+            m_cacheSize = q.value(0);
+        q.exec(QString("PRAGMA cache_size = %1").arg(-ImportCacheKiB));
+    }
+    ~ImportTuning()
+    {
+        if (m_cacheSize.isValid())
+            QSqlQuery(m_db).exec(QString("PRAGMA cache_size = %1").arg(m_cacheSize.toInt()));
+    }
+
+private:
+    QSqlDatabase m_db;
+    QVariant m_cacheSize;
+};
+}
+
+TaskImporter::TaskImporter(TaskRepository &repository)
+    : m_repository(repository)
+{
+}
+
+TaskImporter::Format TaskImporter::formatForPath(const QString &path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    return (suffix == QLatin1String("ndjson") || suffix == QLatin1String("jsonl")) ? NdJson : Csv;
+}
+
+ImportResult TaskImporter::importFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        ImportResult result;
+        result.error = file.errorString();
+        return result;
+    }
+    return import(file, formatForPath(path));
+}
+
+ImportResult TaskImporter::import(QIODevice &device, Format format)
+{
+    TraceSpan span("db.import");
+    ImportResult result;
+    QSqlDatabase db = m_repository.database();
+    const StatusRegistry &statuses = m_repository.statuses();
+    const int plannedId = qMax(1, statuses.id(StatusRegistry::plannedName()));
+    const int doneId = m_repository.doneStatusId();
+    const qint64 totalBytes = device.isSequential() ? 0 : device.size();
+    // Одна метка времени на весь импорт для строк без даты создания (или с неразборчивой)
+    const qint64 now = TimestampFormat::now();
+
+    ImportTuning tuning(db);
+    if (!db.transaction()) {
+        result.error = db.lastError().text();
+        return result;
+    }
+
+    QSqlQuery insert(db);
+    if (!insert.prepare("INSERT INTO TASK (description, details, creation_dt, completion_dt, status_id, is_deleted) "
+                        "VALUES (?, ?, ?, ?, ?, 0)")) {
+        result.error = insert.lastError().text();
+        db.rollback();
+        return result;
+    }
+
+    auto insertRow = [&](const ImportRow &row) {
+        const QString description = row.description.trimmed();
+        if (description.isEmpty()) {
+            ++result.skipped;
+            return true;
+        }
+        int statusId = plannedId;
+        if (!row.status.trimmed().isEmpty()) {
+            statusId = statuses.id(row.status.trimmed());
+            if (statusId == -1) {
+                statusId = plannedId;
+                ++result.unknownStatus;
+            }
+        }
+        qint64 created = now;
+        TimestampFormat::parse(row.creationDt, &created);
+        // Как в TaskRepository::insertTask(): дата выполнения только у "Сделано"
+        QVariant completed;
+        if (statusId == doneId) {
+            qint64 completedMs = created;
+            TimestampFormat::parse(row.completionDt, &completedMs);
+            completed = completedMs;
+        }
+
+        insert.bindValue(0, description);
+        insert.bindValue(1, row.details.isEmpty() ? QVariant() : QVariant(row.details));
+        insert.bindValue(2, created);
+        insert.bindValue(3, completed);
+        insert.bindValue(4, statusId);
+        if (!insert.exec()) {
+            result.error = insert.lastError().text();
+            return false;
+        }
+        ++result.imported;
+        return true;
+    };
+
+    // Граница пачки: прогресс и проверка отмены
+    qint64 rowsInBatch = 0;
+    auto batchDone = [&]() {
+        if (++rowsInBatch < BatchRows)
+            return true;
+        rowsInBatch = 0;
+        if (m_progress)
+            m_progress(result.imported, device.pos(), totalBytes);
+        return !(m_isCancelled && m_isCancelled());
+    };
+
+    bool ok = true;
+    bool cancelled = false;
+    if (format == Csv) {
+        CsvReader reader(device);
+        QStringList header;
+        if (!reader.readRecord(header)) {
+            result.error = QStringLiteral("Пустой файл");
+            db.rollback();
+            return result;
+        }
+        if (header.size() == 1 && header.first().contains(QLatin1Char(';'))) {
+            header = header.first().split(QLatin1Char(';'));
+            reader.setDelimiter(QLatin1Char(';'));
+        }
+        int columns[F_COUNT];
+        std::fill(std::begin(columns), std::end(columns), -1);
+        for (int i = 0; i < header.size(); ++i) {
+            const int field = fieldForName(header[i]);
+            if (field >= 0 && columns[field] < 0)
+                columns[field] = i;
+        }
+        if (columns[F_DESC] < 0) {
+            result.error = QStringLiteral("В заголовке CSV нет столбца description");
+            db.rollback();
+            return result;
+        }
+
+        QStringList record;
+        ImportRow row;
+        auto value = [&record, &columns](int field) {
+            const int i = columns[field];
+            return (i >= 0 && i < record.size()) ? record[i] : QString();
+        };
+        while (ok && reader.readRecord(record)) {
+            if (record.size() == 1 && record.first().isEmpty())
+                continue; // пустая строка
+            row.description = value(F_DESC);
+            row.details = value(F_DETAILS);
+            row.status = value(F_STATUS);
+            row.creationDt = value(F_CREATED);
+            row.completionDt = value(F_COMPLETED);
+            ok = insertRow(row);
+            if (ok && !batchDone()) {
+                cancelled = true;
+                break;
+            }
+        }
+    } else {
+        ImportRow row;
+        while (ok && !device.atEnd()) {
+            const QByteArray line = device.readLine().trimmed();
+            if (line.isEmpty())
+                continue;
+            QJsonParseError parseError;
+            const QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+            if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+                ++result.skipped;
+                continue;
+            }
+            row = ImportRow();
+            const QJsonObject object = doc.object();
+            for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+                if (it.value().isNull())
+                    continue;
+                switch (fieldForName(it.key())) {
+                    case F_DESC: row.description = it.value().toString(); break;
+                    case F_DETAILS: row.details = it.value().toString(); break;
+                    case F_STATUS: row.status = it.value().toString(); break;
+                    // Дата — строка ISO 8601 или число миллисекунд
+                    case F_CREATED: row.creationDt = jsonDateText(it.value()); break;
+                    case F_COMPLETED: row.completionDt = jsonDateText(it.value()); break;
+                    default: break;
+                }
+            }
+            ok = insertRow(row);
+            if (ok && !batchDone()) {
+                cancelled = true;
+                break;
+            }
+        }
+    }
+
+    if (!ok || cancelled) {
+        // Откат целиком: вставки, счётчики TASK_STATS и индекс поиска (триггеры) — в той же транзакции
+        db.rollback();
+        result.cancelled = cancelled;
+        result.imported = 0;
+        if (!ok)
+            qWarning() << "Import failed:" << result.error;
+        return result;
+    }
+    if (!db.commit()) {
+        result.error = db.lastError().text();
+        db.rollback();
+        result.imported = 0;
+        return result;
+    }
+    if (m_progress)
+        m_progress(result.imported, totalBytes, totalBytes);
+    result.ok = true;
+    span.setRows(result.imported);
+    return result;
+}
@@ -0,0 +1,59 @@
+#ifndef TASKIMPORTER_H
+#define TASKIMPORTER_H
+
+#include <QMetaType>
+#include <QString>
+
+#include <functional>
+
+class QIODevice;
+class TaskRepository;
+
+// Итог импорта
+struct ImportResult {
+    qint64 imported = 0;      // вставлено строк
+    qint64 skipped = 0;       // пропущено (пустое задание, битая строка NDJSON)
+    qint64 unknownStatus = 0; // статус не найден в справочнике — записаны как "Запланировано"
+    bool ok = false;
+    bool cancelled = false;   // отменён пользователем; транзакция откачена
+    QString error;
+};
+
+// Потоковый импорт задач из CSV или NDJSON в TASK.
+// Вход читается кусками (память не зависит от размера файла), статусы сопоставляются по
+// справочнику в памяти, вставка идёт одним переиспользуемым подготовленным запросом.
+// Весь импорт — одна транзакция: при ошибке или отмене база остаётся как была.
+// Работает на соединении репозитория, поэтому вызывается в его потоке (DatabaseWorker).
+//
+// CSV: первая строка — заголовок; разделитель "," или ";" (определяется по заголовку),
+// поля в кавычках могут содержать разделители и переводы строк.
+// Столбцы/ключи NDJSON: description, details, status, creation_dt, completion_dt —
+// обязателен только description. Даты — ISO 8601, "yyyy-MM-dd HH:mm:ss" (локальное время)
+// или миллисекунды от эпохи (см. TimestampFormat::parse()).
+class TaskImporter
+{
+public:
+    enum Format { Csv, NdJson };
+
+    explicit TaskImporter(TaskRepository &repository);
+
+    // По расширению: .ndjson/.jsonl — NDJSON, иначе CSV
+    static Format formatForPath(const QString &path);
+
+    // Вызывается после каждой пачки строк: строк вставлено, байт прочитано, всего байт (0 — неизвестно)
+    void setProgressCallback(std::function<void(qint64, qint64, qint64)> callback) { m_progress = std::move(callback); }
+    // Проверяется между пачками; true — откатить и остановиться
+    void setCancelCheck(std::function<bool()> isCancelled) { m_isCancelled = std::move(isCancelled); }
+
+    ImportResult importFile(const QString &path);
+    ImportResult import(QIODevice &device, Format format);
+
+private:
+    TaskRepository &m_repository;
+    std::function<void(qint64, qint64, qint64)> m_progress;
+    std::function<bool()> m_isCancelled;
+};
+
+Q_DECLARE_METATYPE(ImportResult)
+
+#endif // TASKIMPORTER_H
@@ -0,0 +1,347 @@
+#include "TaskPage.h"
+#include "TimestampFormat.h"
+
+#include <QSqlQuery>
+#include <QSqlRecord>
+
+#include <algorithm>
+
+namespace {
+// Размер блока арены в символах (64 КБ). Длинный текст получает собственный блок.
+constexpr qsizetype ArenaChunkSize = 32 * 1024;
+// Как часто appendFromQuery() спрашивает, не устарел ли запрос
+constexpr int CancelCheckInterval = 64;
+
+// Поля запроса страницы (порядок как у TaskTableModel::Column)
+enum QueryField {
+    FIELD_ID = 0,
+    FIELD_STATUS_NAME = 5,
+    FIELD_IS_DELETED = 6
+};
+}
+
+TaskPage::TaskPage()
+    : m_chunkUsed(0)
+    , m_chunkCapacity(0)
+{
+}
+
+bool TaskPage::appendFromQuery(QSqlQuery &query, const std::function<bool()> &isCancelled)
+{
+    const QSqlRecord record = query.record();
+    const int statusIdField = record.indexOf(QStringLiteral("status_id"));
+    const int descHighlightField = record.indexOf(QStringLiteral("desc_hl"));
+    const int detailsHighlightField = record.indexOf(QStringLiteral("details_hl"));
+    const int detailsMoreField = record.indexOf(QStringLiteral("details_more"));
+    const bool withHighlight = descHighlightField >= 0 && detailsHighlightField >= 0;
+    static const int textColumns[TEXT_COLUMNS] = { TEXT_DESC, TEXT_DETAILS };
+    static const int dateColumns[DATE_COLUMNS] = { TEXT_CREATION_DT, TEXT_COMPLETION_DT };
+
+    int fetched = 0;
+    while (query.next()) {
+        if (isCancelled && (++fetched % CancelCheckInterval) == 0 && isCancelled())
+            return false;
+
+        m_ids.append(query.value(FIELD_ID).toInt());
+        for (int column : textColumns) {
+            const QVariant v = query.value(column);
+            m_text.append(v.isNull() ? TextSpan() : store(v.toString()));
+        }
+        for (int column : dateColumns) {
+            const QVariant v = query.value(column);
+            m_dates.append(v.isNull() ? TimestampFormat::Null : v.toLongLong());
+        }
+        if (withHighlight) {
+            // Выравниваем по числу строк: страница может дописываться из разных запросов
+            m_highlight.resize((m_ids.size() - 1) * 2);
+            for (int field : { descHighlightField, detailsHighlightField }) {
+                const QVariant v = query.value(field);
+                m_highlight.append(v.isNull() ? TextSpan() : store(v.toString()));
+            }
+        }
+
+        const int statusId = statusIdField >= 0 ? query.value(statusIdField).toInt() : 0;
+        m_statusIds.append(statusId);
+        if (!m_statusNames.contains(statusId))
+            m_statusNames.insert(statusId, query.value(FIELD_STATUS_NAME).toString());
+
+        m_deleted.append(quint8(query.value(FIELD_IS_DELETED).toInt()));
+        if (detailsMoreField >= 0 && query.value(detailsMoreField).toInt() != 0) {
+            m_detailsMore.resize(m_ids.size());
+            m_detailsMore.last() = 1;
+        }
+    }
+    return true;
+}
+
+int TaskPage::taskId(int row) const
+{
+    return (row >= 0 && row < m_ids.size()) ? m_ids[row] : -1;
+}
+
+int TaskPage::statusId(int row) const
+{
+    return (row >= 0 && row < m_statusIds.size()) ? m_statusIds[row] : -1;
+}
+
+bool TaskPage::isDeleted(int row) const
+{
+    return (row >= 0 && row < m_deleted.size()) && m_deleted[row] != 0;
+}
+
+bool TaskPage::isRemoved(int row) const
+{
+    return (row >= 0 && row < m_removed.size()) && m_removed[row] != 0;
+}
+
+int TaskPage::rowForId(int id) const
+{
+    return int(m_ids.indexOf(id));
+}
+
+bool TaskPage::hasMoreDetails(int row) const
+{
+    return (row >= 0 && row < m_detailsMore.size()) && m_detailsMore[row] != 0;
+}
+
+bool TaskPage::isNull(int row, int column) const
+{
+    if (row < 0 || row >= m_ids.size())
+        return true;
+    if (dateSlot(column) >= 0)
+        return dateMs(row, column) == TimestampFormat::Null;
+    if (textSlot(column) < 0)
+        return true;
+    return span(row, column).size < 0;
+}
+
+QStringView TaskPage::textView(int row, int column) const
+{
+    if (row < 0 || row >= m_ids.size() || textSlot(column) < 0)
+        return QStringView();
+    const TextSpan &s = span(row, column);
+    return s.size <= 0 ? QStringView() : QStringView(s.data, s.size);
+}
+
+QString TaskPage::text(int row, int column) const
+{
+    if (isNull(row, column))
+        return QString();
+    if (dateSlot(column) >= 0)
+        return TimestampFormat::toDisplay(dateMs(row, column));
+    return textView(row, column).toString();
+}
+
+qint64 TaskPage::dateMs(int row, int column) const
+{
+    const int slot = dateSlot(column);
+    if (row < 0 || row >= m_ids.size() || slot < 0)
+        return TimestampFormat::Null;
+    return m_dates[qsizetype(row) * DATE_COLUMNS + slot];
+}
+
+bool TaskPage::hasHighlight(int row, int column) const
+{
+    const int slot = (column == TEXT_DESC) ? 0 : (column == TEXT_DETAILS) ? 1 : -1;
+    const qsizetype i = qsizetype(row) * 2 + slot;
+    return slot >= 0 && row >= 0 && i < m_highlight.size() && m_highlight[i].size >= 0;
+}
+
+QStringView TaskPage::highlightView(int row, int column) const
+{
+    if (!hasHighlight(row, column))
+        return QStringView();
+    const TextSpan &s = m_highlight[qsizetype(row) * 2 + (column == TEXT_DESC ? 0 : 1)];
+    return s.size <= 0 ? QStringView() : QStringView(s.data, s.size);
+}
+
+QString TaskPage::statusName(int row) const
+{
+    return (row >= 0 && row < m_statusIds.size()) ? m_statusNames.value(m_statusIds[row]) : QString();
+}
+
+void TaskPage::setTask(int row, const QString &description, const QString &details,
+                       const QVariant &completionDt, int statusId, const QString &statusName)
+{
+    if (row < 0 || row >= m_ids.size())
+        return;
+
+    // Текст из диалога — полный. Если это лишь хранимое начало (вызов не с тем текстом),
+    // отметка остаётся: худшее, что будет, — лишнее чтение полного текста из базы.
+    if (row < m_detailsMore.size() && m_detailsMore[row] && details != textView(row, TEXT_DETAILS))
+        m_detailsMore[row] = 0;
+    TextSpan *spans = m_text.data() + row * TEXT_COLUMNS;
+    spans[textSlot(TEXT_DESC)] = store(description);
+    spans[textSlot(TEXT_DETAILS)] = store(details);
+    // Подсветка относилась к старому тексту — дальше показываем обычный
+    if (qsizetype(row) * 2 + 1 < m_highlight.size())
+        m_highlight[qsizetype(row) * 2] = m_highlight[qsizetype(row) * 2 + 1] = TextSpan();
+    setStatus(row, completionDt, statusId, statusName);
+}
+
+void TaskPage::setStatus(int row, const QVariant &completionDt, int statusId, const QString &statusName)
+{
+    if (row < 0 || row >= m_ids.size())
+        return;
+
+    m_dates[qsizetype(row) * DATE_COLUMNS + dateSlot(TEXT_COMPLETION_DT)] =
+        completionDt.isNull() ? TimestampFormat::Null : completionDt.toLongLong();
+    m_statusIds[row] = statusId;
+    if (!m_statusNames.contains(statusId))
+        m_statusNames.insert(statusId, statusName);
+}
+
+void TaskPage::setRemoved(int row)
+{
+    if (row < 0 || row >= m_ids.size())
+        return;
+    if (m_removed.size() < m_ids.size())
+        m_removed.resize(m_ids.size());
+    m_removed[row] = 1;
+}
+
+void TaskPage::appendTask(int id, const QString &description, const QString &details, qint64 creationDt,
+                          const QVariant &completionDt, int statusId, const QString &statusName)
+{
+    m_ids.append(id);
+    m_statusIds.append(statusId);
+    if (!m_statusNames.contains(statusId))
+        m_statusNames.insert(statusId, statusName);
+    m_deleted.append(0);
+    m_text.append(store(description));
+    m_text.append(details.isNull() ? TextSpan() : store(details));
+    m_dates.append(creationDt);
+    m_dates.append(completionDt.isNull() ? TimestampFormat::Null : completionDt.toLongLong());
+}
+
+void TaskPage::setTaskId(int row, int id)
+{
+    if (row >= 0 && row < m_ids.size())
+        m_ids[row] = id;
+}
+
+void TaskPage::removeRow(int row)
+{
+    if (row < 0 || row >= m_ids.size())
+        return;
+    // Текст строки остаётся в арене до конца жизни страницы (как после setTask())
+    m_ids.remove(row);
+    m_statusIds.remove(row);
+    m_deleted.remove(row);
+    if (row < m_removed.size())
+        m_removed.remove(row);
+    if (row < m_detailsMore.size())
+        m_detailsMore.remove(row);
+    m_text.remove(qsizetype(row) * TEXT_COLUMNS, TEXT_COLUMNS);
+    m_dates.remove(qsizetype(row) * DATE_COLUMNS, DATE_COLUMNS);
+    if (qsizetype(row) * 2 < m_highlight.size())
+        m_highlight.remove(qsizetype(row) * 2, 2);
+}
+
+void TaskPage::insertRow(int row, const TaskPage &source, int sourceRow)
+{
+    if (sourceRow < 0 || sourceRow >= source.rowCount())
+        return;
+    row = qBound(0, row, rowCount());
+
+    m_ids.insert(row, source.m_ids[sourceRow]);
+    const int statusId = source.m_statusIds[sourceRow];
+    m_statusIds.insert(row, statusId);
+    if (!m_statusNames.contains(statusId))
+        m_statusNames.insert(statusId, source.statusName(sourceRow));
+    m_deleted.insert(row, source.m_deleted[sourceRow]);
+    if (row < m_removed.size())
+        m_removed.insert(row, 0);
+    if (source.hasMoreDetails(sourceRow) || row < m_detailsMore.size()) {
+        if (m_detailsMore.size() < row)
+            m_detailsMore.resize(row);
+        m_detailsMore.insert(row, quint8(source.hasMoreDetails(sourceRow) ? 1 : 0));
+    }
+
+    for (int slot = 0; slot < TEXT_COLUMNS; ++slot) {
+        const TextSpan &text = source.m_text[qsizetype(sourceRow) * TEXT_COLUMNS + slot];
+        m_text.insert(qsizetype(row) * TEXT_COLUMNS + slot,
+                      text.size < 0 ? TextSpan() : store(QStringView(text.data, text.size)));
+    }
+    for (int slot = 0; slot < DATE_COLUMNS; ++slot)
+        m_dates.insert(qsizetype(row) * DATE_COLUMNS + slot, source.m_dates[qsizetype(sourceRow) * DATE_COLUMNS + slot]);
+
+    // Подсветка выровнена по строкам: вставляем пару, если она есть у источника или у строк ниже
+    const bool withHighlight = source.hasHighlight(sourceRow, TEXT_DESC) || source.hasHighlight(sourceRow, TEXT_DETAILS);
+    if (withHighlight || m_highlight.size() > qsizetype(row) * 2) {
+        if (m_highlight.size() < qsizetype(row) * 2)
+            m_highlight.resize(qsizetype(row) * 2);
+        int slot = 0;
+        for (int column : { int(TEXT_DESC), int(TEXT_DETAILS) }) {
+            m_highlight.insert(qsizetype(row) * 2 + slot++, source.hasHighlight(sourceRow, column)
+                                   ? store(source.highlightView(sourceRow, column)) : TextSpan());
+        }
+    }
+}
+
+bool TaskPage::sameRow(int row, const TaskPage &other, int otherRow) const
+{
+    if (row < 0 || row >= rowCount() || otherRow < 0 || otherRow >= other.rowCount())
+        return false;
+    if (m_ids[row] != other.m_ids[otherRow] || m_statusIds[row] != other.m_statusIds[otherRow]
+        || m_deleted[row] != other.m_deleted[otherRow] || isRemoved(row) != other.isRemoved(otherRow)
+        || hasMoreDetails(row) != other.hasMoreDetails(otherRow)
+        || statusName(row) != other.statusName(otherRow))
+        return false;
+    for (int column : { int(TEXT_DESC), int(TEXT_DETAILS) }) {
+        if (isNull(row, column) != other.isNull(otherRow, column)
+            || textView(row, column) != other.textView(otherRow, column)
+            || hasHighlight(row, column) != other.hasHighlight(otherRow, column)
+            || highlightView(row, column) != other.highlightView(otherRow, column))
+            return false;
+    }
+    for (int column : { int(TEXT_CREATION_DT), int(TEXT_COMPLETION_DT) }) {
+        if (dateMs(row, column) != other.dateMs(otherRow, column))
+            return false;
+    }
+    return true;
+}
+
+int TaskPage::textSlot(int column)
+{
+    switch (column) {
+        case TEXT_DESC: return 0;
+        case TEXT_DETAILS: return 1;
+        default: return -1;
+    }
+}
+
+int TaskPage::dateSlot(int column)
+{
+    switch (column) {
+        case TEXT_CREATION_DT: return 0;
+        case TEXT_COMPLETION_DT: return 1;
+        default: return -1;
+    }
+}
+
+TaskPage::TextSpan TaskPage::store(QStringView s)
+{
+    TextSpan result;
+    result.size = s.size();
+    if (result.size == 0)
+        return result;
+
+    if (m_chunks.empty() || m_chunkUsed + result.size > m_chunkCapacity) {
+        const qsizetype capacity = qMax(ArenaChunkSize, result.size);
+        m_chunks.push_back(std::make_unique<QChar[]>(capacity));
+        m_chunkUsed = 0;
+        m_chunkCapacity = capacity;
+    }
+
+    QChar *dst = m_chunks.back().get() + m_chunkUsed;
+    std::copy(s.data(), s.data() + result.size, dst);
+    m_chunkUsed += result.size;
+    result.data = dst;
+    return result;
+}
+
+const TaskPage::TextSpan &TaskPage::span(int row, int column) const
+{
+    return m_text[row * TEXT_COLUMNS + textSlot(column)];
+}
@@ -0,0 +1,124 @@
+#ifndef TASKPAGE_H
+#define TASKPAGE_H
+
+#include <QHash>
+#include <QString>
+#include <QStringView>
+#include <QVariant>
+#include <QVector>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+class QSqlQuery;
+
+// Колоночное хранилище страницы задач.
+// id и status_id — плоские массивы int, даты — массив qint64 (мс от эпохи, UTC; см.
+// TimestampFormat), тексты — в общем буфере (арене), имена статусов интернированы (одна строка
+// на статус). Страница собирается в потоке БД и целиком
+// передаётся в GUI (см. TaskTableModel), поэтому не зависит от QSqlQuery после чтения.
+class TaskPage
+{
+public:
+    // Столбцы с текстом и датами; номера совпадают с TaskTableModel::Column
+    enum TextColumn {
+        TEXT_DESC = 1,
+        TEXT_DETAILS = 2,
+        TEXT_CREATION_DT = 3,
+        TEXT_COMPLETION_DT = 4
+    };
+
+    TaskPage();
+    TaskPage(const TaskPage &) = delete;
+    TaskPage &operator=(const TaskPage &) = delete;
+
+    // Дописывает строки выполненного запроса: id, description, details, creation_dt,
+    // completion_dt, имя статуса, is_deleted и поле "status_id". Если в запросе есть поля
+    // "desc_hl"/"details_hl" (результаты поиска), они сохраняются как текст для отображения;
+    // поле "details_more" отмечает строки, где details — только начало текста (см. hasMoreDetails()).
+    // Возвращает false, если чтение прервано isCancelled (проверяется раз в несколько строк).
+    bool appendFromQuery(QSqlQuery &query, const std::function<bool()> &isCancelled = {});
+
+    int rowCount() const { return int(m_ids.size()); }
+    int taskId(int row) const;
+    int statusId(int row) const;
+    bool isDeleted(int row) const;
+    // Строка уходит из текущего списка (удаление, восстановление из корзины), но страница
+    // ещё не перечитана — см. setRemoved()
+    bool isRemoved(int row) const;
+    int rowForId(int id) const;
+    // В странице лишь начало "Описания" (TaskRepository::DetailsPreviewChars): полный текст —
+    // TaskRepository::loadDetails(). После setTask() с новым текстом строка хранит его целиком.
+    bool hasMoreDetails(int row) const;
+
+    // Текст ячейки поверх арены — без копирования; действителен, пока жива страница.
+    // Для столбцов дат textView() пуст: они хранятся числом (dateMs()).
+    bool isNull(int row, int column) const;
+    QStringView textView(int row, int column) const;
+    // Самостоятельная копия текста ячейки; для дат — локальное время (TimestampFormat::toDisplay)
+    QString text(int row, int column) const;
+    // TEXT_CREATION_DT / TEXT_COMPLETION_DT: мс от эпохи или TimestampFormat::Null
+    qint64 dateMs(int row, int column) const;
+    QString statusName(int row) const;
+
+    // Подсвеченный вариант текста для отображения (только для результатов поиска; пустой
+    // QStringView, если подсветки нет). Совпадения обрамлены символами HighlightBegin/HighlightEnd.
+    bool hasHighlight(int row, int column) const;
+    QStringView highlightView(int row, int column) const;
+    static constexpr QChar HighlightBegin = QChar(0x02);
+    static constexpr QChar HighlightEnd = QChar(0x03);
+
+    // Точечное обновление строки (старый текст остаётся в арене до конца жизни страницы);
+    // completionDt — мс от эпохи или NULL. details — полный текст (из диалога): отметка
+    // hasMoreDetails() снимается, если он не совпадает с хранимым началом.
+    void setTask(int row, const QString &description, const QString &details,
+                 const QVariant &completionDt, int statusId, const QString &statusName);
+    // Смена статуса: текст и отметка hasMoreDetails() не меняются
+    void setStatus(int row, const QVariant &completionDt, int statusId, const QString &statusName);
+    // Пометка "строка уходит из списка" до того, как страница будет перечитана
+    void setRemoved(int row);
+    // Строка задачи, ещё не записанной в базу (см. TaskTableModel::insertTask()): дописывается
+    // в конец; creationDt и completionDt — мс от эпохи (completionDt может быть NULL)
+    void appendTask(int id, const QString &description, const QString &details, qint64 creationDt,
+                    const QVariant &completionDt, int statusId, const QString &statusName);
+    // Временный id строки заменяется настоящим, когда задача записана
+    void setTaskId(int row, int id);
+    // Правка состава страницы на месте (см. TaskTableModel::updatePage(), TaskScrollModel::removeTasks()):
+    // удалить строку; вставить перед row копию строки sourceRow другой страницы
+    void removeRow(int row);
+    void insertRow(int row, const TaskPage &source, int sourceRow);
+    // Строки совпадают во всём, что показывает таблица
+    bool sameRow(int row, const TaskPage &other, int otherRow) const;
+
+private:
+    // Ссылка на текст в арене; size < 0 означает NULL
+    struct TextSpan {
+        const QChar *data = nullptr;
+        qsizetype size = -1;
+    };
+
+    enum { TEXT_COLUMNS = 2, DATE_COLUMNS = 2 };
+    static int textSlot(int column);
+    static int dateSlot(int column);
+
+    TextSpan store(QStringView s);
+    const TextSpan &span(int row, int column) const;
+
+    QVector<int> m_ids;
+    QVector<int> m_statusIds;
+    QVector<quint8> m_deleted;
+    QVector<quint8> m_removed; // пуст, пока ни одна строка не помечена
+    QVector<quint8> m_detailsMore; // пуст, пока ни в одной строке нет усечённого "Описания"
+    QVector<TextSpan> m_text; // TEXT_COLUMNS ссылок на строку
+    QVector<qint64> m_dates;  // DATE_COLUMNS значений на строку
+    QVector<TextSpan> m_highlight; // 2 ссылки на строку (описание, детали) — только для поиска
+    QHash<int, QString> m_statusNames;
+
+    // Арена из блоков, которые никогда не перевыделяются, — указатели в TextSpan стабильны.
+    std::vector<std::unique_ptr<QChar[]>> m_chunks;
+    qsizetype m_chunkUsed;
+    qsizetype m_chunkCapacity;
+};
+
+#endif // TASKPAGE_H
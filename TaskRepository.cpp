@@ -0,0 +1,1943 @@
+#include "TaskRepository.h"
+#include "SqliteHandle.h"
+#include "TaskPage.h"
+#include "TaskTableModel.h"
+#include "TimestampFormat.h"
+#include "Trace.h"
+
+#include <QByteArray>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPair>
+#include <QRegularExpression>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QUuid>
+
+#include <optional>
+
+#ifdef TRACKER_HAVE_SQLITE_API
+#include <sqlite3.h>
+#endif
+
+namespace {
+// Раз в сколько инструкций VM SQLite вызывает progress handler (проверка отмены запроса)
+constexpr int ProgressHandlerOps = 1000;
+// Длина фрагмента "Описания" в результатах поиска, в словах
+constexpr int SnippetTokens = 16;
+
+// Триггеры счётчиков TASK_STATS (создаются заново, если TASK перестраивается)
+QStringList counterTriggers()
+{
+    return {
+        "CREATE TRIGGER IF NOT EXISTS trg_task_stats_insert AFTER INSERT ON TASK BEGIN "
+        "INSERT INTO TASK_STATS (status_id, is_deleted, cnt) "
+        "VALUES (IFNULL(NEW.status_id, 0), IFNULL(NEW.is_deleted, 0), 1) "
+        "ON CONFLICT(status_id, is_deleted) DO UPDATE SET cnt = cnt + 1; "
+        "END;",
+
+        "CREATE TRIGGER IF NOT EXISTS trg_task_stats_delete AFTER DELETE ON TASK BEGIN "
+        "UPDATE TASK_STATS SET cnt = cnt - 1 "
+        "WHERE status_id = IFNULL(OLD.status_id, 0) AND is_deleted = IFNULL(OLD.is_deleted, 0); "
+        "END;",
+
+        "CREATE TRIGGER IF NOT EXISTS trg_task_stats_update AFTER UPDATE OF status_id, is_deleted ON TASK "
+        "WHEN IFNULL(OLD.status_id, 0) <> IFNULL(NEW.status_id, 0) OR IFNULL(OLD.is_deleted, 0) <> IFNULL(NEW.is_deleted, 0) "
+        "BEGIN "
+        "UPDATE TASK_STATS SET cnt = cnt - 1 "
+        "WHERE status_id = IFNULL(OLD.status_id, 0) AND is_deleted = IFNULL(OLD.is_deleted, 0); "
+        "INSERT INTO TASK_STATS (status_id, is_deleted, cnt) "
+        "VALUES (IFNULL(NEW.status_id, 0), IFNULL(NEW.is_deleted, 0), 1) "
+        "ON CONFLICT(status_id, is_deleted) DO UPDATE SET cnt = cnt + 1; "
+        "END;"
+    };
+}
+
+// Общие части триггеров журнала изменений: "триггеры молчат", текущее время (мс от эпохи),
+// устройство и следующая версия записи
+const QString ChangeLogQuiet = QStringLiteral("NOT EXISTS (SELECT 1 FROM SYNC_STATE WHERE key = 'applying')");
+const QString ChangeLogNow = QStringLiteral("CAST((julianday('now') - 2440587.5) * 86400000.0 AS INTEGER)");
+const QString ChangeLogDevice = QStringLiteral("(SELECT value FROM SYNC_STATE WHERE key = 'device_id')");
+
+QString changeLogVersion(const QString &entity, const QString &uid)
+{
+    return QStringLiteral("(SELECT IFNULL(MAX(version), 0) + 1 FROM CHANGE_LOG WHERE entity = '%1' AND uid = %2)")
+        .arg(entity, uid);
+}
+
+// Журнал изменений для синхронизации (CHANGE_LOG, см. TaskSync). Вставка — одна строка "*"
+// без значений (значения экспорт берёт из самой строки TASK), изменение — по строке на
+// изменённое поле со значением, удаление — "-". Время — мс от эпохи, устройство — из SYNC_STATE.
+// Пока TaskSync применяет чужие изменения (строка 'applying' в SYNC_STATE, только внутри его
+// транзакции), триггеры молчат: эти изменения журналирует сам TaskSync с исходными временем
+// и устройством. timeColumn — столбец времени (до миграции 12 — hlc), detailsChanged — условие
+// записи поля details (см. migrateDetailsStorage()).
+QStringList changeLogTriggers(const QString &timeColumn,
+                              const QString &detailsChanged = QStringLiteral("OLD.details IS NOT NEW.details"))
+{
+    const QStringList triggers = {
+        // uid новой задачи — случайный; из TaskSync строки приходят уже с uid
+        QStringLiteral("CREATE TRIGGER IF NOT EXISTS trg_task_log_insert AFTER INSERT ON TASK WHEN %1 BEGIN "
+                       "UPDATE TASK SET uid = lower(hex(randomblob(16))) WHERE id = NEW.id AND uid IS NULL; "
+                       "INSERT INTO CHANGE_LOG (entity, uid, field, value, %9, device, version) "
+                       "SELECT 'TASK', uid, '*', NULL, %2, %3, 1 FROM TASK WHERE id = NEW.id; "
+                       "END;").arg(ChangeLogQuiet, ChangeLogNow, ChangeLogDevice),
+
+        QStringLiteral("CREATE TRIGGER IF NOT EXISTS trg_task_log_update AFTER UPDATE OF "
+                       "description, details, creation_dt, completion_dt, status_id, is_deleted, deleted_dt ON TASK "
+                       "WHEN %1 BEGIN "
+                       "INSERT INTO CHANGE_LOG (entity, uid, field, value, %9, device, version) "
+                       "SELECT 'TASK', NEW.uid, f.field, f.value, %2, %3, %4 FROM ("
+                       "SELECT 'description' AS field, NEW.description AS value WHERE OLD.description IS NOT NEW.description "
+                       "UNION ALL SELECT 'details', NEW.details WHERE %5 "
+                       "UNION ALL SELECT 'creation_dt', NEW.creation_dt WHERE OLD.creation_dt IS NOT NEW.creation_dt "
+                       "UNION ALL SELECT 'completion_dt', NEW.completion_dt WHERE OLD.completion_dt IS NOT NEW.completion_dt "
+                       "UNION ALL SELECT 'status', (SELECT name FROM STATUS WHERE id = NEW.status_id) "
+                       "WHERE OLD.status_id IS NOT NEW.status_id "
+                       "UNION ALL SELECT 'is_deleted', NEW.is_deleted WHERE OLD.is_deleted IS NOT NEW.is_deleted "
+                       "UNION ALL SELECT 'deleted_dt', NEW.deleted_dt WHERE OLD.deleted_dt IS NOT NEW.deleted_dt"
+                       ") AS f; "
+                       "END;").arg(ChangeLogQuiet, ChangeLogNow, ChangeLogDevice,
+                                   changeLogVersion(QStringLiteral("TASK"), QStringLiteral("NEW.uid")),
+                                   detailsChanged),
+
+        QStringLiteral("CREATE TRIGGER IF NOT EXISTS trg_task_log_delete AFTER DELETE ON TASK "
+                       "WHEN %1 AND OLD.uid IS NOT NULL BEGIN "
+                       "INSERT INTO CHANGE_LOG (entity, uid, field, value, %9, device, version) "
+                       "VALUES ('TASK', OLD.uid, '-', NULL, %2, %3, %4); "
+                       "END;").arg(ChangeLogQuiet, ChangeLogNow, ChangeLogDevice,
+                                   changeLogVersion(QStringLiteral("TASK"), QStringLiteral("OLD.uid"))),
+
+        // Статусы — по имени (id на разных устройствах свои)
+        QStringLiteral("CREATE TRIGGER IF NOT EXISTS trg_status_log_insert AFTER INSERT ON STATUS WHEN %1 BEGIN "
+                       "INSERT INTO CHANGE_LOG (entity, uid, field, value, %9, device, version) "
+                       "VALUES ('STATUS', NEW.name, '*', NULL, %2, %3, %4); "
+                       "END;").arg(ChangeLogQuiet, ChangeLogNow, ChangeLogDevice,
+                                   changeLogVersion(QStringLiteral("STATUS"), QStringLiteral("NEW.name"))),
+
+        QStringLiteral("CREATE TRIGGER IF NOT EXISTS trg_status_log_delete AFTER DELETE ON STATUS WHEN %1 BEGIN "
+                       "INSERT INTO CHANGE_LOG (entity, uid, field, value, %9, device, version) "
+                       "VALUES ('STATUS', OLD.name, '-', NULL, %2, %3, %4); "
+                       "END;").arg(ChangeLogQuiet, ChangeLogNow, ChangeLogDevice,
+                                   changeLogVersion(QStringLiteral("STATUS"), QStringLiteral("OLD.name")))
+    };
+    // %9 — столбец времени: arg() с несколькими аргументами заменяет только младшие номера
+    QStringList result;
+    for (const QString &sql : triggers)
+        result << QString(sql).replace(QLatin1String("%9"), timeColumn);
+    return result;
+}
+
+// Запись сжатого "Описания" (строка TASK_DETAILS) — изменение поля details со ссылкой вместо
+// значения (value = NULL): текст экспорт берёт из TASK_DETAILS. Строка, появившаяся, пока
+// details_size задачи ещё NULL, — сжатие уже записанного текста (compactDetails()), не правка.
+QString detailsBodyLogTrigger()
+{
+    return QStringLiteral("CREATE TRIGGER IF NOT EXISTS trg_task_details_log AFTER INSERT ON TASK_DETAILS WHEN %1 BEGIN "
+                          "INSERT INTO CHANGE_LOG (entity, uid, field, value, changed_ms, device, version) "
+                          "SELECT 'TASK', uid, 'details', NULL, %2, %3, %4 FROM TASK "
+                          "WHERE id = NEW.task_id AND details_size IS NOT NULL; "
+                          "END;")
+        .arg(ChangeLogQuiet, ChangeLogNow, ChangeLogDevice,
+             changeLogVersion(QStringLiteral("TASK"), QStringLiteral("TASK.uid")));
+}
+
+// Ключ сортировки текста для вычисляемых столбцов: заглавные латиница и кириллица → строчные,
+// ё → е. Только replace(): lower() без ICU меняет лишь ASCII, а с ICU — ещё и другие алфавиты,
+// и ключ разошёлся бы с TaskRepository::collationKey() на разных сборках SQLite.
+// Строчные а…я в Unicode идут по алфавиту, поэтому двоичное сравнение ключей даёт русский
+// порядок; выпадающая из ряда ё сортируется как е.
+QString collationKeyExpression(const QString &text)
+{
+    QString expression = text;
+    auto fold = [&expression](char16_t from, char16_t to) {
+        expression = QStringLiteral("replace(%1, '%2', '%3')").arg(expression, QString(QChar(from)), QString(QChar(to)));
+    };
+    for (char16_t c = u'A'; c <= u'Z'; ++c)
+        fold(c, c + 0x20);
+    for (char16_t c = u'А'; c <= u'Я'; ++c)
+        fold(c, c + 0x20);
+    fold(u'Ё', u'е');
+    fold(u'ё', u'е');
+    return expression;
+}
+
+// Символов описания в ключе: порядок по длинным заметкам решает начало текста, а индекс и
+// вычисление ключа при записи не растут вместе с заметкой
+constexpr int DetailsKeyChars = 200;
+// Ключ строки страницы считается по её тексту (TaskRepository::sortKeyValue())
+static_assert(TaskRepository::DetailsPreviewChars >= DetailsKeyChars
+                  && TaskRepository::DetailsInlineChars >= DetailsKeyChars,
+              "details preview must cover the sort key");
+
+// "Описание" в запросах страниц: только начало текста и признак того, что он длиннее
+// (второе поле — "details_more", см. TaskPage::hasMoreDetails())
+QString detailsPreviewColumns()
+{
+    return QStringLiteral("substr(TASK.details, 1, %1) AS details, "
+                          "(TASK.details_size IS NOT NULL OR length(TASK.details) > %1) AS details_more")
+        .arg(TaskRepository::DetailsPreviewChars);
+}
+
+// Поиск по полному тексту длинных "Описаний" (TASK_DETAILS_FTS, см. migrateDetailsFullText())
+// берёт только строки, которых нет среди совпадений TASK_FTS: начало текста есть в обоих индексах.
+// Релевантность двух индексов считается по-разному (bm25 по своим таблицам) — общий порядок
+// приблизительный.
+QString detailsOnlyMatch()
+{
+    return QStringLiteral("TASK.id NOT IN (SELECT rowid FROM TASK_FTS WHERE TASK_FTS MATCH :match)");
+}
+
+// Начало длинного "Описания", которое остаётся в TASK.details, — не разрывая суррогатную пару
+QString inlineDetails(const QString &details)
+{
+    qsizetype inlineSize = qMin<qsizetype>(details.size(), TaskRepository::DetailsInlineChars);
+    if (inlineSize < details.size() && details.at(inlineSize - 1).isHighSurrogate())
+        --inlineSize;
+    return details.left(inlineSize);
+}
+
+// Точка сохранения на время записи длинного "Описания": строка TASK и TASK_DETAILS
+// пишутся вместе или никак (в том числе внутри транзакции пачки DatabaseWorker)
+class DetailsSavepoint
+{
+public:
+    explicit DetailsSavepoint(const QSqlDatabase &db) : m_query(db)
+    {
+        m_open = m_query.exec(QStringLiteral("SAVEPOINT task_details;"));
+    }
+    ~DetailsSavepoint()
+    {
+        if (m_open) {
+            m_query.exec(QStringLiteral("ROLLBACK TO task_details;"));
+            m_query.exec(QStringLiteral("RELEASE task_details;"));
+        }
+    }
+    bool isOpen() const { return m_open; }
+    bool release()
+    {
+        m_open = !m_query.exec(QStringLiteral("RELEASE task_details;"));
+        return !m_open;
+    }
+    QString error() const { return m_query.lastError().text(); }
+
+private:
+    QSqlQuery m_query;
+    bool m_open;
+};
+
+// Триггеры синхронизации TASK_FTS с TASK
+QStringList fullTextTriggers()
+{
+    return {
+        "CREATE TRIGGER IF NOT EXISTS trg_task_fts_insert AFTER INSERT ON TASK BEGIN "
+        "INSERT INTO TASK_FTS (rowid, description, details) VALUES (NEW.id, NEW.description, NEW.details); "
+        "END;",
+
+        // Для external content удаление из индекса требует старые значения столбцов
+        "CREATE TRIGGER IF NOT EXISTS trg_task_fts_delete AFTER DELETE ON TASK BEGIN "
+        "INSERT INTO TASK_FTS (TASK_FTS, rowid, description, details) VALUES ('delete', OLD.id, OLD.description, OLD.details); "
+        "END;",
+
+        "CREATE TRIGGER IF NOT EXISTS trg_task_fts_update AFTER UPDATE OF description, details ON TASK BEGIN "
+        "INSERT INTO TASK_FTS (TASK_FTS, rowid, description, details) VALUES ('delete', OLD.id, OLD.description, OLD.details); "
+        "INSERT INTO TASK_FTS (rowid, description, details) VALUES (NEW.id, NEW.description, NEW.details); "
+        "END;"
+    };
+}
+
+// Выставляет функцию прерывания для progress handler на время выборки
+struct InterruptScope {
+    InterruptScope(std::function<bool()> &slot, const std::function<bool()> &isCancelled)
+        : slot(slot) { slot = isCancelled; }
+    ~InterruptScope() { slot = nullptr; }
+    std::function<bool()> &slot;
+};
+}
+
+TaskRepository::TaskRepository(const QString &connectionName)
+    : m_connectionName(connectionName)
+    , m_statusDoneId(-1)
+    , m_ftsAvailable(false)
+    , m_ftsChecked(false)
+    , m_handle(nullptr)
+{
+}
+
+TaskRepository::~TaskRepository()
+{
+    close();
+}
+
+QString TaskRepository::defaultDatabasePath()
+{
+    // 1. Находим "правильное" место для хранения данных
+    // (Это будет C:/Users/ТвоёИмя/AppData/Local/SelfImprovementApp)
+    QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+
+    // 2. Убеждаемся, что эта папка существует
+    QDir dir(dataPath);
+    if (!dir.exists())
+    {
+           dir.mkpath(dataPath); // Создаем её, если нет
+    }
+
+    // 3. Полный путь к БД
+    return dataPath + "/tracker.db";
+}
+
+bool TaskRepository::open(const QString &path, ConnectionRole role, const StorageProfile &profile)
+{
+    qDebug() << "Database path set to:" << path;
+
+    m_db = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+    m_db.setDatabaseName(path);
+    if (!m_db.open())
+    {
+        m_lastError = m_db.lastError().text();
+        qCritical() << "Database connection failed:" << m_lastError;
+        return false;
+    }
+
+    qDebug() << "Database connected successfully.";
+    if (!profile.apply(m_db, role, &m_lastError)) {
+        qCritical() << "Failed to configure database connection:" << m_lastError;
+        close();
+        return false;
+    }
+    QSqlQuery query(m_db);
+    // Включаем поддержку внешних ключей (для SQLite это важно)
+    query.exec("PRAGMA foreign_keys = ON;");
+
+    // Progress handler даёт прервать уже выполняющийся запрос (поиск по миллионам строк),
+    // когда пользователь набрал следующий символ. Сам обработчик ничего не делает, пока
+    // fetchPage() не выставит m_interrupt.
+    m_handle = sqliteHandle(m_db);
+#ifdef TRACKER_HAVE_SQLITE_API
+    if (m_handle)
+        sqlite3_progress_handler(m_handle, ProgressHandlerOps, &TaskRepository::progressCallback, this);
+#endif
+    return true;
+}
+
+int TaskRepository::progressCallback(void *self)
+{
+    // Ненулевой результат прерывает запрос с SQLITE_INTERRUPT
+    const TaskRepository *repository = static_cast<const TaskRepository *>(self);
+    return (repository->m_interrupt && repository->m_interrupt()) ? 1 : 0;
+}
+
+void TaskRepository::close()
+{
+    if (!m_db.isValid())
+        return;
+#ifdef TRACKER_HAVE_SQLITE_API
+    if (m_handle)
+        sqlite3_progress_handler(m_handle, 0, nullptr, nullptr);
+#endif
+    m_handle = nullptr;
+    if (m_db.isOpen())
+        m_db.close();
+    // removeDatabase() требует, чтобы копий QSqlDatabase больше не было
+    m_db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+int TaskRepository::dataVersion()
+{
+    QSqlQuery q(m_db);
+    if (!q.exec("PRAGMA data_version;") || !q.next()) {
+        m_lastError = q.lastError().text();
+        return -1;
+    }
+    return q.value(0).toInt();
+}
+
+bool TaskRepository::checkpoint(bool truncate, int *walPages)
+{
+    // Результат: busy, страниц в WAL, перенесено в базу (-1, если журнал не WAL)
+    QSqlQuery q(m_db);
+    if (!q.exec(truncate ? "PRAGMA wal_checkpoint(TRUNCATE);" : "PRAGMA wal_checkpoint(PASSIVE);") || !q.next()) {
+        m_lastError = q.lastError().text();
+        qWarning() << "WAL checkpoint failed:" << m_lastError;
+        return false;
+    }
+    if (walPages)
+        *walPages = q.value(1).toInt();
+    return q.value(0).toInt() == 0;
+}
+
+bool TaskRepository::isOpen() const
+{
+    return m_db.isOpen();
+}
+
+bool TaskRepository::initSchema()
+{
+    TraceSpan span("db.initSchema");
+    // Версия схемы хранится в заголовке файла БД (PRAGMA user_version). Актуальная база
+    // открывается одним чтением pragma; иначе по порядку применяются недостающие миграции,
+    // каждая — в своей транзакции вместе с записью нового номера версии.
+    QElapsedTimer timer;
+    timer.start();
+
+    const int version = schemaVersion();
+    if (version < 0)
+        return false;
+    if (version > SchemaVersion) {
+        m_lastError = QStringLiteral("База создана более новой версией приложения (схема %1, поддерживается до %2)")
+                          .arg(version).arg(SchemaVersion);
+        qCritical() << m_lastError;
+        return false;
+    }
+
+    // Миграции только добавляются в конец; номер миграции — её позиция в списке
+    using Migration = bool (TaskRepository::*)(QSqlQuery &);
+    static const Migration migrations[] = {
+        &TaskRepository::migrateBaseTables,    // 1
+        &TaskRepository::migrateKeysetIndexes, // 2
+        &TaskRepository::migrateCounters,      // 3
+        &TaskRepository::migrateFullText,      // 4
+        &TaskRepository::migrateStatuses,      // 5
+        &TaskRepository::migrateEpochTimestamps, // 6
+        &TaskRepository::migrateTrash,         // 7
+        &TaskRepository::migrateChangeLog,     // 8
+        &TaskRepository::migrateCollationKeys, // 9
+        &TaskRepository::migrateDetailsStorage, // 10
+        &TaskRepository::migrateCounterIndex,  // 11
+        &TaskRepository::migrateChangeTime,    // 12
+        &TaskRepository::migrateDetailsFullText, // 13
+        &TaskRepository::migrateStatusDefault  // 14
+    };
+    static_assert(sizeof(migrations) / sizeof(migrations[0]) == SchemaVersion,
+                  "SchemaVersion must match the number of migrations");
+
+    // Новая база сразу создаётся с auto_vacuum = INCREMENTAL: место после удалений возвращается
+    // порциями (incrementalVacuum()). Режим задаётся только до первой таблицы; существующую
+    // базу переводит полный VACUUM (vacuum(), консольная команда).
+    if (version == 0) {
+        QSqlQuery pragma(m_db);
+        if (!pragma.exec("PRAGMA auto_vacuum = INCREMENTAL;"))
+            qWarning() << "Failed to enable incremental auto_vacuum:" << pragma.lastError().text();
+    }
+
+    for (int next = version + 1; next <= SchemaVersion; ++next) {
+        if (!m_db.transaction()) {
+            m_lastError = m_db.lastError().text();
+            qCritical() << "Failed to begin schema migration" << next << ":" << m_lastError;
+            return false;
+        }
+        QSqlQuery query(m_db);
+        if (!(this->*migrations[next - 1])(query)
+            || !query.exec(QStringLiteral("PRAGMA user_version = %1;").arg(next))) {
+            m_lastError = query.lastError().text();
+            qCritical() << "Schema migration" << next << "failed:" << m_lastError;
+            m_db.rollback();
+            return false;
+        }
+        if (!m_db.commit()) {
+            m_lastError = m_db.lastError().text();
+            qCritical() << "Failed to commit schema migration" << next << ":" << m_lastError;
+            m_db.rollback();
+            return false;
+        }
+        qDebug() << "Applied schema migration" << next;
+    }
+
+    // База могла приехать с другой машины — изменения отсюда подписываются своим id
+    if (!updateDeviceId())
+        qWarning() << "Failed to set device id:" << m_lastError;
+
+    // Справочник в память; ID статуса "Сделано" узнаём один раз при запуске
+    reloadStatuses();
+    if (m_statusDoneId == -1)
+        qWarning() << "CRITICAL: Could not find 'Сделано' status ID! Date logic will fail.";
+    qDebug() << "Schema ready in" << timer.elapsed() << "ms (version" << version << "->" << SchemaVersion << ")";
+    return true;
+}
+
+int TaskRepository::schemaVersion()
+{
+    QSqlQuery query(m_db);
+    if (!query.exec("PRAGMA user_version;") || !query.next()) {
+        m_lastError = query.lastError().text();
+        qCritical() << "Failed to read schema version:" << m_lastError;
+        return -1;
+    }
+    return query.value(0).toInt();
+}
+
+bool TaskRepository::migrateBaseTables(QSqlQuery &query)
+{
+    // Базы до появления миграций (user_version = 0) уже могут содержать таблицы — поэтому
+    // IF NOT EXISTS и проверка положения столбца details, как раньше при каждом запуске.
+
+    // 1. Таблица статусов (справочник)
+    if (!query.exec("CREATE TABLE IF NOT EXISTS STATUS ("
+                    "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                    "name TEXT NOT NULL UNIQUE);"))
+        return false;
+
+    // 2. Основная таблица задач
+    const QString taskColumns = "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                                "description TEXT NOT NULL, "
+                                "details TEXT, "
+                                "creation_dt TEXT, "
+                                "completion_dt TEXT, "
+                                "status_id INTEGER, "
+                                "is_deleted INTEGER DEFAULT 0, "
+                                "FOREIGN KEY(status_id) REFERENCES STATUS(id)";
+    if (!query.exec("CREATE TABLE IF NOT EXISTS TASK (" + taskColumns + ");"))
+        return false;
+
+    // Ensure `details` column exists AND is in the expected position.
+    // Older DBs may lack the column or have it appended at the end (SQLite ALTER TABLE adds columns at the end).
+    QStringList cols;
+    if (!query.exec("PRAGMA table_info('TASK');"))
+        return false;
+    while (query.next())
+        cols << query.value("name").toString();
+
+    const int idxDetails = cols.indexOf("details");
+    if (idxDetails == -1) {
+        qDebug() << "Adding 'details' column to existing TASK table...";
+        return query.exec("ALTER TABLE TASK ADD COLUMN details TEXT;");
+    }
+    if (idxDetails != 2) {
+        // Column exists but in wrong position — rebuild table with desired column order.
+        // Copy data by column names to preserve values regardless of physical order.
+        qDebug() << "Rebuilding TASK table to normalize column order...";
+        return query.exec("CREATE TABLE TASK_new (" + taskColumns + ");")
+            && query.exec("INSERT INTO TASK_new (id, description, details, creation_dt, completion_dt, status_id, is_deleted) "
+                          "SELECT id, description, details, creation_dt, completion_dt, status_id, is_deleted FROM TASK;")
+            && query.exec("DROP TABLE TASK;")
+            && query.exec("ALTER TABLE TASK_new RENAME TO TASK;");
+    }
+    return true;
+}
+
+bool TaskRepository::migrateKeysetIndexes(QSqlQuery &query)
+{
+    // Составные индексы под keyset-пагинацию: (is_deleted, ключ сортировки, id) для каждого
+    // столбца, по которому сортирует MainWindow::onHeaderClicked(). Выражения должны совпадать
+    // с sortKeyExpression(), иначе SQLite не сможет использовать индекс.
+    const QStringList keysetIndexes = {
+        "CREATE INDEX IF NOT EXISTS idx_task_keyset_desc ON TASK(is_deleted, description, id);",
+        "CREATE INDEX IF NOT EXISTS idx_task_keyset_details ON TASK(is_deleted, IFNULL(details, ''), id);",
+        "CREATE INDEX IF NOT EXISTS idx_task_keyset_created ON TASK(is_deleted, IFNULL(creation_dt, ''), id);",
+        "CREATE INDEX IF NOT EXISTS idx_task_keyset_completed ON TASK(is_deleted, IFNULL(completion_dt, ''), id);",
+        // Сортировка по STATUS.name идёт вложенным циклом: STATUS по имени (UNIQUE-индекс),
+        // затем задачи этого статуса по id.
+        "CREATE INDEX IF NOT EXISTS idx_task_keyset_status ON TASK(is_deleted, status_id, id);"
+    };
+    for (const QString &sql : keysetIndexes) {
+        if (!query.exec(sql))
+            return false;
+    }
+    return true;
+}
+
+bool TaskRepository::migrateCounters(QSqlQuery &query)
+{
+    // Счётчики задач: количество строк TASK на пару (status_id, is_deleted), их держат в актуальном
+    // состоянии триггеры. Итоги (живые/удалённые, по статусам) — сумма нескольких строк вместо
+    // COUNT(*) по всей таблице. NULL в status_id учитываем как 0.
+    QStringList counterSchema = {
+        "CREATE TABLE IF NOT EXISTS TASK_STATS ("
+        "status_id INTEGER NOT NULL, "
+        "is_deleted INTEGER NOT NULL, "
+        "cnt INTEGER NOT NULL DEFAULT 0, "
+        "PRIMARY KEY(status_id, is_deleted)) WITHOUT ROWID;"
+    };
+    counterSchema << counterTriggers();
+    for (const QString &sql : counterSchema) {
+        if (!query.exec(sql))
+            return false;
+    }
+    // Заполняем по факту один раз (в том числе для баз, где таблица уже была)
+    return fillCounters(query);
+}
+
+bool TaskRepository::migrateFullText(QSqlQuery &query)
+{
+    // Внешнее содержимое (content='TASK'): индекс хранит только словарь и позиции, текст
+    // читается из самой TASK — details не дублируется в базе. Синхронизацию держат триггеры.
+    // prefix='2 3' — готовые префиксные индексы для поиска по мере набора ("зад*").
+    if (!query.exec("CREATE VIRTUAL TABLE IF NOT EXISTS TASK_FTS USING fts5("
+                    "description, details, content='TASK', content_rowid='id', "
+                    "tokenize='unicode61 remove_diacritics 2', prefix='2 3');")) {
+        // Например, плагин QSQLITE собран без FTS5 — приложение работает, но без поиска.
+        // Миграция всё равно считается выполненной; наличие индекса проверяет ftsAvailable().
+        qWarning() << "Full-text search is unavailable:" << query.lastError().text();
+        return true;
+    }
+
+    const QStringList ftsTriggers = fullTextTriggers();
+    for (const QString &sql : ftsTriggers) {
+        if (!query.exec(sql))
+            return false;
+    }
+    // Строим по текущему содержимому один раз
+    return query.exec("INSERT INTO TASK_FTS (TASK_FTS) VALUES ('rebuild');");
+}
+
+bool TaskRepository::migrateStatuses(QSqlQuery &query)
+{
+    // Начальный справочник. name — UNIQUE, поэтому недостающие статусы добавляются одним
+    // проходом без проверок (в пустую таблицу — полный набор в исходном порядке).
+    const QStringList requiredStatuses = {"Запланировано", "В процессе", "Сделано", "Отложено", "Отменено"};
+    query.prepare("INSERT OR IGNORE INTO STATUS (name) VALUES (:name);");
+    for (const QString &s : requiredStatuses) {
+        query.bindValue(":name", s);
+        if (!query.exec())
+            return false;
+    }
+    return true;
+}
+
+bool TaskRepository::migrateEpochTimestamps(QSqlQuery &query)
+{
+    // Даты были строками "yyyy-MM-dd HH:mm:ss" в локальном времени: сравнение строк, разбор
+    // при каждом показе и неоднозначность при переводе часов. Теперь — INTEGER, мс от эпохи (UTC).
+    // SQLite не меняет тип столбца через ALTER, поэтому таблица перестраивается; id сохраняются,
+    // так что TASK_FTS (external content по rowid) и TASK_STATS остаются верными. Индексы и
+    // триггеры уходят вместе со старой таблицей и создаются заново.
+    const QString taskColumns = "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                                "description TEXT NOT NULL, "
+                                "details TEXT, "
+                                "creation_dt INTEGER, "
+                                "completion_dt INTEGER, "
+                                "status_id INTEGER, "
+                                "is_deleted INTEGER DEFAULT 0, "
+                                "FOREIGN KEY(status_id) REFERENCES STATUS(id)";
+    // strftime(..., 'utc') считает исходную строку локальным временем; пустая или
+    // нераспознанная строка даёт NULL
+    const QString toEpochMs = QStringLiteral("CAST(strftime('%s', %1, 'utc') AS INTEGER) * 1000");
+    if (!query.exec("CREATE TABLE TASK_new (" + taskColumns + ");")
+        || !query.exec(QString("INSERT INTO TASK_new (id, description, details, creation_dt, completion_dt, status_id, is_deleted) "
+                               "SELECT id, description, details, %1, %2, status_id, is_deleted FROM TASK;")
+                           .arg(toEpochMs.arg("creation_dt"), toEpochMs.arg("completion_dt")))
+        || !query.exec("DROP TABLE TASK;")
+        || !query.exec("ALTER TABLE TASK_new RENAME TO TASK;"))
+        return false;
+
+    // Выражения индексов дат — как в sortKeyExpression()
+    QStringList schema = {
+        "CREATE INDEX IF NOT EXISTS idx_task_keyset_desc ON TASK(is_deleted, description, id);",
+        "CREATE INDEX IF NOT EXISTS idx_task_keyset_details ON TASK(is_deleted, IFNULL(details, ''), id);",
+        "CREATE INDEX IF NOT EXISTS idx_task_keyset_created ON TASK(is_deleted, IFNULL(creation_dt, 0), id);",
+        "CREATE INDEX IF NOT EXISTS idx_task_keyset_completed ON TASK(is_deleted, IFNULL(completion_dt, 0), id);",
+        "CREATE INDEX IF NOT EXISTS idx_task_keyset_status ON TASK(is_deleted, status_id, id);"
+    };
+    schema << counterTriggers();
+    if (!query.exec("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'TASK_FTS';"))
+        return false;
+    if (query.next())
+        schema << fullTextTriggers();
+    for (const QString &sql : schema) {
+        if (!query.exec(sql))
+            return false;
+    }
+    return true;
+}
+
+bool TaskRepository::migrateTrash(QSqlQuery &query)
+{
+    // Корзина: deleted_dt — когда задача удалена (для срока хранения и очистки порциями).
+    // Время удаления уже лежащих в корзине задач неизвестно — считаем, что сейчас.
+    //
+    // Ключи keyset-индексов раньше начинались с is_deleted; теперь это частичные индексы
+    // WHERE is_deleted = 0: корзина в них не попадает, они меньше, а условие живых задач в
+    // запросах (deletedFilter()) совпадает с их WHERE. Корзину читает свой частичный индекс.
+    QStringList schema = {
+        "ALTER TABLE TASK ADD COLUMN deleted_dt INTEGER;",
+        QStringLiteral("UPDATE TASK SET deleted_dt = %1 WHERE is_deleted <> 0;").arg(TimestampFormat::now()),
+        "DROP INDEX IF EXISTS idx_task_keyset_desc;",
+        "DROP INDEX IF EXISTS idx_task_keyset_details;",
+        "DROP INDEX IF EXISTS idx_task_keyset_created;",
+        "DROP INDEX IF EXISTS idx_task_keyset_completed;",
+        "DROP INDEX IF EXISTS idx_task_keyset_status;",
+        "CREATE INDEX idx_task_keyset_desc ON TASK(description, id) WHERE is_deleted = 0;",
+        "CREATE INDEX idx_task_keyset_details ON TASK(IFNULL(details, ''), id) WHERE is_deleted = 0;",
+        "CREATE INDEX idx_task_keyset_created ON TASK(IFNULL(creation_dt, 0), id) WHERE is_deleted = 0;",
+        "CREATE INDEX idx_task_keyset_completed ON TASK(IFNULL(completion_dt, 0), id) WHERE is_deleted = 0;",
+        "CREATE INDEX idx_task_keyset_status ON TASK(status_id, id) WHERE is_deleted = 0;",
+        "CREATE INDEX idx_task_trash ON TASK(deleted_dt, id) WHERE is_deleted = 1;"
+    };
+    for (const QString &sql : schema) {
+        if (!query.exec(sql))
+            return false;
+    }
+    return true;
+}
+
+bool TaskRepository::migrateChangeLog(QSqlQuery &query)
+{
+    // Журнал изменений TASK и STATUS для синхронизации между базами (см. TaskSync):
+    // seq — порядок на этом устройстве, hlc — время изменения (с миграции 12 — changed_ms),
+    // device — где изменено, version — номер версии строки. Индекс — последнее изменение поля
+    // (правило "последняя запись побеждает") и версия строки.
+    //
+    // uid — глобальный id задачи. Для уже существующих задач он выводится из (id, creation_dt):
+    // базы, которые раньше копировались целиком, получат одинаковые uid и не задвоятся при
+    // первой синхронизации.
+    QStringList schema = {
+        "CREATE TABLE SYNC_STATE (key TEXT PRIMARY KEY, value) WITHOUT ROWID;",
+        "CREATE TABLE CHANGE_LOG ("
+        "seq INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "entity TEXT NOT NULL, "
+        "uid TEXT NOT NULL, "
+        "field TEXT NOT NULL, "
+        "value, "
+        "hlc INTEGER NOT NULL, "
+        "device TEXT NOT NULL, "
+        "version INTEGER NOT NULL);",
+        "CREATE INDEX idx_change_row ON CHANGE_LOG(entity, uid, field, hlc);",
+        "ALTER TABLE TASK ADD COLUMN uid TEXT;",
+        "UPDATE TASK SET uid = 'L' || id || '.' || IFNULL(creation_dt, 0);",
+        "CREATE UNIQUE INDEX idx_task_uid ON TASK(uid);"
+    };
+    for (const QString &sql : schema) {
+        if (!query.exec(sql))
+            return false;
+    }
+
+    query.prepare("INSERT INTO SYNC_STATE (key, value) VALUES ('device_id', :device);");
+    query.bindValue(":device", deviceId());
+    if (!query.exec())
+        return false;
+    // Уже существующие строки попадают в журнал как вставки — первая синхронизация их передаст.
+    // Начальные статусы одинаковы везде: время 0, чтобы любое настоящее изменение было новее.
+    if (!query.exec("INSERT INTO CHANGE_LOG (entity, uid, field, value, hlc, device, version) "
+                    "SELECT 'TASK', uid, '*', NULL, IFNULL(creation_dt, 0), "
+                    "(SELECT value FROM SYNC_STATE WHERE key = 'device_id'), 1 FROM TASK ORDER BY id;")
+        || !query.exec("INSERT INTO CHANGE_LOG (entity, uid, field, value, hlc, device, version) "
+                       "SELECT 'STATUS', name, '*', NULL, 0, "
+                       "(SELECT value FROM SYNC_STATE WHERE key = 'device_id'), 1 FROM STATUS ORDER BY id;"))
+        return false;
+
+    const QStringList triggers = changeLogTriggers(QStringLiteral("hlc"));
+    for (const QString &sql : triggers) {
+        if (!query.exec(sql))
+            return false;
+    }
+    return true;
+}
+
+bool TaskRepository::migrateCollationKeys(QSqlQuery &query)
+{
+    // Сортировка текста по-русски вместо BINARY (заглавные после всех строчных, ё после я):
+    // ключи — вычисляемые столбцы (VIRTUAL: хранятся только в индексах, считаются при записи
+    // любым соединением, в том числе чужими программами), индексы сортировок — по ним.
+    // Ключ статуса дополнен самим именем: он уникален, как и name, поэтому сортировка по статусу
+    // по-прежнему идёт внешним циклом по STATUS без временного B-tree (см. sortFromClause()).
+    const QString detailsKey = collationKeyExpression(QStringLiteral("substr(IFNULL(details, ''), 1, %1)").arg(DetailsKeyChars));
+    const QStringList schema = {
+        QStringLiteral("ALTER TABLE TASK ADD COLUMN desc_key TEXT GENERATED ALWAYS AS (%1) VIRTUAL;")
+            .arg(collationKeyExpression(QStringLiteral("description"))),
+        QStringLiteral("ALTER TABLE TASK ADD COLUMN details_key TEXT GENERATED ALWAYS AS (%1) VIRTUAL;").arg(detailsKey),
+        QStringLiteral("ALTER TABLE STATUS ADD COLUMN sort_key TEXT GENERATED ALWAYS AS (%1 || char(1) || name) VIRTUAL;")
+            .arg(collationKeyExpression(QStringLiteral("name"))),
+        QStringLiteral("DROP INDEX IF EXISTS idx_task_keyset_desc;"),
+        QStringLiteral("DROP INDEX IF EXISTS idx_task_keyset_details;"),
+        QStringLiteral("CREATE INDEX idx_task_keyset_desc ON TASK(desc_key, id) WHERE is_deleted = 0;"),
+        QStringLiteral("CREATE INDEX idx_task_keyset_details ON TASK(details_key, id) WHERE is_deleted = 0;"),
+        QStringLiteral("CREATE UNIQUE INDEX idx_status_sort ON STATUS(sort_key);")
+    };
+    for (const QString &sql : schema) {
+        if (!query.exec(sql))
+            return false;
+    }
+    return true;
+}
+
+bool TaskRepository::migrateDetailsStorage(QSqlQuery &query)
+{
+    // Длинные "Описания" — сжатыми в отдельной таблице (см. storeCompressedDetails()); в TASK
+    // остаётся начало текста и details_size — длина полного (NULL — details и есть весь текст).
+    // Существующие длинные тексты сжимает обслуживание порциями (compactDetails()), не миграция.
+    const QStringList schema = {
+        QStringLiteral("ALTER TABLE TASK ADD COLUMN details_size INTEGER;"),
+        QStringLiteral("CREATE TABLE TASK_DETAILS ("
+                       "task_id INTEGER PRIMARY KEY, "
+                       "body BLOB NOT NULL);"),
+        // Кандидаты на сжатие — записанные мимо репозитория (импорт, синхронизация, чужие программы)
+        QStringLiteral("CREATE INDEX idx_task_details_large ON TASK(id) "
+                       "WHERE details_size IS NULL AND length(details) > %1;").arg(DetailsCompressChars),
+        QStringLiteral("CREATE TRIGGER trg_task_details_delete AFTER DELETE ON TASK "
+                       "WHEN OLD.details_size IS NOT NULL BEGIN "
+                       "DELETE FROM TASK_DETAILS WHERE task_id = OLD.id; "
+                       "END;"),
+        // Запись details без details_size (любым соединением) заменяет весь текст: сжатый больше не нужен
+        QStringLiteral("CREATE TRIGGER trg_task_details_expand AFTER UPDATE OF details ON TASK "
+                       "WHEN OLD.details_size IS NOT NULL AND NEW.details_size IS OLD.details_size BEGIN "
+                       "UPDATE TASK SET details_size = NULL WHERE id = NEW.id; "
+                       "DELETE FROM TASK_DETAILS WHERE task_id = NEW.id; "
+                       "END;"),
+        // Сжатие (смена details_size) — не правка текста: в журнал синхронизации не попадает.
+        // Остальные триггеры журнала уже есть — IF NOT EXISTS пересоздаёт только этот.
+        QStringLiteral("DROP TRIGGER IF EXISTS trg_task_log_update;")
+    };
+    for (const QString &sql : schema) {
+        if (!query.exec(sql))
+            return false;
+    }
+    const QStringList triggers = changeLogTriggers(
+        QStringLiteral("hlc"), QStringLiteral("OLD.details IS NOT NEW.details AND NEW.details_size IS OLD.details_size"));
+    for (const QString &sql : triggers) {
+        if (!query.exec(sql))
+            return false;
+    }
+    return true;
+}
+
+bool TaskRepository::migrateCounterIndex(QSqlQuery &query)
+{
+    // Сверка счётчиков (verifyCounters()) на каждом запуске: после миграции 7 индекс по статусу
+    // частичный (только живые задачи), и GROUP BY по всей TASK шёл полным проходом таблицы
+    // с временным B-деревом. Два целых на строку — проход по этому индексу без чтения TASK.
+    return query.exec(QStringLiteral("CREATE INDEX idx_task_status_counts ON TASK(is_deleted, status_id);"));
+}
+
+bool TaskRepository::migrateChangeTime(QSqlQuery &query)
+{
+    // CHANGE_LOG.hlc был не гибридными часами, а просто временем изменения по часам устройства
+    // (мс от эпохи): имя столбца обещало больше, чем он даёт. Переименование обновляет и индекс;
+    // триггеры журнала пересоздаются с новым именем.
+    const QStringList schema = {
+        QStringLiteral("ALTER TABLE CHANGE_LOG RENAME COLUMN hlc TO changed_ms;"),
+        QStringLiteral("DROP TRIGGER IF EXISTS trg_task_log_insert;"),
+        QStringLiteral("DROP TRIGGER IF EXISTS trg_task_log_update;"),
+        QStringLiteral("DROP TRIGGER IF EXISTS trg_task_log_delete;"),
+        QStringLiteral("DROP TRIGGER IF EXISTS trg_status_log_insert;"),
+        QStringLiteral("DROP TRIGGER IF EXISTS trg_status_log_delete;")
+    };
+    for (const QString &sql : schema) {
+        if (!query.exec(sql))
+            return false;
+    }
+    const QStringList triggers = changeLogTriggers(
+        QStringLiteral("changed_ms"), QStringLiteral("OLD.details IS NOT NEW.details AND NEW.details_size IS OLD.details_size"));
+    for (const QString &sql : triggers) {
+        if (!query.exec(sql))
+            return false;
+    }
+    return true;
+}
+
+bool TaskRepository::migrateDetailsFullText(QSqlQuery &query)
+{
+    // Длинное "Описание" теперь пишется сразу сжатым: в TASK — начало и details_size одним
+    // оператором, полный текст — строкой TASK_DETAILS (см. storeDetailsBody()). Из этого:
+    // - trg_task_details_expand убирает сжатый текст и при переходе к короткому (details_size = NULL);
+    // - журнал получает для сжатого текста ссылку из trg_task_details_log, а не весь текст;
+    //   trg_task_log_update пишет details, только когда новый текст хранится в TASK целиком;
+    // - полный текст длинных "Описаний" ищется по TASK_DETAILS_FTS: SQL не распаковывает
+    //   qCompress, поэтому индекс наполняет репозиторий, а удаляет по rowid триггер.
+    const QStringList schema = {
+        QStringLiteral("DROP TRIGGER IF EXISTS trg_task_details_expand;"),
+        QStringLiteral("CREATE TRIGGER trg_task_details_expand AFTER UPDATE OF details ON TASK "
+                       "WHEN OLD.details_size IS NOT NULL "
+                       "AND (NEW.details_size IS NULL OR NEW.details_size IS OLD.details_size) BEGIN "
+                       "UPDATE TASK SET details_size = NULL WHERE id = NEW.id AND details_size IS NOT NULL; "
+                       "DELETE FROM TASK_DETAILS WHERE task_id = NEW.id; "
+                       "END;"),
+        QStringLiteral("DROP TRIGGER IF EXISTS trg_task_log_update;"),
+        detailsBodyLogTrigger()
+    };
+    for (const QString &sql : schema) {
+        if (!query.exec(sql))
+            return false;
+    }
+    // Остальные триггеры журнала уже есть — IF NOT EXISTS пересоздаёт только trg_task_log_update
+    const QStringList triggers = changeLogTriggers(
+        QStringLiteral("changed_ms"),
+        QStringLiteral("(OLD.details IS NOT NEW.details AND NEW.details_size IS OLD.details_size) "
+                       "OR (OLD.details_size IS NOT NULL AND NEW.details_size IS NULL)"));
+    for (const QString &sql : triggers) {
+        if (!query.exec(sql))
+            return false;
+    }
+
+    // Без FTS5 (см. migrateFullText()) поиска нет вовсе — второй индекс не нужен
+    if (!query.exec("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'TASK_FTS';"))
+        return false;
+    if (!query.next())
+        return true;
+    query.finish();
+    // Текст хранится сжатым в TASK_DETAILS, индексу нужны только слова: contentless_delete
+    // (SQLite 3.43+) удаляет по rowid без исходного текста. На старом SQLite — обычная таблица
+    // FTS5 со своей копией длинных текстов.
+    if (!query.exec("CREATE VIRTUAL TABLE TASK_DETAILS_FTS USING fts5("
+                    "details, content='', contentless_delete=1, "
+                    "tokenize='unicode61 remove_diacritics 2', prefix='2 3');")) {
+        qWarning() << "Contentless full-text index is unavailable, storing long details in TASK_DETAILS_FTS:"
+                   << query.lastError().text();
+        if (!query.exec("CREATE VIRTUAL TABLE TASK_DETAILS_FTS USING fts5("
+                        "details, tokenize='unicode61 remove_diacritics 2', prefix='2 3');"))
+            return false;
+    }
+    if (!query.exec("CREATE TRIGGER trg_task_details_fts_delete AFTER DELETE ON TASK_DETAILS BEGIN "
+                    "DELETE FROM TASK_DETAILS_FTS WHERE rowid = OLD.task_id; "
+                    "END;"))
+        return false;
+
+    // Уже сжатые тексты — в индекс по одному (распаковка только на стороне приложения)
+    QSqlQuery bodies(m_db);
+    bodies.setForwardOnly(true);
+    if (!bodies.exec("SELECT task_id, body FROM TASK_DETAILS;")) {
+        qWarning() << "Failed to read compressed details:" << bodies.lastError().text();
+        return false;
+    }
+    query.prepare("INSERT INTO TASK_DETAILS_FTS (rowid, details) VALUES (:id, :details);");
+    while (bodies.next()) {
+        query.bindValue(":id", bodies.value(0));
+        query.bindValue(":details", expandDetails(bodies.value(1).toByteArray()));
+        if (!query.exec())
+            return false;
+    }
+    return true;
+}
+
+bool TaskRepository::migrateStatusDefault(QSqlQuery &query)
+{
+    // Сортировка по статусу соединяет TASK с STATUS внутренним CROSS JOIN (см. sortFromClause()),
+    // и задача без статуса пропала бы со страниц, из ленты и выгрузки, оставаясь в итогах.
+    // Приложение всегда пишет статус; NULL от чужих программ заменяется на "Запланировано"
+    // (или первый статус справочника) сразу после записи, существующие — здесь же.
+    const QString fallback = QStringLiteral("IFNULL((SELECT id FROM STATUS WHERE name = '%1'), (SELECT MIN(id) FROM STATUS))")
+                                 .arg(StatusRegistry::plannedName());
+    const QStringList schema = {
+        QStringLiteral("UPDATE TASK SET status_id = %1 WHERE status_id IS NULL;").arg(fallback),
+        QStringLiteral("CREATE TRIGGER trg_task_status_default_insert AFTER INSERT ON TASK "
+                       "WHEN NEW.status_id IS NULL BEGIN "
+                       "UPDATE TASK SET status_id = %1 WHERE id = NEW.id; "
+                       "END;").arg(fallback),
+        QStringLiteral("CREATE TRIGGER trg_task_status_default_update AFTER UPDATE OF status_id ON TASK "
+                       "WHEN NEW.status_id IS NULL BEGIN "
+                       "UPDATE TASK SET status_id = %1 WHERE id = NEW.id; "
+                       "END;").arg(fallback)
+    };
+    for (const QString &sql : schema) {
+        if (!query.exec(sql))
+            return false;
+    }
+    return true;
+}
+
+bool TaskRepository::updateDeviceId()
+{
+    // Без записи, если id не изменился (обычный запуск)
+    QSqlQuery q(m_db);
+    q.prepare("UPDATE SYNC_STATE SET value = :device WHERE key = 'device_id' AND value IS NOT :device;");
+    q.bindValue(":device", deviceId());
+    if (!q.exec()) {
+        m_lastError = q.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QString TaskRepository::deviceId()
+{
+    static const QString id = []() {
+        const QString path = QFileInfo(defaultDatabasePath()).absolutePath() + QStringLiteral("/device-id");
+        QFile file(path);
+        if (file.open(QIODevice::ReadOnly)) {
+            const QString stored = QString::fromLatin1(file.readAll()).trimmed();
+            if (!stored.isEmpty())
+                return stored;
+            file.close();
+        }
+        const QString created = QUuid::createUuid().toString(QUuid::WithoutBraces);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(created.toLatin1()) < 0)
+            qWarning() << "Failed to store device id in" << path;
+        return created;
+    }();
+    return id;
+}
+
+bool TaskRepository::ftsAvailable()
+{
+    // Проверяется при первом поиске, а не при запуске: актуальная база открывается без
+    // обращений к sqlite_master
+    if (!m_ftsChecked) {
+        QSqlQuery query(m_db);
+        m_ftsAvailable = query.exec("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'TASK_FTS';")
+            && query.next();
+        m_ftsChecked = true;
+    }
+    return m_ftsAvailable;
+}
+
+QString TaskRepository::ftsMatchExpression(const QString &text)
+{
+    // Ввод пользователя не разбираем как синтаксис FTS5 (кавычки, OR, NEAR, "-" и т.п.):
+    // каждое слово берём в кавычки, к последнему добавляем "*" — оно, скорее всего, ещё набирается.
+    const QStringList words = text.split(QRegularExpression(QStringLiteral("\\s+")), Qt::SkipEmptyParts);
+    QStringList terms;
+    for (const QString &word : words) {
+        QString escaped = word;
+        escaped.replace(QLatin1Char('"'), QLatin1String("\"\""));
+        terms << QStringLiteral("\"") + escaped + QStringLiteral("\"");
+    }
+    if (!terms.isEmpty())
+        terms.last() += QLatin1Char('*');
+    return terms.join(QLatin1Char(' '));
+}
+
+bool TaskRepository::reloadStatuses()
+{
+    QString error;
+    if (!StatusRegistry::load(m_db, &m_statuses, &error)) {
+        m_lastError = error;
+        qWarning() << "Failed to query STATUS list:" << error;
+        return false;
+    }
+    m_statusDoneId = m_statuses.id(StatusRegistry::doneName());
+    return true;
+}
+
+bool TaskRepository::statusesCover(const TaskPage &page) const
+{
+    for (int row = 0; row < page.rowCount(); ++row) {
+        const int statusId = page.statusId(row);
+        if (statusId != 0 && !m_statuses.contains(statusId))
+            return false;
+    }
+    return true;
+}
+
+TaskCounts TaskRepository::counts()
+{
+    TraceSpan span("sql.counts");
+    // Несколько строк TASK_STATS вместо полного прохода по TASK — цена не зависит от размера таблицы
+    TaskCounts result;
+    QSqlQuery countQ(m_db);
+    if (!countQ.exec("SELECT status_id, is_deleted, cnt FROM TASK_STATS WHERE cnt <> 0")) {
+        qWarning() << "Failed to read task counters:" << countQ.lastError().text();
+        return result;
+    }
+    while (countQ.next()) {
+        const int statusId = countQ.value(0).toInt();
+        const int count = countQ.value(2).toInt();
+        if (countQ.value(1).toInt() == 0) {
+            result.live += count;
+            result.liveByStatus[statusId] += count;
+        } else {
+            result.deleted += count;
+        }
+    }
+    return result;
+}
+
+int TaskRepository::countLive()
+{
+    return counts().live;
+}
+
+bool TaskRepository::rebuildCounters()
+{
+    QSqlQuery q(m_db);
+    if (!m_db.transaction())
+        qWarning() << "Failed to begin counters rebuild:" << m_db.lastError().text();
+    if (!fillCounters(q)) {
+        m_lastError = q.lastError().text();
+        qCritical() << "Failed to rebuild task counters:" << m_lastError;
+        m_db.rollback();
+        return false;
+    }
+    return m_db.commit();
+}
+
+bool TaskRepository::fillCounters(QSqlQuery &query)
+{
+    return query.exec("DELETE FROM TASK_STATS;")
+        && query.exec("INSERT INTO TASK_STATS (status_id, is_deleted, cnt) "
+                      "SELECT IFNULL(status_id, 0), IFNULL(is_deleted, 0), COUNT(*) FROM TASK "
+                      "GROUP BY IFNULL(status_id, 0), IFNULL(is_deleted, 0);");
+}
+
+bool TaskRepository::verifyCounters(bool *repaired)
+{
+    if (repaired)
+        *repaired = false;
+
+    // Фактические значения: GROUP BY в порядке покрывающего индекса idx_task_status_counts —
+    // проход по индексу, без чтения TASK и без временного B-дерева. Это единственный полный
+    // проход (около 0,1 с на 1 млн задач), и он идёт в потоке БД уже после первой страницы.
+    // Столбцы без IFNULL, иначе индекс не подойдёт: NULL сводим к 0 здесь, как триггеры.
+    QHash<QPair<int, int>, int> actual;
+    QSqlQuery q(m_db);
+    if (!q.exec("SELECT status_id, is_deleted, COUNT(*) FROM TASK GROUP BY is_deleted, status_id;")) {
+        m_lastError = q.lastError().text();
+        qWarning() << "Failed to verify task counters:" << m_lastError;
+        return false;
+    }
+    while (q.next())
+        actual[qMakePair(q.value(0).toInt(), q.value(1).toInt())] += q.value(2).toInt();
+
+    QHash<QPair<int, int>, int> stored;
+    if (!q.exec("SELECT status_id, is_deleted, cnt FROM TASK_STATS WHERE cnt <> 0;")) {
+        m_lastError = q.lastError().text();
+        qWarning() << "Failed to read task counters:" << m_lastError;
+        return false;
+    }
+    while (q.next())
+        stored.insert(qMakePair(q.value(0).toInt(), q.value(1).toInt()), q.value(2).toInt());
+
+    if (actual == stored)
+        return true;
+
+    qWarning() << "Task counters drifted from TASK contents, rebuilding...";
+    if (!rebuildCounters())
+        return false;
+    if (repaired)
+        *repaired = true;
+    return true;
+}
+
+QString TaskRepository::sortKeyExpression(int column)
+{
+    // Nullable-столбцы сводим к '' (даты — к 0) — так keyset-сравнения не спотыкаются о NULL,
+    // а выражение совпадает с индексом из initSchema().
+    switch (column) {
+        case TaskTableModel::COL_DESC: return QStringLiteral("TASK.desc_key");
+        case TaskTableModel::COL_DETAILS: return QStringLiteral("TASK.details_key");
+        case TaskTableModel::COL_COMPLETION_DT: return QStringLiteral("IFNULL(TASK.completion_dt, 0)");
+        case TaskTableModel::COL_STATUS: return QStringLiteral("STATUS.sort_key");
+        case TaskTableModel::COL_CREATION_DT:
+        default: return QStringLiteral("IFNULL(TASK.creation_dt, 0)");
+    }
+}
+
+QString TaskRepository::sortFromClause(int column)
+{
+    // Для сортировки по статусу STATUS идёт внешним циклом (CROSS JOIN фиксирует порядок),
+    // тогда строки выходят уже упорядоченными по (STATUS.sort_key, TASK.id) без временного B-tree.
+    // Соединение внутреннее: TASK.status_id не бывает NULL (см. migrateStatusDefault()).
+    return (column == TaskTableModel::COL_STATUS)
+        ? QStringLiteral("STATUS CROSS JOIN TASK ON TASK.status_id = STATUS.id")
+        : QStringLiteral("TASK LEFT JOIN STATUS ON TASK.status_id = STATUS.id");
+}
+
+bool TaskRepository::hasDateFilter(const PageRequest &request)
+{
+    return request.dateColumn == TaskTableModel::COL_CREATION_DT
+        || request.dateColumn == TaskTableModel::COL_COMPLETION_DT;
+}
+
+QString TaskRepository::dateFilterClause(const PageRequest &request)
+{
+    // Границы — целые числа, подставляются в текст запроса: так не нужно привязывать их
+    // в каждой ветке UNION runPageQuery(), а планировщик видит диапазон по индексу
+    if (!hasDateFilter(request))
+        return QString();
+    return QString("AND %1 >= %2 AND %1 < %3 ")
+        .arg(sortKeyExpression(request.dateColumn)).arg(request.dateFrom).arg(request.dateTo);
+}
+
+QString TaskRepository::deletedFilter(const PageRequest &request)
+{
+    return request.trash ? QStringLiteral("TASK.is_deleted = 1 ") : QStringLiteral("TASK.is_deleted = 0 ");
+}
+
+QString TaskRepository::listQuery(const PageRequest &request)
+{
+    // Тот же порядок, что у страниц (runPageQuery/runSearch), но весь список сразу: SQLite
+    // идёт по тому же индексу, а строки забираются по одной, без LIMIT/OFFSET.
+    // Даты отдаются уже в ISO 8601 (UTC, с миллисекундами) — так их понимает и TaskImporter.
+    const QString columns = QStringLiteral("TASK.id, TASK.description, TASK.details, STATUS.name, "
+                                           "strftime('%Y-%m-%dT%H:%M:%fZ', TASK.creation_dt / 1000.0, 'unixepoch'), "
+                                           "strftime('%Y-%m-%dT%H:%M:%fZ', TASK.completion_dt / 1000.0, 'unixepoch'), "
+                                           "TASK_DETAILS.body ");
+    const QString detailsJoin = QStringLiteral(" LEFT JOIN TASK_DETAILS ON TASK_DETAILS.task_id = TASK.id");
+    if (!request.search.trimmed().isEmpty()) {
+        // Совпадения в TASK_FTS и, для длинных "Описаний", в полном тексте (TASK_DETAILS_FTS);
+        // последний столбец — релевантность, по нему упорядочен список
+        const QString filter = deletedFilter(request) + dateFilterClause(request);
+        return "SELECT " + columns + ", TASK_FTS.rank AS match_rank "
+              "FROM TASK_FTS JOIN TASK ON TASK.id = TASK_FTS.rowid "
+              "LEFT JOIN STATUS ON TASK.status_id = STATUS.id" + detailsJoin
+            + " WHERE TASK_FTS MATCH :match AND " + filter
+            + "UNION ALL SELECT " + columns + ", TASK_DETAILS_FTS.rank "
+              "FROM TASK_DETAILS_FTS JOIN TASK ON TASK.id = TASK_DETAILS_FTS.rowid "
+              "LEFT JOIN STATUS ON TASK.status_id = STATUS.id" + detailsJoin
+            + " WHERE TASK_DETAILS_FTS MATCH :match AND " + detailsOnlyMatch() + " AND " + filter
+            + "ORDER BY match_rank, 1";
+    }
+    const bool descending = (request.sortColumn < 0) || request.sortOrder == Qt::DescendingOrder;
+    return QString("SELECT %1FROM %2 WHERE %3%4ORDER BY %5 %6, TASK.id %6")
+        .arg(columns, sortFromClause(request.sortColumn) + detailsJoin, deletedFilter(request), dateFilterClause(request),
+             sortKeyExpression(request.sortColumn), descending ? QStringLiteral("DESC") : QStringLiteral("ASC"));
+}
+
+int TaskRepository::countFiltered(const PageRequest &request)
+{
+    TraceSpan span("sql.countFiltered");
+    // Диапазон по индексу даты — цена пропорциональна числу попавших строк, а не размеру TASK
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    if (!q.exec("SELECT COUNT(*) FROM TASK WHERE " + deletedFilter(request) + dateFilterClause(request)) || !q.next()) {
+        m_lastError = q.lastError().text();
+        qWarning() << "Failed to count filtered tasks:" << m_lastError;
+        return -1;
+    }
+    return q.value(0).toInt();
+}
+
+QVariant TaskRepository::sortKeyValue(const TaskPage &page, int row, int column)
+{
+    // Текстовые ключи — как вычисляемые столбцы в SQL (см. migrateCollationKeys())
+    switch (column) {
+        case TaskTableModel::COL_DESC: return collationKey(page.text(row, column));
+        case TaskTableModel::COL_DETAILS: return collationKey(page.text(row, column), DetailsKeyChars);
+        case TaskTableModel::COL_STATUS: {
+            const QString name = page.statusName(row);
+            return QString(collationKey(name) + QChar(1) + name);
+        }
+        default: {
+            // Даты: IFNULL(..., 0) в SQL
+            const int dateColumn = (column == TaskTableModel::COL_COMPLETION_DT)
+                ? TaskPage::TEXT_COMPLETION_DT : TaskPage::TEXT_CREATION_DT;
+            const qint64 ms = page.dateMs(row, dateColumn);
+            return QVariant(ms == TimestampFormat::Null ? qint64(0) : ms);
+        }
+    }
+}
+
+QString TaskRepository::collationKey(const QString &text, int maxChars)
+{
+    // Пустая, но не null-строка: null QString привязался бы как NULL (в SQL — IFNULL(..., ''))
+    QString key(QStringLiteral(""));
+    key.reserve(text.size());
+    int chars = 0;
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const char16_t c = text.at(i).unicode();
+        // Суррогатная пара — один символ для substr()
+        if (QChar::isLowSurrogate(c) && i > 0 && QChar::isHighSurrogate(text.at(i - 1).unicode())) {
+            key.append(QChar(c));
+            continue;
+        }
+        if (maxChars >= 0 && chars++ >= maxChars)
+            break;
+        if ((c >= u'A' && c <= u'Z') || (c >= u'А' && c <= u'Я'))
+            key.append(QChar(char16_t(c + 0x20)));
+        else if (c == u'Ё' || c == u'ё')
+            key.append(QChar(u'е'));
+        else
+            key.append(QChar(c));
+    }
+    return key;
+}
+
+PageResult TaskRepository::fetchPage(const PageRequest &request, const std::function<bool()> &isCancelled)
+{
+    TraceSpan span("db.fetchPage");
+    // На время выборки progress handler спрашивает isCancelled (см. open())
+    InterruptScope interruptScope(m_interrupt, isCancelled);
+
+    PageResult result;
+    result.request = request;
+    result.counts = counts();
+    result.total = request.trash ? result.counts.deleted : result.counts.live;
+
+    if (!request.search.trimmed().isEmpty())
+        return runSearch(request, result, isCancelled, true);
+    if (hasDateFilter(request) && (result.total = countFiltered(request)) < 0) {
+        result.cancelled = isCancelled && isCancelled();
+        result.error = m_lastError;
+        return result;
+    }
+
+    PageRequest effective = request;
+    const int anchorId = (effective.seek == PageSeek::Forward) ? effective.lastId : effective.firstId;
+    if (effective.seek != PageSeek::First && anchorId < 0) {
+        effective.seek = PageSeek::First;
+        effective.steps = 0;
+        effective.page = 0;
+    }
+
+    // Страница могла опустеть (удалили последние строки), "вперёд" — уйти за конец списка,
+    // а "назад" — упереться в начало с неполной страницей. Каждый откат приближает к First,
+    // поэтому цикл конечен.
+    std::shared_ptr<TaskPage> page;
+    while (true) {
+        if (isCancelled && isCancelled()) {
+            result.cancelled = true;
+            return result;
+        }
+
+        page = std::make_shared<TaskPage>();
+        if (!runPageQuery(effective, *page, isCancelled)) {
+            result.cancelled = isCancelled && isCancelled();
+            result.error = m_lastError;
+            return result;
+        }
+
+        const int rows = page->rowCount();
+        if (effective.seek == PageSeek::First) {
+            if (rows == 0 && effective.steps > 0) {
+                effective.steps = 0;
+                effective.page = 0;
+                continue;
+            }
+            break;
+        }
+        if (rows == 0 && effective.seek == PageSeek::Forward) {
+            effective.seek = PageSeek::Reload;
+            effective.page = qMax(0, effective.page - effective.steps);
+            effective.steps = 0;
+            continue;
+        }
+        if (rows == 0 && effective.seek == PageSeek::Reload && effective.page > 0) {
+            effective.seek = PageSeek::Backward;
+            effective.steps = 1;
+            --effective.page;
+            continue;
+        }
+        if (rows == 0 || (effective.seek == PageSeek::Backward && rows < effective.pageSize)) {
+            effective.seek = PageSeek::First;
+            effective.steps = 0;
+            effective.page = 0;
+            continue;
+        }
+        break;
+    }
+
+    result.page = page;
+    result.pageIndex = effective.page;
+    result.ok = true;
+    return result;
+}
+
+PageResult TaskRepository::fetchBlock(const PageRequest &request, const std::function<bool()> &isCancelled)
+{
+    TraceSpan span("db.fetchBlock");
+    InterruptScope interruptScope(m_interrupt, isCancelled);
+
+    PageResult result;
+    result.request = request;
+    result.counts = counts();
+    result.total = request.trash ? result.counts.deleted : result.counts.live;
+
+    if (!request.search.trimmed().isEmpty())
+        return runSearch(request, result, isCancelled, false);
+    if (hasDateFilter(request) && (result.total = countFiltered(request)) < 0) {
+        result.cancelled = isCancelled && isCancelled();
+        result.error = m_lastError;
+        return result;
+    }
+
+    // Без откатов fetchPage(): пустой блок после якоря означает конец списка
+    auto page = std::make_shared<TaskPage>();
+    if (!runPageQuery(request, *page, isCancelled)) {
+        result.cancelled = isCancelled && isCancelled();
+        result.error = m_lastError;
+        return result;
+    }
+    result.page = page;
+    result.pageIndex = request.page;
+    result.ok = true;
+    return result;
+}
+
+PageResult TaskRepository::runSearch(const PageRequest &request, PageResult result,
+                                     const std::function<bool()> &isCancelled, bool clampPage)
+{
+    if (!ftsAvailable()) {
+        result.error = QStringLiteral("Полнотекстовый поиск недоступен");
+        return result;
+    }
+
+    // Порядок по релевантности (bm25) известен только после сопоставления всех совпадений,
+    // поэтому здесь keyset не даёт выигрыша: страницы — LIMIT/OFFSET поверх ранжированного списка.
+    // Число совпадений — отдельным запросом без highlight()/snippet(): оконная функция в
+    // основном запросе заставила бы строить фрагменты для всех найденных строк, а не для страницы.
+    const QString match = ftsMatchExpression(request.search);
+    const int pageSize = qMax(1, request.pageSize);
+
+    TraceSpan countSpan("sql.searchCount");
+    QSqlQuery countQ(m_db);
+    countQ.setForwardOnly(true);
+    countQ.prepare("SELECT COUNT(*) FROM (SELECT rowid AS id FROM TASK_FTS WHERE TASK_FTS MATCH :match "
+                   "UNION SELECT rowid FROM TASK_DETAILS_FTS WHERE TASK_DETAILS_FTS MATCH :match) AS found "
+                   "JOIN TASK ON TASK.id = found.id "
+                   "WHERE " + deletedFilter(request) + dateFilterClause(request));
+    countQ.bindValue(":match", match);
+    if (!countQ.exec() || !countQ.next()) {
+        result.cancelled = isCancelled && isCancelled();
+        result.error = m_lastError = countQ.lastError().text();
+        if (!result.cancelled)
+            qWarning() << "Failed to count search results:" << m_lastError;
+        return result;
+    }
+    result.total = countQ.value(0).toInt();
+    countSpan.setRows(result.total);
+    countSpan.finish();
+
+    // Номер страницы мог устареть (результатов стало меньше) — прижимаем к последней.
+    // Блоку ленты (clampPage = false) за концом списка положена пустая страница.
+    const int lastPage = qMax(0, (result.total + pageSize - 1) / pageSize - 1);
+    const int pageIndex = clampPage ? qBound(0, request.page, lastPage) : qMax(0, request.page);
+
+    // highlight()/snippet() размечают совпадения символами TaskPage::HighlightBegin/End.
+    // Найденное только в полном тексте длинного "Описания" (TASK_DETAILS_FTS) — без подсветки:
+    // в TASK хранится лишь начало текста.
+    TraceSpan pageSpan("sql.searchPage");
+    QSqlQuery pageQ(m_db);
+    pageQ.setForwardOnly(true);
+    pageQ.prepare(QString("SELECT TASK.id, TASK.description, %1, TASK.creation_dt, TASK.completion_dt, "
+                          "STATUS.name as status, TASK.is_deleted, "
+                          "highlight(TASK_FTS, 0, char(2), char(3)) AS desc_hl, "
+                          "snippet(TASK_FTS, 1, char(2), char(3), '…', %2) AS details_hl, "
+                          "TASK.status_id AS status_id, TASK_FTS.rank AS match_rank "
+                          "FROM TASK_FTS JOIN TASK ON TASK.id = TASK_FTS.rowid "
+                          "LEFT JOIN STATUS ON TASK.status_id = STATUS.id "
+                          "WHERE TASK_FTS MATCH :match AND %3%4"
+                          "UNION ALL "
+                          "SELECT TASK.id, TASK.description, %1, TASK.creation_dt, TASK.completion_dt, "
+                          "STATUS.name, TASK.is_deleted, NULL, NULL, TASK.status_id, TASK_DETAILS_FTS.rank "
+                          "FROM TASK_DETAILS_FTS JOIN TASK ON TASK.id = TASK_DETAILS_FTS.rowid "
+                          "LEFT JOIN STATUS ON TASK.status_id = STATUS.id "
+                          "WHERE TASK_DETAILS_FTS MATCH :match AND %7 AND %3%4"
+                          "ORDER BY match_rank, id LIMIT %5 OFFSET %6")
+                      .arg(detailsPreviewColumns()).arg(SnippetTokens).arg(deletedFilter(request), dateFilterClause(request))
+                      .arg(pageSize).arg(qint64(pageIndex) * pageSize).arg(detailsOnlyMatch()));
+    pageQ.bindValue(":match", match);
+    auto page = std::make_shared<TaskPage>();
+    if (!pageQ.exec()) {
+        result.cancelled = isCancelled && isCancelled();
+        result.error = m_lastError = pageQ.lastError().text();
+        if (!result.cancelled)
+            qWarning() << "Failed to query search results:" << m_lastError;
+        return result;
+    }
+    const bool complete = page->appendFromQuery(pageQ, isCancelled);
+    pageSpan.setRows(page->rowCount());
+    pageSpan.finish();
+    if (!complete) {
+        result.cancelled = true;
+        return result;
+    }
+
+    result.page = page;
+    result.pageIndex = pageIndex;
+    result.ok = true;
+    return result;
+}
+
+bool TaskRepository::runPageQuery(const PageRequest &request, TaskPage &page, const std::function<bool()> &isCancelled)
+{
+    // Keyset (seek) pagination: вместо LIMIT/OFFSET страница ищется по кортежу
+    // (ключ сортировки, id) соседней строки, поэтому любая страница стоит одинаково —
+    // SQLite спускается по индексу сразу к якорю, не перебирая предыдущие строки.
+    // OFFSET остаётся только для нескольких кликов подряд, схлопнутых в один запрос (steps > 1).
+    // По умолчанию (столбец не выбран) — новые задачи сверху.
+    const QString key = sortKeyExpression(request.sortColumn);
+    const bool descending = (request.sortColumn < 0) || request.sortOrder == Qt::DescendingOrder;
+    const int pageSize = qMax(1, request.pageSize);
+    const int steps = (request.seek == PageSeek::Reload) ? 1 : qMax(1, request.steps);
+
+    // Якорь: для "вперёд" — последняя видимая строка, для "назад" и перечитывания — первая.
+    const QVariant anchorKey = (request.seek == PageSeek::Forward) ? request.lastKey : request.firstKey;
+    const int anchorId = (request.seek == PageSeek::Forward) ? request.lastId : request.firstId;
+
+    // "Назад" идём против порядка отображения и затем разворачиваем страницу.
+    const bool walkDesc = (request.seek == PageSeek::Backward) ? !descending : descending;
+    const QString walk = walkDesc ? "DESC" : "ASC";
+    const QString cmp = walkDesc ? "<" : ">";
+
+    const QString from = sortFromClause(request.sortColumn);
+    const QString select = QString("SELECT TASK.id, TASK.description, %1, TASK.creation_dt, TASK.completion_dt, "
+                                   "STATUS.name as status, TASK.is_deleted, %2 AS sort_key, TASK.status_id AS status_id "
+                                   "FROM %3 WHERE %4%5")
+                               .arg(detailsPreviewColumns(), key, from, deletedFilter(request), dateFilterClause(request));
+
+    QString sql;
+    if (request.seek == PageSeek::First) {
+        sql = select + QString("ORDER BY %1 %2, TASK.id %2 LIMIT %3 OFFSET %4")
+                           .arg(key, walk).arg(pageSize).arg(qint64(qMax(0, request.steps)) * pageSize);
+    } else {
+        // Две ветки, каждая — один спуск по индексу:
+        //  1) "хвост" строк с тем же ключом, что у якоря, но дальше по id;
+        //  2) строки со следующими значениями ключа.
+        // При перечитывании сам якорь включается в страницу.
+        const QString tieCmp = (request.seek == PageSeek::Reload) ? cmp + "=" : cmp;
+        const qint64 window = qint64(steps) * pageSize;
+        sql = QString("SELECT * FROM (%1AND %2 = :tieKey AND TASK.id %3 :tieId ORDER BY TASK.id %4 LIMIT %5) "
+                      "UNION ALL "
+                      "SELECT * FROM (%1AND %2 %6 :nextKey ORDER BY %2 %4, TASK.id %4 LIMIT %5) "
+                      "ORDER BY sort_key %4, id %4 LIMIT %7 OFFSET %8")
+                  .arg(select, key, tieCmp, walk).arg(window).arg(cmp).arg(pageSize).arg(window - pageSize);
+    }
+    if (walkDesc != descending) {
+        sql = QString("SELECT * FROM (%1) ORDER BY sort_key %2, id %2").arg(sql, descending ? QStringLiteral("DESC") : QStringLiteral("ASC"));
+    }
+
+    TraceSpan span("sql.page");
+    QSqlQuery pageQ(m_db);
+    pageQ.setForwardOnly(true); // страница читается один раз, кешировать строки в QSqlQuery незачем
+    pageQ.prepare(sql);
+    if (request.seek != PageSeek::First) {
+        pageQ.bindValue(":tieKey", anchorKey);
+        pageQ.bindValue(":tieId", anchorId);
+        pageQ.bindValue(":nextKey", anchorKey);
+    }
+    if (!pageQ.exec()) {
+        m_lastError = pageQ.lastError().text();
+        qWarning() << "Failed to query task page:" << m_lastError;
+        return false;
+    }
+    const int before = page.rowCount();
+    const bool complete = page.appendFromQuery(pageQ, isCancelled);
+    span.setRows(page.rowCount() - before);
+    return complete;
+}
+
+void TaskRepository::resolveStatus(TaskRecord &task, const QString &fallbackName, int fallbackId)
+{
+    // Обычно GUI уже передаёт id из справочника — тогда запросов к STATUS нет вовсе.
+    // Незнакомый id/имя может означать, что STATUS изменили извне: перечитываем один раз.
+    auto lookup = [this, &task]() {
+        if (task.statusId >= 0 && m_statuses.contains(task.statusId))
+            return task.statusId;
+        return m_statuses.id(task.statusName);
+    };
+    int statusId = lookup();
+    if (statusId == -1 && reloadStatuses())
+        statusId = lookup();
+    if (statusId == -1 && !fallbackName.isEmpty())
+        statusId = m_statuses.id(fallbackName);
+    task.statusId = (statusId == -1) ? fallbackId : statusId;
+    task.statusName = m_statuses.name(task.statusId);
+}
+
+bool TaskRepository::insertTask(TaskRecord &task)
+{
+    TraceSpan span("sql.insert");
+    // 1. Получаем ID статуса по выбранному имени; если выбранный статус не найден,
+    // используем 'Запланировано' как рекомендованный по умолчанию, иначе fallback = 1.
+    resolveStatus(task, StatusRegistry::plannedName(), 1);
+    task.creationDt = TimestampFormat::now();
+
+    // Если задача создаётся сразу со статусом "Сделано", ставим completion_dt = creationTime
+    task.completionDt = (m_statusDoneId != -1 && task.statusId == m_statusDoneId) ? QVariant(task.creationDt) : QVariant();
+
+    // Длинное "Описание": в TASK — начало и длина, полный текст — сжатым в TASK_DETAILS
+    const bool compressed = task.details.size() > DetailsCompressChars;
+    std::optional<DetailsSavepoint> savepoint;
+    if (compressed) {
+        savepoint.emplace(m_db);
+        if (!savepoint->isOpen()) {
+            m_lastError = savepoint->error();
+            qCritical() << "Failed to insert new task:" << m_lastError;
+            return false;
+        }
+    }
+
+    // 2. Вставляем данные через прямой SQL-запрос
+    QSqlQuery insertQuery(m_db);
+    insertQuery.prepare("INSERT INTO TASK (description, details, details_size, creation_dt, completion_dt, status_id, is_deleted) "
+                "VALUES (:desc, :details, :details_size, :created, :completed, :status_id, 0)");
+    insertQuery.bindValue(":desc", task.description);
+    insertQuery.bindValue(":details", compressed ? inlineDetails(task.details) : task.details);
+    insertQuery.bindValue(":details_size", compressed ? QVariant(qlonglong(task.details.size())) : QVariant());
+    insertQuery.bindValue(":created", task.creationDt);
+    insertQuery.bindValue(":completed", task.completionDt);
+    insertQuery.bindValue(":status_id", task.statusId);
+
+    if (!insertQuery.exec()) {
+        m_lastError = insertQuery.lastError().text();
+        qCritical() << "Failed to insert new task:" << m_lastError;
+        return false;
+    }
+    task.id = insertQuery.lastInsertId().toInt();
+    if (compressed) {
+        const bool stored = storeDetailsBody(task.id, task.details);
+        if (!stored || !savepoint->release()) {
+            if (stored)
+                m_lastError = savepoint->error();
+            qCritical() << "Failed to store details of new task:" << m_lastError;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TaskRepository::updateTask(TaskRecord &task)
+{
+    TraceSpan span("sql.update");
+    resolveStatus(task, QString(), 1); // "В процессе" по умолчанию
+
+    // Если статус "Сделано", ставим текущую дату, иначе сбрасываем в NULL
+    task.completionDt = (task.statusId == m_statusDoneId)
+        ? QVariant(TimestampFormat::now())
+        : QVariant();
+
+    const bool compressed = task.details.size() > DetailsCompressChars;
+    std::optional<DetailsSavepoint> savepoint;
+    QSqlQuery updateQuery(m_db);
+    if (compressed) {
+        savepoint.emplace(m_db);
+        // Прежний сжатый текст той же длины: trg_task_details_expand принял бы запись за правку
+        // мимо репозитория. Сброс details_size — без записи, если длина другая.
+        updateQuery.prepare("UPDATE TASK SET details_size = NULL WHERE id = :id AND details_size = :size");
+        updateQuery.bindValue(":id", task.id);
+        updateQuery.bindValue(":size", qlonglong(task.details.size()));
+        if (!savepoint->isOpen() || !updateQuery.exec()) {
+            m_lastError = savepoint->isOpen() ? updateQuery.lastError().text() : savepoint->error();
+            qCritical() << "Failed to update task:" << m_lastError;
+            return false;
+        }
+    }
+
+    updateQuery.prepare("UPDATE TASK SET "
+                "description = :desc, "
+                "details = :details, "
+                "details_size = :details_size, "
+                "status_id = :status_id, "
+                "completion_dt = :completion_dt "
+                "WHERE id = :id");
+    updateQuery.bindValue(":desc", task.description);
+    updateQuery.bindValue(":details", compressed ? inlineDetails(task.details) : task.details);
+    updateQuery.bindValue(":details_size", compressed ? QVariant(qlonglong(task.details.size())) : QVariant());
+    updateQuery.bindValue(":status_id", task.statusId);
+    updateQuery.bindValue(":completion_dt", task.completionDt);
+    updateQuery.bindValue(":id", task.id);
+
+    if (!updateQuery.exec()) {
+        m_lastError = updateQuery.lastError().text();
+        qCritical() << "Failed to update task:" << m_lastError;
+        return false;
+    }
+    // Короткий текст: прежний сжатый удалил trg_task_details_expand
+    if (compressed) {
+        const bool stored = storeDetailsBody(task.id, task.details);
+        if (!stored || !savepoint->release()) {
+            if (stored)
+                m_lastError = savepoint->error();
+            qCritical() << "Failed to store details of task" << task.id << ":" << m_lastError;
+            return false;
+        }
+    }
+    return true;
+}
+
+QString TaskRepository::loadDetails(int id, bool *ok)
+{
+    TraceSpan span("sql.loadDetails");
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    q.prepare("SELECT TASK.details, TASK_DETAILS.body FROM TASK "
+              "LEFT JOIN TASK_DETAILS ON TASK_DETAILS.task_id = TASK.id WHERE TASK.id = :id;");
+    q.bindValue(":id", id);
+    if (!q.exec() || !q.next()) {
+        m_lastError = q.lastError().isValid() ? q.lastError().text() : QStringLiteral("Задача %1 не найдена").arg(id);
+        if (ok)
+            *ok = false;
+        return QString();
+    }
+    if (ok)
+        *ok = true;
+    return q.value(1).isNull() ? q.value(0).toString() : expandDetails(q.value(1).toByteArray());
+}
+
+QString TaskRepository::expandDetails(const QByteArray &body)
+{
+    return QString::fromUtf8(qUncompress(body));
+}
+
+bool TaskRepository::storeDetailsBody(int id, const QString &details)
+{
+    QSqlQuery q(m_db);
+    q.prepare("INSERT OR REPLACE INTO TASK_DETAILS (task_id, body) VALUES (:id, :body);");
+    q.bindValue(":id", id);
+    q.bindValue(":body", qCompress(details.toUtf8()));
+    if (!q.exec()) {
+        m_lastError = q.lastError().text();
+        return false;
+    }
+    if (!ftsAvailable())
+        return true;
+    // REPLACE не вызывает триггеры удаления (recursive_triggers выключены) — прежнюю запись
+    // индекса убираем сами
+    q.prepare("DELETE FROM TASK_DETAILS_FTS WHERE rowid = :id;");
+    q.bindValue(":id", id);
+    if (!q.exec()) {
+        m_lastError = q.lastError().text();
+        return false;
+    }
+    q.prepare("INSERT INTO TASK_DETAILS_FTS (rowid, details) VALUES (:id, :details);");
+    q.bindValue(":id", id);
+    q.bindValue(":details", details);
+    if (!q.exec()) {
+        m_lastError = q.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool TaskRepository::storeCompressedDetails(int id, const QString &details)
+{
+    // Сначала TASK_DETAILS: пока details_size ещё NULL, trg_task_details_log не считает это
+    // правкой. Смена details вместе с details_size не журналируется и trg_task_log_update.
+    if (!storeDetailsBody(id, details))
+        return false;
+    QSqlQuery q(m_db);
+    q.prepare("UPDATE TASK SET details = :details, details_size = :size WHERE id = :id;");
+    q.bindValue(":details", inlineDetails(details));
+    q.bindValue(":size", qlonglong(details.size()));
+    q.bindValue(":id", id);
+    if (!q.exec()) {
+        m_lastError = q.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+int TaskRepository::compactDetails(int limit)
+{
+    TraceSpan span("sql.compactDetails");
+    // Кандидаты — по частичному индексу idx_task_details_large (условие повторяет его WHERE
+    // дословно), без прохода по TASK
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    if (!q.exec(QStringLiteral("SELECT id, details FROM TASK WHERE details_size IS NULL AND length(details) > %1 LIMIT %2;")
+                    .arg(DetailsCompressChars).arg(limit))) {
+        m_lastError = q.lastError().text();
+        qWarning() << "Failed to find details to compress:" << m_lastError;
+        return -1;
+    }
+    QVector<QPair<int, QString>> rows;
+    while (q.next())
+        rows.append({ q.value(0).toInt(), q.value(1).toString() });
+    q.finish();
+    if (rows.isEmpty())
+        return 0;
+
+    if (!m_db.transaction()) {
+        m_lastError = m_db.lastError().text();
+        return -1;
+    }
+    for (const auto &row : rows) {
+        if (!storeCompressedDetails(row.first, row.second)) {
+            qWarning() << "Failed to compress details of task" << row.first << ":" << m_lastError;
+            m_db.rollback();
+            return -1;
+        }
+    }
+    if (!m_db.commit()) {
+        m_lastError = m_db.lastError().text();
+        m_db.rollback();
+        return -1;
+    }
+    span.setRows(int(rows.size()));
+    return int(rows.size());
+}
+
+bool TaskRepository::setTaskStatus(int id, int statusId)
+{
+    TraceSpan span("sql.setStatus");
+    QSqlQuery q(m_db);
+    q.prepare("UPDATE TASK SET status_id = :status_id, completion_dt = :completion_dt WHERE id = :id");
+    q.bindValue(":status_id", statusId);
+    q.bindValue(":completion_dt", (statusId == m_statusDoneId)
+                ? QVariant(TimestampFormat::now())
+                : QVariant());
+    q.bindValue(":id", id);
+    if (!q.exec()) {
+        m_lastError = q.lastError().text();
+        return false;
+    }
+    if (q.numRowsAffected() == 0) {
+        m_lastError = QStringLiteral("Задача %1 не найдена").arg(id);
+        return false;
+    }
+    return true;
+}
+
+bool TaskRepository::softDeleteTask(int id)
+{
+    TraceSpan span("sql.softDelete");
+    QSqlQuery q(m_db);
+    q.prepare("UPDATE TASK SET is_deleted = 1, deleted_dt = :deleted_dt WHERE id = :id");
+    q.bindValue(":deleted_dt", TimestampFormat::now());
+    q.bindValue(":id", id);
+    if (!q.exec()) {
+        m_lastError = q.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool TaskRepository::hardDeleteTask(int id)
+{
+    TraceSpan span("sql.hardDelete");
+    QSqlQuery q(m_db);
+    q.prepare("DELETE FROM TASK WHERE id = :id");
+    q.bindValue(":id", id);
+    if (!q.exec()) {
+        m_lastError = q.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool TaskRepository::setTasksStatus(const QVector<int> &ids, int statusId, int *affected)
+{
+    // completion_dt — по тому же правилу, что в updateTask(): "Сделано" — текущая дата, иначе NULL
+    const QVariant completionDt = (statusId == m_statusDoneId) ? QVariant(TimestampFormat::now()) : QVariant();
+    return execForIds("sql.bulkStatus",
+                      "UPDATE TASK SET status_id = :status_id, completion_dt = :completion_dt "
+                      "WHERE status_id IS NOT :same_status AND %1",
+                      ids, { { ":status_id", statusId }, { ":completion_dt", completionDt }, { ":same_status", statusId } },
+                      affected);
+}
+
+bool TaskRepository::softDeleteTasks(const QVector<int> &ids, int *affected)
+{
+    return execForIds("sql.bulkSoftDelete",
+                      "UPDATE TASK SET is_deleted = 1, deleted_dt = :deleted_dt WHERE is_deleted = 0 AND %1",
+                      ids, { { ":deleted_dt", TimestampFormat::now() } }, affected);
+}
+
+bool TaskRepository::restoreTasks(const QVector<int> &ids, int *affected)
+{
+    return execForIds("sql.bulkRestore", "UPDATE TASK SET is_deleted = 0, deleted_dt = NULL WHERE is_deleted = 1 AND %1",
+                      ids, {}, affected);
+}
+
+bool TaskRepository::hardDeleteTasks(const QVector<int> &ids, int *affected)
+{
+    return execForIds("sql.bulkHardDelete", "DELETE FROM TASK WHERE %1", ids, {}, affected);
+}
+
+int TaskRepository::purgeTrash(qint64 deletedBefore, int limit)
+{
+    TraceSpan span("sql.purgeTrash");
+    // Старейшие задачи корзины — по частичному индексу idx_task_trash, без прохода по TASK;
+    // LIMIT держит каждую порцию (и блокировку записи) короткой. Задачи без даты удаления
+    // (записанные синхронизацией или чужими программами) считаются самыми старыми. Две ветки —
+    // два спуска по индексу: условие через OR индекс читал бы до конца корзины.
+    QSqlQuery q(m_db);
+    q.prepare("DELETE FROM TASK WHERE id IN ("
+              "SELECT id FROM (SELECT id FROM TASK WHERE is_deleted = 1 AND deleted_dt IS NULL ORDER BY id LIMIT :limit) "
+              "UNION ALL "
+              "SELECT id FROM (SELECT id FROM TASK WHERE is_deleted = 1 AND deleted_dt < :before "
+              "ORDER BY deleted_dt, id LIMIT :limit) "
+              "LIMIT :limit)");
+    q.bindValue(":before", deletedBefore);
+    q.bindValue(":limit", limit);
+    if (!q.exec()) {
+        m_lastError = q.lastError().text();
+        qWarning() << "Failed to purge trash:" << m_lastError;
+        return -1;
+    }
+    const int rows = q.numRowsAffected();
+    span.setRows(rows);
+    return rows;
+}
+
+int TaskRepository::autoVacuumMode()
+{
+    QSqlQuery q(m_db);
+    if (!q.exec("PRAGMA auto_vacuum;") || !q.next()) {
+        m_lastError = q.lastError().text();
+        return -1;
+    }
+    return q.value(0).toInt();
+}
+
+bool TaskRepository::incrementalVacuum(int pages, int *freePages)
+{
+    TraceSpan span("sql.incrementalVacuum");
+    QSqlQuery q(m_db);
+    // Прагма освобождает по странице за шаг выполнения — дочитываем её до конца
+    if (!q.exec(QStringLiteral("PRAGMA incremental_vacuum(%1);").arg(pages))) {
+        m_lastError = q.lastError().text();
+        qWarning() << "Incremental vacuum failed:" << m_lastError;
+        return false;
+    }
+    while (q.next()) {
+    }
+    if (freePages) {
+        if (!q.exec("PRAGMA freelist_count;") || !q.next()) {
+            m_lastError = q.lastError().text();
+            return false;
+        }
+        *freePages = q.value(0).toInt();
+    }
+    return true;
+}
+
+bool TaskRepository::vacuum()
+{
+    TraceSpan span("sql.vacuum");
+    QSqlQuery q(m_db);
+    if (!q.exec("PRAGMA auto_vacuum = INCREMENTAL;") || !q.exec("VACUUM;")) {
+        m_lastError = q.lastError().text();
+        qCritical() << "VACUUM failed:" << m_lastError;
+        return false;
+    }
+    return true;
+}
+
+bool TaskRepository::execForIds(const char *spanName, const QString &statement, const QVector<int> &ids,
+                                const QVariantHash &bindings, int *affected)
+{
+    TraceSpan span(spanName);
+    if (affected)
+        *affected = 0;
+    if (ids.isEmpty())
+        return true;
+
+    QSqlQuery q(m_db);
+    QString idSet;
+    if (ids.size() <= BulkInlineIds) {
+        // id — целые числа, их можно подставить литералами: один оператор без сотен параметров
+        QStringList literals;
+        literals.reserve(ids.size());
+        for (int id : ids)
+            literals.append(QString::number(id));
+        idSet = QStringLiteral("id IN (%1)").arg(literals.join(QLatin1Char(',')));
+    } else {
+        // Большой набор — временная таблица (видна только этому соединению) и IN по ней:
+        // SQLite проходит по её первичному ключу, без разбора тысяч литералов
+        QVariantList values;
+        values.reserve(ids.size());
+        for (int id : ids)
+            values.append(id);
+        if (!q.exec("CREATE TEMP TABLE IF NOT EXISTS bulk_ids (id INTEGER PRIMARY KEY)")
+            || !q.exec("DELETE FROM temp.bulk_ids")
+            || !q.prepare("INSERT OR IGNORE INTO temp.bulk_ids (id) VALUES (?)")) {
+            m_lastError = q.lastError().text();
+            return false;
+        }
+        q.addBindValue(values);
+        if (!q.execBatch()) {
+            m_lastError = q.lastError().text();
+            return false;
+        }
+        idSet = QStringLiteral("id IN (SELECT id FROM temp.bulk_ids)");
+    }
+
+    q.prepare(statement.arg(idSet));
+    for (auto it = bindings.cbegin(); it != bindings.cend(); ++it)
+        q.bindValue(it.key(), it.value());
+    if (!q.exec()) {
+        m_lastError = q.lastError().text();
+        qCritical() << "Bulk update failed:" << m_lastError;
+        return false;
+    }
+    const int rows = q.numRowsAffected();
+    span.setRows(rows);
+    if (affected)
+        *affected = rows;
+    return true;
+}
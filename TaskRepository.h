@@ -0,0 +1,269 @@
+#ifndef TASKREPOSITORY_H
+#define TASKREPOSITORY_H
+
+#include <QHash>
+#include <QMetaType>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+#include "StatusRegistry.h"
+#include "StorageProfile.h"
+
+#include <functional>
+#include <memory>
+
+class QSqlQuery;
+class TaskPage;
+struct sqlite3;
+
+// Направление перехода при keyset-пагинации (относительно текущей страницы)
+enum class PageSeek {
+    First,    // от начала списка для текущей сортировки
+    Forward,  // вперёд: строки строго после последней видимой
+    Backward, // назад: строки строго перед первой видимой
+    Reload    // перечитать текущую страницу, начиная с первой видимой строки
+};
+
+// Запрос страницы. Якоря — (ключ сортировки, id) первой и последней строки видимой страницы.
+struct PageRequest {
+    int sortColumn = -1; // TaskTableModel::Column; -1 — по умолчанию (новые сверху)
+    Qt::SortOrder sortOrder = Qt::AscendingOrder;
+    int pageSize = 10;
+    int page = 0;        // номер целевой страницы (для подписи "Стр. N / M")
+    PageSeek seek = PageSeek::First;
+    int steps = 0;       // на сколько страниц сдвинуться от якоря (или от начала для First)
+    QVariant firstKey;
+    int firstId = -1;
+    QVariant lastKey;
+    int lastId = -1;
+    quint64 generation = 0; // номер запроса для схлопывания устаревших (см. TaskDataService)
+    QString search;      // непусто — полнотекстовый поиск: порядок по релевантности, сортировка и якоря не учитываются
+    // Фильтр по дате: столбец COL_CREATION_DT/COL_COMPLETION_DT (-1 — без фильтра) и полуинтервал
+    // [dateFrom, dateTo) в мс от эпохи (UTC). Задачи без даты выполнения под фильтр не попадают.
+    int dateColumn = -1;
+    qint64 dateFrom = 0;
+    qint64 dateTo = 0;
+    bool trash = false;  // корзина: удалённые задачи (is_deleted = 1) вместо живых
+};
+
+// Итоги по задачам из таблицы счётчиков TASK_STATS (обновляется триггерами)
+struct TaskCounts {
+    int live = 0;
+    int deleted = 0;
+    QHash<int, int> liveByStatus; // status_id → число живых задач
+};
+
+struct PageResult {
+    PageRequest request;
+    std::shared_ptr<TaskPage> page;
+    int pageIndex = 0;   // фактический номер страницы (после отката с пустой страницы)
+    int total = 0;       // всего живых задач (при поиске или фильтре по дате — найденных)
+    TaskCounts counts;
+    bool ok = false;
+    bool cancelled = false;
+    QString error;
+};
+
+// Задача для вставки/обновления. Поля creationDt/completionDt (мс от эпохи, UTC) заполняет
+// репозиторий; статус задаётся id (statusName — запасной вариант и заполняется по справочнику).
+struct TaskRecord {
+    int id = -1;
+    QString description;
+    QString details;
+    QString statusName;
+    int statusId = -1;
+    qint64 creationDt = 0;
+    QVariant completionDt; // qint64; NULL, пока задача не "Сделано"
+};
+
+// Синхронный доступ к tracker.db через одно именованное соединение.
+// Живёт в том потоке, где создано соединение (см. DatabaseWorker): QSqlDatabase нельзя
+// использовать из других потоков.
+class TaskRepository
+{
+public:
+    explicit TaskRepository(const QString &connectionName);
+    ~TaskRepository();
+
+    TaskRepository(const TaskRepository &) = delete;
+    TaskRepository &operator=(const TaskRepository &) = delete;
+
+    // Путь к %AppData%/SelfImprovementApp/tracker.db (каталог создаётся при необходимости)
+    static QString defaultDatabasePath();
+    // Постоянный id устройства для журнала изменений (см. TaskSync): хранится рядом с базой
+    // в %AppData%/…/device-id, а не в самой базе — копия tracker.db на другой машине получит свой
+    static QString deviceId();
+
+    // Открывает соединение и применяет профиль хранения (WAL, synchronous, кэши — см. StorageProfile).
+    // Читателю (ConnectionRole::Reader) схема не нужна: initSchema() вызывает только писатель.
+    bool open(const QString &path, ConnectionRole role = ConnectionRole::Standalone,
+              const StorageProfile &profile = StorageProfile::fromEnvironment());
+    void close();
+    bool isOpen() const;
+    QSqlDatabase database() const { return m_db; }
+    QString lastError() const { return m_lastError; }
+    // Хэндл SQLite C API открытого соединения; nullptr, если API недоступен
+    sqlite3 *handle() const { return m_handle; }
+
+    // Номер актуальной схемы (PRAGMA user_version) — число миграций в initSchema()
+    static constexpr int SchemaVersion = 14;
+
+    // Приводит схему к актуальной недостающими миграциями (каждая — один раз, в транзакции)
+    // и читает справочник статусов. Актуальная база открывается одним чтением user_version.
+    bool initSchema();
+
+    // Справочник статусов в памяти; перечитывается, только когда меняется STATUS
+    const StatusRegistry &statuses() const { return m_statuses; }
+    bool reloadStatuses();
+    // Есть ли в справочнике все статусы страницы (иначе STATUS изменили извне — пора перечитать)
+    bool statusesCover(const TaskPage &page) const;
+    QStringList statusNames() const { return m_statuses.names(); }
+    int statusIdByName(const QString &name) const { return m_statuses.id(name); } // -1, если статус не найден
+    int doneStatusId() const { return m_statusDoneId; }
+
+    // PRAGMA wal_checkpoint: PASSIVE не ждёт читателей; TRUNCATE ещё и обнуляет файл WAL
+    // (при закрытии). walPages — сколько страниц было в журнале до checkpoint.
+    bool checkpoint(bool truncate, int *walPages = nullptr);
+    // PRAGMA data_version: меняется, только когда изменения зафиксировало другое соединение
+    // (другой процесс или поток), собственные записи соединения его не меняют. -1 — ошибка.
+    int dataVersion();
+
+    // Итоги за O(1): читаются из TASK_STATS, а не через COUNT(*) по TASK
+    TaskCounts counts();
+    int countLive();
+    // Сверяет TASK_STATS с фактическим содержимым TASK и при расхождении пересчитывает
+    bool verifyCounters(bool *repaired = nullptr);
+    bool rebuildCounters();
+    // isCancelled проверяется и во время выполнения самого запроса (progress handler SQLite),
+    // если доступен SQLite C API, иначе — между строками результата
+    PageResult fetchPage(const PageRequest &request, const std::function<bool()> &isCancelled = {});
+
+    // Блок ленты (TaskScrollModel): ровно запрошенная выборка, без откатов на соседние страницы.
+    // Для поиска request.page — номер блока.
+    PageResult fetchBlock(const PageRequest &request, const std::function<bool()> &isCancelled = {});
+
+    // Полнотекстовый индекс TASK_FTS (FTS5) по description и details; полный текст длинных
+    // "Описаний" — в TASK_DETAILS_FTS (есть всегда, когда есть TASK_FTS)
+    bool ftsAvailable();
+    // Строка из поля поиска → выражение MATCH: каждое слово — фраза в кавычках, последнее — префикс
+    static QString ftsMatchExpression(const QString &text);
+
+    // Хранение "Описания" (details). Страницы берут только первые DetailsPreviewChars символов
+    // и признак "текст длиннее" (TaskPage::hasMoreDetails()); целиком текст читает loadDetails().
+    // Текст длиннее DetailsCompressChars хранится сжатым (qCompress от UTF-8) в TASK_DETAILS,
+    // а в TASK.details остаются первые DetailsInlineChars — по ним работают сортировка и подсветка
+    // совпадений; поиск идёт и по полному тексту (TASK_DETAILS_FTS).
+    static constexpr int DetailsPreviewChars = 256;
+    static constexpr int DetailsInlineChars = 2048;
+    static constexpr int DetailsCompressChars = 8192;
+    // Полный текст "Описания" задачи; ok = false — задачи нет или ошибка чтения
+    QString loadDetails(int id, bool *ok = nullptr);
+    // TASK_DETAILS.body → текст (для читателей, которые сами присоединяют TASK_DETAILS)
+    static QString expandDetails(const QByteArray &body);
+    // Сжимает не больше limit длинных "Описаний", записанных мимо insertTask()/updateTask()
+    // (импорт, синхронизация, старые базы). Возвращает число строк или -1 при ошибке.
+    int compactDetails(int limit);
+
+    bool insertTask(TaskRecord &task);
+    bool updateTask(TaskRecord &task);
+    // Смена статуса без перезаписи текста; completion_dt — как в updateTask(). false, если задачи нет.
+    bool setTaskStatus(int id, int statusId);
+    bool softDeleteTask(int id);
+    bool hardDeleteTask(int id);
+
+    // Массовые операции над набором id — один оператор UPDATE/DELETE на весь набор (триггеры
+    // счётчиков и TASK_FTS срабатывают построчно внутри него). До BulkInlineIds id подставляются
+    // в "id IN (...)", больший набор — через временную таблицу temp.bulk_ids. Транзакцию
+    // открывает вызывающий (DatabaseWorker — пачка журнала правок). affected — изменено строк.
+    static constexpr int BulkInlineIds = 500;
+    // Строки, уже стоящие в этом статусе, не трогаются (их completion_dt сохраняется)
+    bool setTasksStatus(const QVector<int> &ids, int statusId, int *affected = nullptr);
+    bool softDeleteTasks(const QVector<int> &ids, int *affected = nullptr);
+    bool restoreTasks(const QVector<int> &ids, int *affected = nullptr);
+    bool hardDeleteTasks(const QVector<int> &ids, int *affected = nullptr);
+
+    // Очистка корзины порциями: удаляет не больше limit задач, удалённых раньше deletedBefore
+    // (мс от эпохи), старые — первыми. Возвращает число удалённых строк или -1 при ошибке.
+    int purgeTrash(qint64 deletedBefore, int limit);
+    // PRAGMA auto_vacuum: 0 — NONE, 1 — FULL, 2 — INCREMENTAL (-1 — ошибка)
+    int autoVacuumMode();
+    // Возвращает файлу не больше pages свободных страниц (только при auto_vacuum = INCREMENTAL);
+    // freePages — сколько свободных страниц осталось после шага
+    bool incrementalVacuum(int pages, int *freePages = nullptr);
+    // Полный VACUUM с переводом базы в auto_vacuum = INCREMENTAL. Долгий и блокирует запись —
+    // только из консоли, не из приложения.
+    bool vacuum();
+
+    // Выражение ключа сортировки для столбца и его значение для строки страницы
+    static QString sortKeyExpression(int column);
+    static QVariant sortKeyValue(const TaskPage &page, int row, int column);
+    // Ключ сравнения текста для сортировки — то же, что вычисляемые столбцы desc_key/details_key/
+    // STATUS.sort_key (миграция 9): регистр не различается, ё = е; maxChars — первые символы
+    // (кодовые точки, как substr() в SQLite), -1 — весь текст
+    static QString collationKey(const QString &text, int maxChars = -1);
+    static QString sortFromClause(int column);
+    // Условие фильтра по дате ("AND ..." или пустая строка) — по тому же выражению, что и
+    // ключ сортировки, поэтому диапазон ищется по индексу idx_task_keyset_created/completed
+    static bool hasDateFilter(const PageRequest &request);
+    static QString dateFilterClause(const PageRequest &request);
+    // Живые задачи или корзина — условие совпадает с WHERE частичных индексов (см. migrateTrash())
+    static QString deletedFilter(const PageRequest &request);
+    // Весь список живых задач в порядке страниц (сортировка или поиск из request, без LIMIT):
+    // id, description, details, имя статуса, creation_dt, completion_dt (даты — ISO 8601, UTC)
+    // и сжатый полный текст TASK_DETAILS.body (NULL, если details полный; см. expandDetails()).
+    // При поиске — параметр :match (см. ftsMatchExpression()) и последним столбцом релевантность.
+    static QString listQuery(const PageRequest &request);
+
+private:
+    bool runPageQuery(const PageRequest &request, TaskPage &page, const std::function<bool()> &isCancelled);
+    PageResult runSearch(const PageRequest &request, PageResult result,
+                         const std::function<bool()> &isCancelled, bool clampPage);
+    // Число живых задач под фильтром по дате (счётчики TASK_STATS его не учитывают); -1 — ошибка
+    int countFiltered(const PageRequest &request);
+    int schemaVersion();
+    bool migrateBaseTables(QSqlQuery &query);
+    bool migrateKeysetIndexes(QSqlQuery &query);
+    bool migrateCounters(QSqlQuery &query);
+    bool migrateFullText(QSqlQuery &query);
+    bool migrateStatuses(QSqlQuery &query);
+    bool migrateEpochTimestamps(QSqlQuery &query);
+    bool migrateTrash(QSqlQuery &query);
+    bool migrateChangeLog(QSqlQuery &query);
+    bool migrateCollationKeys(QSqlQuery &query);
+    bool migrateDetailsStorage(QSqlQuery &query);
+    bool migrateCounterIndex(QSqlQuery &query);
+    bool migrateChangeTime(QSqlQuery &query);
+    bool migrateDetailsFullText(QSqlQuery &query);
+    bool migrateStatusDefault(QSqlQuery &query);
+    // Сжатый полный текст в TASK_DETAILS и в индекс TASK_DETAILS_FTS (TASK не трогает)
+    bool storeDetailsBody(int id, const QString &details);
+    // Сжатие уже записанного текста: переносит его в TASK_DETAILS, в TASK.details оставляет начало
+    bool storeCompressedDetails(int id, const QString &details);
+    // SYNC_STATE.device_id — id этого устройства (триггеры журнала подписывают им изменения)
+    bool updateDeviceId();
+    bool fillCounters(QSqlQuery &query);
+    static int progressCallback(void *self);
+    void resolveStatus(TaskRecord &task, const QString &fallbackName, int fallbackId);
+    // statement содержит %1 на месте условия по набору id; bindings — именованные параметры
+    bool execForIds(const char *spanName, const QString &statement, const QVector<int> &ids,
+                    const QVariantHash &bindings, int *affected);
+
+    QString m_connectionName;
+    QSqlDatabase m_db;
+    QString m_lastError;
+    StatusRegistry m_statuses;
+    int m_statusDoneId;
+    bool m_ftsAvailable;
+    bool m_ftsChecked;
+    sqlite3 *m_handle; // nullptr, если SQLite C API недоступен (см. sqliteHandle())
+    std::function<bool()> m_interrupt; // прерывание текущего запроса из progress handler
+};
+
+Q_DECLARE_METATYPE(PageRequest)
+Q_DECLARE_METATYPE(PageResult)
+Q_DECLARE_METATYPE(TaskRecord)
+
+#endif // TASKREPOSITORY_H
@@ -0,0 +1,347 @@
+#include "TaskScrollModel.h"
+#include "TaskPage.h"
+
+#include <QSet>
+
+#include <algorithm>
+
+namespace {
+// Сравнение ключей сортировки как в SQLite: даты — числа, текстовые ключи — байты UTF-8
+// (BINARY), а не UTF-16 кодовые единицы QString
+int compareKeys(const QVariant &a, const QVariant &b)
+{
+    if (a.typeId() == QMetaType::QString || b.typeId() == QMetaType::QString) {
+        const QByteArray left = a.toString().toUtf8();
+        const QByteArray right = b.toString().toUtf8();
+        return left < right ? -1 : (right < left ? 1 : 0);
+    }
+    const qint64 left = a.toLongLong();
+    const qint64 right = b.toLongLong();
+    return left < right ? -1 : (right < left ? 1 : 0);
+}
+}
+
+TaskScrollModel::TaskScrollModel(QObject *parent)
+    : TaskTableModel(parent)
+    , m_rowCount(0)
+    , m_total(0)
+    , m_atEnd(true)
+    , m_appending(false)
+    , m_visibleFirstBlock(0)
+    , m_visibleLastBlock(0)
+{
+}
+
+TaskScrollModel::~TaskScrollModel() = default;
+
+void TaskScrollModel::reset(const PageRequest &base)
+{
+    clear();
+    m_base = base;
+    m_atEnd = false;
+    requestBlock(0);
+}
+
+void TaskScrollModel::clear()
+{
+    beginResetModel();
+    m_blocks.clear();
+    m_rowCount = 0;
+    m_total = 0;
+    m_atEnd = true;
+    m_appending = false;
+    m_visibleFirstBlock = m_visibleLastBlock = 0;
+    endResetModel();
+}
+
+int TaskScrollModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rowCount;
+}
+
+bool TaskScrollModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !m_atEnd;
+}
+
+void TaskScrollModel::fetchMore(const QModelIndex &parent)
+{
+    if (!parent.isValid() && !m_atEnd && !m_appending)
+        requestBlock(int(m_blocks.size()));
+}
+
+int TaskScrollModel::rowForId(int id) const
+{
+    for (int b = 0; b < m_blocks.size(); ++b) {
+        if (!m_blocks[b].page)
+            continue;
+        const int row = m_blocks[b].page->rowForId(id);
+        if (row >= 0 && row < m_blocks[b].rows)
+            return m_blocks[b].firstRow + row;
+    }
+    return -1;
+}
+
+int TaskScrollModel::loadedRows() const
+{
+    int rows = 0;
+    for (const Block &block : m_blocks) {
+        if (block.page)
+            rows += block.rows;
+    }
+    return rows;
+}
+
+TaskPage *TaskScrollModel::pageForRow(int row, int *pageRow) const
+{
+    if (row < 0 || row >= m_rowCount)
+        return nullptr;
+    const Block &block = m_blocks[blockForRow(row)];
+    const int local = row - block.firstRow;
+    // Перечитанный блок мог оказаться короче (строки удалили) — недостающие строки пустые
+    if (!block.page || local >= block.page->rowCount())
+        return nullptr;
+    *pageRow = local;
+    return block.page.get();
+}
+
+int TaskScrollModel::blockForRow(int row) const
+{
+    // Последний блок, начинающийся не позже row: опустевшие блоки (firstRow как у следующего)
+    // так пропускаются сами
+    const auto it = std::upper_bound(m_blocks.cbegin(), m_blocks.cend(), row,
+                                     [](int r, const Block &block) { return r < block.firstRow; });
+    return int(it - m_blocks.cbegin()) - 1;
+}
+
+void TaskScrollModel::setVisibleRows(int firstRow, int lastRow)
+{
+    if (m_blocks.isEmpty())
+        return;
+    m_visibleFirstBlock = qBound(0, blockForRow(firstRow), int(m_blocks.size()) - 1);
+    m_visibleLastBlock = qBound(m_visibleFirstBlock, blockForRow(lastRow), int(m_blocks.size()) - 1);
+
+    // Видимые блоки и по одному соседу — перечитываем выгруженные
+    for (int b = qMax(0, m_visibleFirstBlock - 1); b <= qMin(int(m_blocks.size()) - 1, m_visibleLastBlock + 1); ++b) {
+        if (!m_blocks[b].page && !m_blocks[b].loading)
+            requestBlock(b);
+    }
+    // Упреждающая загрузка по направлению прокрутки: представление попросит fetchMore()
+    // только у самого конца, а блок должен успеть прийти раньше
+    if (!m_atEnd && !m_appending && m_visibleLastBlock + PrefetchBlocks >= m_blocks.size())
+        requestBlock(int(m_blocks.size()));
+
+    evictOutside(m_visibleFirstBlock - KeepBlocks, m_visibleLastBlock + KeepBlocks + PrefetchBlocks);
+}
+
+void TaskScrollModel::evictOutside(int firstBlock, int lastBlock)
+{
+    for (int b = 0; b < m_blocks.size(); ++b) {
+        if ((b < firstBlock || b > lastBlock) && m_blocks[b].page)
+            m_blocks[b].page.reset();
+    }
+}
+
+void TaskScrollModel::requestBlock(int index)
+{
+    PageRequest request;
+    request.sortColumn = m_base.sortColumn;
+    request.sortOrder = m_base.sortOrder;
+    request.search = m_base.search;
+    request.dateColumn = m_base.dateColumn;
+    request.dateFrom = m_base.dateFrom;
+    request.dateTo = m_base.dateTo;
+    request.trash = m_base.trash;
+    request.pageSize = BlockSize;
+    request.page = index;
+
+    if (index >= m_blocks.size()) {
+        // Следующий блок в конец: от последней строки предыдущего (или с начала списка)
+        if (m_appending)
+            return;
+        if (index == 0) {
+            request.seek = PageSeek::First;
+        } else {
+            const Block &last = m_blocks.last();
+            request.seek = PageSeek::Forward;
+            request.steps = 1;
+            request.lastKey = last.lastKey;
+            request.lastId = last.lastId;
+        }
+        m_appending = true;
+    } else {
+        // Выгруженный блок: перечитываем с его первой строки (в блок могли вставить строки —
+        // читаем столько, сколько в нём сейчас)
+        Block &block = m_blocks[index];
+        request.pageSize = qMax(int(BlockSize), block.rows);
+        request.seek = PageSeek::Reload;
+        request.steps = 1;
+        request.firstKey = block.firstKey;
+        request.firstId = block.firstId;
+        block.loading = true;
+    }
+    emit blockRequested(request);
+}
+
+void TaskScrollModel::applyBlock(const PageResult &result)
+{
+    const int index = result.request.page;
+    const bool append = (index == m_blocks.size());
+    if (append)
+        m_appending = false;
+    else if (index >= 0 && index < m_blocks.size())
+        m_blocks[index].loading = false;
+    else
+        return;
+
+    if (!result.ok) {
+        // Конец ленты, чтобы представление не повторяло запрос бесконечно
+        if (append)
+            m_atEnd = true;
+        return;
+    }
+    m_total = result.total;
+
+    const TaskPage &page = *result.page;
+    const int rows = page.rowCount();
+    if (append) {
+        if (rows < BlockSize)
+            m_atEnd = true;
+        if (rows == 0)
+            return;
+
+        Block block;
+        block.page = result.page;
+        block.firstRow = m_rowCount;
+        block.rows = rows;
+        block.firstKey = TaskRepository::sortKeyValue(page, 0, m_base.sortColumn);
+        block.firstId = page.taskId(0);
+        block.lastKey = TaskRepository::sortKeyValue(page, rows - 1, m_base.sortColumn);
+        block.lastId = page.taskId(rows - 1);
+
+        beginInsertRows(QModelIndex(), m_rowCount, m_rowCount + rows - 1);
+        m_blocks.append(block);
+        m_rowCount += rows;
+        endInsertRows();
+    } else {
+        // Число строк блока не меняем (иначе сдвинулись бы номера всех следующих строк);
+        // якорь конца сохраняем прежним — по нему загружен следующий блок
+        Block &block = m_blocks[index];
+        block.page = result.page;
+        if (block.rows > 0) {
+            emit dataChanged(this->index(block.firstRow, 0),
+                             this->index(block.firstRow + block.rows - 1, COLUMN_COUNT - 1));
+        }
+    }
+    evictOutside(m_visibleFirstBlock - KeepBlocks, m_visibleLastBlock + KeepBlocks + PrefetchBlocks);
+}
+
+int TaskScrollModel::removeTasks(const QVector<int> &ids)
+{
+    const QSet<int> removed(ids.cbegin(), ids.cend());
+    int count = 0;
+    for (int b = int(m_blocks.size()) - 1; b >= 0; --b) {
+        Block &block = m_blocks[b];
+        if (!block.page)
+            continue;
+        TaskPage &page = *block.page;
+        // Подряд идущие строки — одним диапазоном, снизу вверх
+        for (int row = qMin(block.rows, page.rowCount()) - 1; row >= 0;) {
+            if (!removed.contains(page.taskId(row))) {
+                --row;
+                continue;
+            }
+            int first = row;
+            while (first > 0 && removed.contains(page.taskId(first - 1)))
+                --first;
+            const int n = row - first + 1;
+            beginRemoveRows(QModelIndex(), block.firstRow + first, block.firstRow + row);
+            for (int r = row; r >= first; --r)
+                page.removeRow(r);
+            block.rows -= n;
+            for (int next = b + 1; next < m_blocks.size(); ++next)
+                m_blocks[next].firstRow -= n;
+            m_rowCount -= n;
+            endRemoveRows();
+            count += n;
+            row = first - 1;
+        }
+    }
+    m_total = qMax(0, m_total - count);
+    return count;
+}
+
+TaskScrollModel::InsertResult TaskScrollModel::insertSorted(const TaskPage &source, int sourceRow)
+{
+    if (m_base.trash)
+        return InsertResult::NotListed;
+    if (!m_base.search.trimmed().isEmpty())
+        return InsertResult::Outside;
+    if (TaskRepository::hasDateFilter(m_base)) {
+        const int column = (m_base.dateColumn == COL_COMPLETION_DT) ? TaskPage::TEXT_COMPLETION_DT
+                                                                     : TaskPage::TEXT_CREATION_DT;
+        const qint64 ms = source.dateMs(sourceRow, column);
+        if (ms == TimestampFormat::Null || ms < m_base.dateFrom || ms >= m_base.dateTo)
+            return InsertResult::NotListed;
+    }
+
+    const QVariant key = TaskRepository::sortKeyValue(source, sourceRow, m_base.sortColumn);
+    const int id = source.taskId(sourceRow);
+    // Ищем первую загруженную строку, перед которой встаёт новая. Место годится, только если
+    // весь путь до него загружен: иначе блок выше при перечитывании потерял бы строку.
+    bool pathLoaded = true; // все блоки выше текущего загружены, новая строка идёт после них
+    for (int b = 0; b < m_blocks.size(); ++b) {
+        Block &block = m_blocks[b];
+        const int rows = block.page ? qMin(block.rows, block.page->rowCount()) : 0;
+        if (!block.page || rows == 0) {
+            pathLoaded = pathLoaded && block.page && block.rows == 0;
+            continue;
+        }
+        const TaskPage &page = *block.page;
+        int at = 0;
+        while (at < rows && !precedes(key, id, TaskRepository::sortKeyValue(page, at, m_base.sortColumn), page.taskId(at)))
+            ++at;
+        if (at == rows && (b + 1 < m_blocks.size() || !m_atEnd)) {
+            pathLoaded = true;
+            continue; // строка ниже этого блока
+        }
+        if (at == 0 && !pathLoaded)
+            return InsertResult::Outside;
+
+        beginInsertRows(QModelIndex(), block.firstRow + at, block.firstRow + at);
+        block.page->insertRow(at, source, sourceRow);
+        ++block.rows;
+        if (at == 0) {
+            block.firstKey = key;
+            block.firstId = id;
+        }
+        for (int next = b + 1; next < m_blocks.size(); ++next)
+            ++m_blocks[next].firstRow;
+        ++m_rowCount;
+        ++m_total;
+        endInsertRows();
+        return InsertResult::Inserted;
+    }
+    // Ниже всех загруженных строк, а лента ещё догружается — строка придёт со следующим блоком
+    return (!m_atEnd && pathLoaded) ? InsertResult::NotListed : InsertResult::Outside;
+}
+
+bool TaskScrollModel::precedes(const QVariant &keyA, int idA, const QVariant &keyB, int idB) const
+{
+    const bool descending = (m_base.sortColumn < 0) || m_base.sortOrder == Qt::DescendingOrder;
+    int order = compareKeys(keyA, keyB);
+    if (order == 0)
+        order = idA < idB ? -1 : (idA > idB ? 1 : 0);
+    return descending ? order > 0 : order < 0;
+}
+
+void TaskScrollModel::reloadBlocks()
+{
+    for (int b = 0; b < m_blocks.size(); ++b) {
+        if (m_blocks[b].page && !m_blocks[b].loading)
+            requestBlock(b);
+    }
+    // В конце списка могли появиться строки — лента снова может догружать
+    if (!m_blocks.isEmpty())
+        m_atEnd = false;
+}
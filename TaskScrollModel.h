@@ -0,0 +1,96 @@
+#ifndef TASKSCROLLMODEL_H
+#define TASKSCROLLMODEL_H
+
+#include "TaskTableModel.h"
+#include "TaskRepository.h"
+
+#include <QVector>
+
+// Модель режима "лента": бесконечная прокрутка вместо страниц.
+// Строки подгружаются блоками по BlockSize через canFetchMore()/fetchMore() (keyset от
+// последней строки предыдущего блока, в текущей сортировке). В памяти держится только окно
+// блоков вокруг видимой области: дальние блоки выгружаются, от них остаются якоря (ключ и id
+// первой строки), по которым блок перечитывается, если к нему вернуться. Номера строк при
+// этом не меняются — полоса прокрутки не прыгает. Удалённые задачи убираются из загруженных
+// блоков на месте (removeTasks()) — блок становится короче, лента не сбрасывается; новые —
+// вставляются в загруженный блок по ключу сортировки (insertSorted()), блок становится длиннее.
+class TaskScrollModel : public TaskTableModel
+{
+    Q_OBJECT
+
+public:
+    enum {
+        BlockSize = 256,     // строк в блоке
+        PrefetchBlocks = 2,  // сколько блоков держать загруженными впереди видимой области
+        KeepBlocks = 2       // сколько блоков сверх видимых хранить с каждой стороны
+    };
+
+    explicit TaskScrollModel(QObject *parent = nullptr);
+    ~TaskScrollModel() override;
+
+    // Начать ленту заново: сортировка и поиск берутся из base, остальные поля игнорируются
+    void reset(const PageRequest &base);
+    // Освободить все блоки (режим ленты выключен)
+    void clear();
+    // Видимые строки изменились: догрузить/перечитать нужное, выгрузить дальнее
+    void setVisibleRows(int firstRow, int lastRow);
+    // Ответ потока БД на blockRequested()
+    void applyBlock(const PageResult &result);
+    // Убрать строки с этими id из загруженных блоков (rowsRemoved); возвращает число убранных.
+    // Строки выгруженных блоков не видны — если убрано меньше, чем изменено в базе, ленту
+    // нужно начать заново.
+    int removeTasks(const QVector<int> &ids);
+    // Новая задача (строка sourceRow) встаёт в загруженный блок на место по ключу сортировки
+    // (rowsInserted). Inserted — вставлена; NotListed — в ленту не входит (корзина, фильтр по
+    // дате) или придёт со следующим блоком; Outside — место среди выгруженных блоков или
+    // порядок неизвестен (поиск по релевантности): ленту нужно начать заново.
+    enum class InsertResult { Inserted, NotListed, Outside };
+    InsertResult insertSorted(const TaskPage &source, int sourceRow);
+    // Перечитать загруженные блоки на месте (базу изменили извне); выгруженные перечитаются
+    // сами, когда к ним вернутся
+    void reloadBlocks();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    int rowForId(int id) const override;
+
+    int loadedRows() const;
+    int total() const { return m_total; }
+
+signals:
+    void blockRequested(const PageRequest &request);
+
+protected:
+    TaskPage *pageForRow(int row, int *pageRow) const override;
+
+private:
+    struct Block {
+        std::shared_ptr<TaskPage> page; // nullptr — блок выгружен (или ещё не пришёл)
+        int firstRow = 0; // номер первой строки блока в модели
+        int rows = 0;     // BlockSize, пока из блока ничего не удалили (последний — может быть меньше)
+        QVariant firstKey;
+        int firstId = -1;
+        QVariant lastKey;
+        int lastId = -1;
+        bool loading = false;
+    };
+
+    // Блок, которому принадлежит строка модели (-1 — нет блоков)
+    int blockForRow(int row) const;
+    void requestBlock(int index);
+    void evictOutside(int firstBlock, int lastBlock);
+    // Строка a идёт в ленте раньше строки b (ключ сортировки, затем id — как в SQL)
+    bool precedes(const QVariant &keyA, int idA, const QVariant &keyB, int idB) const;
+
+    PageRequest m_base;
+    QVector<Block> m_blocks;
+    int m_rowCount;
+    int m_total;
+    bool m_atEnd;
+    bool m_appending; // запрошен следующий блок в конец
+    int m_visibleFirstBlock;
+    int m_visibleLastBlock;
+};
+
+#endif // TASKSCROLLMODEL_H
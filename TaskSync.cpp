@@ -0,0 +1,482 @@
+#include "TaskSync.h"
+#include "TaskRepository.h"
+#include "Trace.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QSaveFile>
+#include <QSqlError>
+#include <QSqlQuery>
+
+namespace {
+const QLatin1String FormatName("tracker-changes/2");
+// Формат до переименования CHANGE_LOG.hlc: время изменения лежало в поле "hlc"
+const QLatin1String LegacyFormatName("tracker-changes/1");
+// Записей на транзакцию при применении: отметка applied:<устройство> сдвигается вместе с ними
+constexpr int ApplyBatch = 500;
+
+// Поле журнала → столбец TASK (статус хранится по имени, в TASK — id)
+QString columnForField(const QString &field)
+{
+    static const QHash<QString, QString> columns = {
+        { QStringLiteral("description"), QStringLiteral("description") },
+        { QStringLiteral("details"), QStringLiteral("details") },
+        { QStringLiteral("creation_dt"), QStringLiteral("creation_dt") },
+        { QStringLiteral("completion_dt"), QStringLiteral("completion_dt") },
+        { QStringLiteral("status"), QStringLiteral("status_id") },
+        { QStringLiteral("is_deleted"), QStringLiteral("is_deleted") },
+        { QStringLiteral("deleted_dt"), QStringLiteral("deleted_dt") }
+    };
+    return columns.value(field);
+}
+
+// Значение из JSON для привязки к запросу: числа в журнале — целые (даты в мс, флаги)
+QVariant sqlValue(const QJsonValue &value)
+{
+    if (value.isNull() || value.isUndefined())
+        return QVariant();
+    if (value.isDouble())
+        return qint64(value.toDouble());
+    if (value.isBool())
+        return value.toBool() ? 1 : 0;
+    return value.toString();
+}
+
+QJsonValue jsonValue(const QVariant &value)
+{
+    if (value.isNull())
+        return QJsonValue();
+    if (value.typeId() == QMetaType::QString)
+        return value.toString();
+    return QJsonValue(value.toLongLong());
+}
+
+// Имя файла дельты: границы seq с ведущими нулями — порядок имён совпадает с порядком изменений
+QString deltaFileName(qint64 from, qint64 to)
+{
+    return QStringLiteral("%1-%2.ndjson").arg(from, 20, 10, QLatin1Char('0')).arg(to, 20, 10, QLatin1Char('0'));
+}
+}
+
+TaskSync::TaskSync(TaskRepository &repository)
+    : m_repository(repository)
+{
+}
+
+qint64 TaskSync::stateValue(const QString &key)
+{
+    QSqlQuery q(m_repository.database());
+    q.prepare("SELECT value FROM SYNC_STATE WHERE key = :key;");
+    q.bindValue(":key", key);
+    return (q.exec() && q.next()) ? q.value(0).toLongLong() : 0;
+}
+
+bool TaskSync::setStateValue(const QString &key, qint64 value)
+{
+    QSqlQuery q(m_repository.database());
+    q.prepare("INSERT OR REPLACE INTO SYNC_STATE (key, value) VALUES (:key, :value);");
+    q.bindValue(":key", key);
+    q.bindValue(":value", value);
+    return q.exec();
+}
+
+qint64 TaskSync::lastOwnSeq()
+{
+    QSqlQuery q(m_repository.database());
+    q.prepare("SELECT IFNULL(MAX(seq), 0) FROM CHANGE_LOG WHERE device = :device;");
+    q.bindValue(":device", TaskRepository::deviceId());
+    return (q.exec() && q.next()) ? q.value(0).toLongLong() : 0;
+}
+
+qint64 TaskSync::exportedMark()
+{
+    return stateValue(QStringLiteral("exported"));
+}
+
+SyncResult TaskSync::exportChanges(const QString &path, qint64 since)
+{
+    const qint64 to = qMax(since, lastOwnSeq());
+    SyncResult result = writeChanges(path, since, to);
+    if (result.ok && !setStateValue(QStringLiteral("exported"), to)) {
+        result.ok = false;
+        result.error = m_repository.database().lastError().text();
+    }
+    return result;
+}
+
+SyncResult TaskSync::writeChanges(const QString &path, qint64 since, qint64 to)
+{
+    TraceSpan span("db.syncExport");
+    SyncResult result;
+    const QString device = TaskRepository::deviceId();
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        result.error = file.errorString();
+        return result;
+    }
+    QJsonObject header;
+    header.insert(QStringLiteral("device"), device);
+    header.insert(QStringLiteral("format"), FormatName);
+    header.insert(QStringLiteral("from"), since);
+    header.insert(QStringLiteral("to"), to);
+    file.write(QJsonDocument(header).toJson(QJsonDocument::Compact) + '\n');
+
+    // Только свои изменения (чужие их устройство отдаёт само). Значения вставки — из текущей
+    // строки: журнал хранит вставку без значений, последующие правки полей идут следом
+    // своими записями. Вставка уже удалённой строки пропускается — за ней идёт "-".
+    // Правка длинного "Описания" записана ссылкой (value = NULL, см. trg_task_details_log):
+    // текст — текущий из TASK_DETAILS, как и у вставки.
+    QSqlQuery q(m_repository.database());
+    q.setForwardOnly(true);
+    q.prepare("SELECT c.seq, c.entity, c.uid, c.field, c.value, c.changed_ms, c.version, "
+              "t.id, t.description, t.details, t.creation_dt, t.completion_dt, s.name, t.is_deleted, t.deleted_dt, d.body "
+              "FROM CHANGE_LOG c "
+              "LEFT JOIN TASK t ON c.entity = 'TASK' AND t.uid = c.uid "
+              "AND (c.field = '*' OR (c.field = 'details' AND c.value IS NULL)) "
+              "LEFT JOIN STATUS s ON s.id = t.status_id "
+              "LEFT JOIN TASK_DETAILS d ON d.task_id = t.id "
+              "WHERE c.device = :device AND c.seq > :since AND c.seq <= :to ORDER BY c.seq;");
+    q.bindValue(":device", device);
+    q.bindValue(":since", since);
+    q.bindValue(":to", to);
+    if (!q.exec()) {
+        result.error = q.lastError().text();
+        return result;
+    }
+    while (q.next()) {
+        const QString entity = q.value(1).toString();
+        const QString field = q.value(3).toString();
+        QJsonObject entry;
+        entry.insert(QStringLiteral("seq"), q.value(0).toLongLong());
+        entry.insert(QStringLiteral("entity"), entity);
+        entry.insert(QStringLiteral("uid"), q.value(2).toString());
+        entry.insert(QStringLiteral("field"), field);
+        if (entity == QLatin1String("TASK") && field == QLatin1String("*")) {
+            if (q.value(7).isNull()) {
+                ++result.skipped;
+                continue;
+            }
+            QJsonObject row;
+            row.insert(QStringLiteral("description"), jsonValue(q.value(8)));
+            // Длинное "Описание" — целиком из TASK_DETAILS, а не хранимое в TASK начало
+            row.insert(QStringLiteral("details"), q.value(15).isNull()
+                           ? jsonValue(q.value(9)) : QJsonValue(TaskRepository::expandDetails(q.value(15).toByteArray())));
+            row.insert(QStringLiteral("creation_dt"), jsonValue(q.value(10)));
+            row.insert(QStringLiteral("completion_dt"), jsonValue(q.value(11)));
+            row.insert(QStringLiteral("status"), jsonValue(q.value(12)));
+            row.insert(QStringLiteral("is_deleted"), jsonValue(q.value(13)));
+            row.insert(QStringLiteral("deleted_dt"), jsonValue(q.value(14)));
+            entry.insert(QStringLiteral("value"), row);
+        } else if (entity == QLatin1String("TASK") && field == QLatin1String("details") && !q.value(7).isNull()) {
+            entry.insert(QStringLiteral("value"), q.value(15).isNull()
+                             ? jsonValue(q.value(9)) : QJsonValue(TaskRepository::expandDetails(q.value(15).toByteArray())));
+        } else {
+            entry.insert(QStringLiteral("value"), jsonValue(q.value(4)));
+        }
+        entry.insert(QStringLiteral("changed_ms"), q.value(5).toLongLong());
+        entry.insert(QStringLiteral("version"), q.value(6).toLongLong());
+        file.write(QJsonDocument(entry).toJson(QJsonDocument::Compact) + '\n');
+        ++result.exported;
+    }
+    if (!file.commit()) {
+        result.error = file.errorString();
+        return result;
+    }
+    span.setRows(result.exported);
+    result.files = 1;
+    result.ok = true;
+    return result;
+}
+
+SyncResult TaskSync::importChanges(const QString &path)
+{
+    TraceSpan span("db.syncImport");
+    SyncResult result;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        result.error = file.errorString();
+        return result;
+    }
+    const QJsonObject header = QJsonDocument::fromJson(file.readLine()).object();
+    const QString origin = header.value(QStringLiteral("device")).toString();
+    const QString format = header.value(QStringLiteral("format")).toString();
+    if ((format != FormatName && format != LegacyFormatName) || origin.isEmpty()) {
+        result.error = QStringLiteral("%1: не файл изменений").arg(QFileInfo(path).fileName());
+        return result;
+    }
+    const QString timeField = (format == LegacyFormatName) ? QStringLiteral("hlc") : QStringLiteral("changed_ms");
+    result.files = 1;
+    // Свой же файл (каталог синхронизации, повторный импорт) — всё уже в журнале
+    if (origin == TaskRepository::deviceId()) {
+        result.ok = true;
+        return result;
+    }
+
+    QSqlDatabase db = m_repository.database();
+    const QString markKey = QStringLiteral("applied:") + origin;
+    qint64 mark = stateValue(markKey);
+
+    QSqlQuery latest(db);
+    latest.prepare("SELECT changed_ms, device FROM CHANGE_LOG WHERE entity = :entity AND uid = :uid AND field IN (:field, '*') "
+                   "ORDER BY changed_ms DESC, device DESC LIMIT 1;");
+    QSqlQuery tombstone(db);
+    tombstone.prepare("SELECT 1 FROM CHANGE_LOG WHERE entity = :entity AND uid = :uid AND field = '-' LIMIT 1;");
+    QSqlQuery taskId(db);
+    taskId.prepare("SELECT id FROM TASK WHERE uid = :uid;");
+    QSqlQuery log(db);
+    log.prepare("INSERT INTO CHANGE_LOG (entity, uid, field, value, changed_ms, device, version) "
+                "VALUES (:entity, :uid, :field, :value, :changed_ms, :device, "
+                "(SELECT IFNULL(MAX(version), 0) + 1 FROM CHANGE_LOG WHERE entity = :entity2 AND uid = :uid2));");
+    QSqlQuery insertTask(db);
+    insertTask.prepare("INSERT INTO TASK (uid, description, details, creation_dt, completion_dt, status_id, is_deleted, deleted_dt) "
+                       "VALUES (:uid, :description, :details, :created, :completed, :status, :deleted, :deleted_dt);");
+    QSqlQuery deleteTask(db);
+    deleteTask.prepare("DELETE FROM TASK WHERE id = :id;");
+    QSqlQuery insertStatus(db);
+    insertStatus.prepare("INSERT OR IGNORE INTO STATUS (name) VALUES (:name);");
+    QSqlQuery statusId(db);
+    statusId.prepare("SELECT id FROM STATUS WHERE name = :name;");
+    // Статус, которого ещё нет (его вставка в этом же файле или в файле третьего устройства), создаётся;
+    // без имени — "Запланировано", как у новой задачи. Ошибка запроса — в statusError (пачка откатывается).
+    const QSqlQuery *statusError = nullptr;
+    auto statusFor = [&](const QVariant &value) -> QVariant {
+        const QVariant name = value.isNull() ? QVariant(StatusRegistry::plannedName()) : value;
+        insertStatus.bindValue(":name", name);
+        statusId.bindValue(":name", name);
+        if (!insertStatus.exec()) {
+            statusError = &insertStatus;
+            return QVariant();
+        }
+        if (!statusId.exec() || !statusId.next()) {
+            statusError = &statusId;
+            return QVariant();
+        }
+        const QVariant id = statusId.value(0);
+        statusId.finish();
+        return id;
+    };
+    QHash<QString, QSqlQuery> updates; // UPDATE по столбцу — подготавливается при первом использовании
+
+    auto fail = [&](const QSqlQuery &query) {
+        result.error = query.lastError().text();
+        db.rollback();
+        return result;
+    };
+    auto begin = [&]() {
+        return db.transaction()
+            && QSqlQuery(db).exec("INSERT OR REPLACE INTO SYNC_STATE (key, value) VALUES ('applying', 1);");
+    };
+    auto finish = [&]() {
+        return QSqlQuery(db).exec("DELETE FROM SYNC_STATE WHERE key = 'applying';")
+            && setStateValue(markKey, mark)
+            && db.commit();
+    };
+
+    if (!begin()) {
+        result.error = db.lastError().text();
+        db.rollback();
+        return result;
+    }
+    int inBatch = 0;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty())
+            continue;
+        const QJsonObject entry = QJsonDocument::fromJson(line).object();
+        const qint64 seq = qint64(entry.value(QStringLiteral("seq")).toDouble());
+        if (seq <= mark) {
+            ++result.skipped;
+            continue;
+        }
+        const QString entity = entry.value(QStringLiteral("entity")).toString();
+        const QString uid = entry.value(QStringLiteral("uid")).toString();
+        const QString field = entry.value(QStringLiteral("field")).toString();
+        const QJsonValue value = entry.value(QStringLiteral("value"));
+        const qint64 changedMs = qint64(entry.value(timeField).toDouble());
+        mark = seq;
+
+        tombstone.bindValue(":entity", entity);
+        tombstone.bindValue(":uid", uid);
+        if (!tombstone.exec())
+            return fail(tombstone);
+        const bool deleted = tombstone.next();
+        tombstone.finish();
+
+        bool apply = false;
+        if (entity == QLatin1String("TASK")) {
+            taskId.bindValue(":uid", uid);
+            if (!taskId.exec())
+                return fail(taskId);
+            const QVariant id = taskId.next() ? taskId.value(0) : QVariant();
+            taskId.finish();
+
+            if (field == QLatin1String("*")) {
+                // Удалённую строку не воскрешаем; уже существующая (общая копия базы) остаётся
+                apply = !deleted && id.isNull() && value.isObject();
+                if (apply) {
+                    const QJsonObject row = value.toObject();
+                    insertTask.bindValue(":uid", uid);
+                    insertTask.bindValue(":description", sqlValue(row.value(QStringLiteral("description"))));
+                    insertTask.bindValue(":details", sqlValue(row.value(QStringLiteral("details"))));
+                    insertTask.bindValue(":created", sqlValue(row.value(QStringLiteral("creation_dt"))));
+                    insertTask.bindValue(":completed", sqlValue(row.value(QStringLiteral("completion_dt"))));
+                    insertTask.bindValue(":status", statusFor(sqlValue(row.value(QStringLiteral("status")))));
+                    if (statusError)
+                        return fail(*statusError);
+                    insertTask.bindValue(":deleted", sqlValue(row.value(QStringLiteral("is_deleted"))).toInt());
+                    insertTask.bindValue(":deleted_dt", sqlValue(row.value(QStringLiteral("deleted_dt"))));
+                    if (!insertTask.exec())
+                        return fail(insertTask);
+                }
+            } else if (field == QLatin1String("-")) {
+                // Удаление окончательно; отметка "-" пишется и без строки — поздняя вставка
+                // от третьего устройства её не вернёт
+                apply = !deleted;
+                if (apply && !id.isNull()) {
+                    deleteTask.bindValue(":id", id);
+                    if (!deleteTask.exec())
+                        return fail(deleteTask);
+                }
+            } else {
+                const QString column = columnForField(field);
+                if (!column.isEmpty() && !id.isNull()) {
+                    latest.bindValue(":entity", entity);
+                    latest.bindValue(":uid", uid);
+                    latest.bindValue(":field", field);
+                    if (!latest.exec())
+                        return fail(latest);
+                    // Побеждает большее (время, устройство); равное — то же самое изменение
+                    apply = !latest.next() || changedMs > latest.value(0).toLongLong()
+                        || (changedMs == latest.value(0).toLongLong() && origin > latest.value(1).toString());
+                    latest.finish();
+                }
+                if (apply) {
+                    auto it = updates.find(column);
+                    if (it == updates.end()) {
+                        it = updates.insert(column, QSqlQuery(db));
+                        it->prepare(QStringLiteral("UPDATE TASK SET %1 = :value WHERE id = :id;").arg(column));
+                    }
+                    const QVariant newValue = sqlValue(value);
+                    it->bindValue(":value", field == QLatin1String("status") ? statusFor(newValue) : newValue);
+                    if (statusError)
+                        return fail(*statusError);
+                    it->bindValue(":id", id);
+                    if (!it->exec())
+                        return fail(*it);
+                }
+            }
+        } else if (entity == QLatin1String("STATUS")) {
+            if (field == QLatin1String("*")) {
+                insertStatus.bindValue(":name", uid);
+                if (!insertStatus.exec())
+                    return fail(insertStatus);
+                apply = insertStatus.numRowsAffected() > 0;
+            } else if (field == QLatin1String("-") && !deleted) {
+                // Статус, который здесь ещё используется, остаётся
+                QSqlQuery remove(db);
+                remove.prepare("DELETE FROM STATUS WHERE name = :name "
+                               "AND NOT EXISTS (SELECT 1 FROM TASK WHERE TASK.status_id = STATUS.id);");
+                remove.bindValue(":name", uid);
+                if (!remove.exec())
+                    return fail(remove);
+                apply = true;
+            }
+        }
+
+        if (!apply) {
+            ++result.skipped;
+        } else {
+            log.bindValue(":entity", entity);
+            log.bindValue(":uid", uid);
+            log.bindValue(":field", field);
+            log.bindValue(":value", field == QLatin1String("*") ? QVariant() : sqlValue(value));
+            log.bindValue(":changed_ms", changedMs);
+            log.bindValue(":device", origin);
+            log.bindValue(":entity2", entity);
+            log.bindValue(":uid2", uid);
+            if (!log.exec())
+                return fail(log);
+            ++result.applied;
+        }
+
+        if (++inBatch >= ApplyBatch) {
+            if (!finish() || !begin()) {
+                result.error = db.lastError().text();
+                db.rollback();
+                return result;
+            }
+            inBatch = 0;
+        }
+    }
+    if (!finish()) {
+        result.error = db.lastError().text();
+        db.rollback();
+        return result;
+    }
+    // Статусы могли добавиться
+    if (result.applied > 0)
+        m_repository.reloadStatuses();
+    span.setRows(result.applied);
+    result.ok = true;
+    return result;
+}
+
+SyncResult TaskSync::syncDirectory(const QString &dir)
+{
+    SyncResult result;
+    QDir root(dir);
+    const QString device = TaskRepository::deviceId();
+    if (!root.mkpath(device)) {
+        result.error = QStringLiteral("не удалось создать каталог %1").arg(root.filePath(device));
+        return result;
+    }
+
+    // Отдать: свои изменения после прошлой отправки в этот каталог
+    const QString pushedKey = QStringLiteral("pushed:") + root.canonicalPath();
+    const qint64 pushed = stateValue(pushedKey);
+    const qint64 to = lastOwnSeq();
+    if (to > pushed) {
+        const SyncResult written = writeChanges(root.filePath(device + QLatin1Char('/') + deltaFileName(pushed + 1, to)),
+                                                pushed, to);
+        if (!written.ok)
+            return written;
+        if (!setStateValue(pushedKey, to)) {
+            result.error = m_repository.database().lastError().text();
+            return result;
+        }
+        result.exported = written.exported;
+        result.files += written.files;
+    }
+
+    // Забрать: файлы других устройств, конец которых ещё не применён
+    const QStringList peers = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    for (const QString &peer : peers) {
+        if (peer == device)
+            continue;
+        const qint64 applied = stateValue(QStringLiteral("applied:") + peer);
+        const QDir peerDir(root.filePath(peer));
+        const QStringList files = peerDir.entryList({ QStringLiteral("*.ndjson") }, QDir::Files, QDir::Name);
+        for (const QString &name : files) {
+            const qint64 fileTo = QFileInfo(name).completeBaseName().section(QLatin1Char('-'), 1).toLongLong();
+            if (fileTo <= applied)
+                continue;
+            const SyncResult imported = importChanges(peerDir.filePath(name));
+            if (!imported.ok) {
+                result.error = imported.error;
+                return result;
+            }
+            result.applied += imported.applied;
+            result.skipped += imported.skipped;
+            result.files += imported.files;
+        }
+    }
+    result.ok = true;
+    return result;
+}
@@ -0,0 +1,71 @@
+#ifndef TASKSYNC_H
+#define TASKSYNC_H
+
+#include <QMetaType>
+#include <QString>
+
+class TaskRepository;
+
+// Итог синхронизации
+struct SyncResult {
+    qint64 exported = 0; // записей журнала отдано
+    qint64 applied = 0;  // чужих изменений применено
+    qint64 skipped = 0;  // уже применённые ранее или проигравшие более позднему изменению
+    int files = 0;       // файлов прочитано/записано
+    bool ok = false;
+    QString error;
+};
+
+// Обмен изменениями между копиями базы (ноутбук ↔ настольный) через файлы, без сервера.
+// Источник — журнал CHANGE_LOG, его пишут триггеры TASK/STATUS (см. миграцию 8 в
+// TaskRepository): у каждого изменения есть устройство, время (мс) и порядковый номер seq.
+// Отдаются только свои изменения после отметки — файл содержит дельту, а не всю таблицу.
+//
+// Файл — NDJSON: заголовок {"device", "format", "from", "to"}, затем по записи на строку
+// {"seq", "entity", "uid", "field", "value", "changed_ms", "version"} (формат /1 — время в "hlc",
+// тоже читается). field "*" — вставка (у задачи
+// value — объект со всеми полями строки на момент экспорта), "-" — удаление, иначе — новое
+// значение одного поля (статус — по имени).
+//
+// Конфликты — по полям, "последняя запись побеждает": изменение применяется, если его
+// (время, устройство) больше, чем у последнего известного изменения того же поля или вставки
+// строки. Удаление окончательно. Применённое записывается в журнал с исходными устройством
+// и временем, поэтому повторный обмен и обмен по кругу (A → B → A) ничего не меняют.
+// Время — changed_ms, мс от эпохи по часам устройства, где сделано изменение; это не гибридные
+// логические часы. Если часы устройств расходятся, при одновременных правках одного поля победит
+// устройство, чьи часы спешат, даже если его правка была раньше. Порядок правок на одном
+// устройстве этим не нарушается (seq), а расхождение меньше интервала между правками
+// на разных устройствах не влияет на результат.
+// Отметка применённого — applied:<устройство> в SYNC_STATE, в той же транзакции, что и сами
+// изменения: прерванный обмен просто повторяется.
+//
+// Работает на соединении репозитория, в его потоке; вне открытой транзакции.
+class TaskSync
+{
+public:
+    explicit TaskSync(TaskRepository &repository);
+
+    // Свои изменения с seq > since (0 — весь журнал) в файл; отметку 'exported' сдвигает на последнюю
+    SyncResult exportChanges(const QString &path, qint64 since);
+    // Изменения другого устройства из файла; уже применённые пропускаются
+    SyncResult importChanges(const QString &path);
+    // Общий каталог (облачная папка, флешка): свои новые изменения — в <dir>/<device>/,
+    // затем чужие файлы из остальных подкаталогов по порядку
+    SyncResult syncDirectory(const QString &dir);
+
+    // Отметка 'exported' — последний seq, отданный exportChanges()
+    qint64 exportedMark();
+
+private:
+    // Свои записи журнала (since, to] в файл; QSaveFile — недописанный файл не появится в каталоге
+    SyncResult writeChanges(const QString &path, qint64 since, qint64 to);
+    qint64 lastOwnSeq();
+    qint64 stateValue(const QString &key);
+    bool setStateValue(const QString &key, qint64 value);
+
+    TaskRepository &m_repository;
+};
+
+Q_DECLARE_METATYPE(SyncResult)
+
+#endif // TASKSYNC_H
@@ -0,0 +1,274 @@
+#include "TaskTableModel.h"
+#include "TaskPage.h"
+
+#include <QFont>
+#include <QSet>
+
+TaskTableModel::TaskTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_page(std::make_shared<TaskPage>())
+{
+}
+
+TaskTableModel::~TaskTableModel() = default;
+
+int TaskTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_page->rowCount();
+}
+
+int TaskTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant TaskTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+    int row = -1;
+    const TaskPage *page = pageForRow(index.row(), &row);
+    if (!page)
+        return QVariant();
+    if (role == StatusIdRole)
+        return page->statusId(row);
+    if (role == Qt::FontRole) {
+        if (!page->isRemoved(row))
+            return QVariant();
+        QFont font;
+        font.setStrikeOut(true);
+        return font;
+    }
+    if (role != Qt::DisplayRole && role != Qt::EditRole)
+        return QVariant();
+
+    switch (index.column()) {
+        case COL_ID: return page->taskId(row);
+        case COL_STATUS: return page->statusName(row); // общая строка, только счётчик ссылок
+        case COL_IS_DELETED: return int(page->isDeleted(row));
+        case COL_CREATION_DT:
+        case COL_COMPLETION_DT: {
+            const qint64 ms = page->dateMs(row, index.column());
+            return ms == TimestampFormat::Null ? QVariant() : QVariant(m_dateFormat.display(ms));
+        }
+        case COL_DESC:
+        case COL_DETAILS: {
+            if (page->isNull(row, index.column()))
+                return QVariant();
+            // Самостоятельная копия: строку могут держать представление, кэш делегата или буфер
+            // обмена сколько угодно после смены страницы. Копируются только видимые ячейки, а
+            // "Описание" в странице — короткое начало текста (TaskRepository::DetailsPreviewChars).
+            // В результатах поиска показываем подсвеченный вариант (см. SearchHighlightDelegate).
+            if (role == Qt::DisplayRole && page->hasHighlight(row, index.column()))
+                return page->highlightView(row, index.column()).toString();
+            return page->text(row, index.column());
+        }
+        default: return QVariant();
+    }
+}
+
+QVariant TaskTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    switch (section) {
+        case COL_DESC: return tr("Задание");
+        case COL_DETAILS: return tr("Описание");
+        case COL_CREATION_DT: return tr("Дата создания");
+        case COL_COMPLETION_DT: return tr("Дата выполнения");
+        case COL_STATUS: return tr("Статус");
+        default: return QAbstractTableModel::headerData(section, orientation, role);
+    }
+}
+
+void TaskTableModel::setPage(std::shared_ptr<TaskPage> page)
+{
+    if (!page)
+        page = std::make_shared<TaskPage>();
+
+    beginResetModel();
+    m_page = std::move(page);
+    endResetModel();
+}
+
+void TaskTableModel::updatePage(std::shared_ptr<TaskPage> page)
+{
+    if (!page) {
+        setPage(std::move(page));
+        return;
+    }
+    TaskPage &current = *m_page;
+    const TaskPage &next = *page;
+    QSet<int> currentIds;
+    QSet<int> nextIds;
+    currentIds.reserve(current.rowCount());
+    nextIds.reserve(next.rowCount());
+    for (int row = 0; row < current.rowCount(); ++row)
+        currentIds.insert(current.taskId(row));
+    for (int row = 0; row < next.rowCount(); ++row)
+        nextIds.insert(next.taskId(row));
+
+    // Оставшиеся строки должны идти в том же порядке, иначе разница — не вставки/удаления
+    QVector<int> keptCurrent;
+    QVector<int> keptNext;
+    for (int row = 0; row < current.rowCount(); ++row) {
+        if (nextIds.contains(current.taskId(row)))
+            keptCurrent.append(current.taskId(row));
+    }
+    for (int row = 0; row < next.rowCount(); ++row) {
+        if (currentIds.contains(next.taskId(row)))
+            keptNext.append(next.taskId(row));
+    }
+    if (keptCurrent != keptNext) {
+        setPage(std::move(page));
+        return;
+    }
+
+    // Удаления — снизу вверх подряд идущими диапазонами
+    for (int row = current.rowCount() - 1; row >= 0;) {
+        if (nextIds.contains(current.taskId(row))) {
+            --row;
+            continue;
+        }
+        int first = row;
+        while (first > 0 && !nextIds.contains(current.taskId(first - 1)))
+            --first;
+        beginRemoveRows(QModelIndex(), first, row);
+        for (int r = row; r >= first; --r)
+            current.removeRow(r);
+        endRemoveRows();
+        row = first - 1;
+    }
+    // Вставки — сверху вниз: строки выше row уже совпадают с новой страницей
+    for (int row = 0; row < next.rowCount();) {
+        if (currentIds.contains(next.taskId(row))) {
+            ++row;
+            continue;
+        }
+        int last = row;
+        while (last + 1 < next.rowCount() && !currentIds.contains(next.taskId(last + 1)))
+            ++last;
+        beginInsertRows(QModelIndex(), row, last);
+        for (int r = row; r <= last; ++r)
+            current.insertRow(r, next, r);
+        endInsertRows();
+        row = last + 1;
+    }
+
+    // Состав совпадает — подменяем страницу свежей (копии вставленных строк уходят вместе
+    // с прежней) и сообщаем только об изменившихся значениях
+    int firstChanged = -1;
+    int lastChanged = -1;
+    for (int row = 0; row < next.rowCount(); ++row) {
+        if (!current.sameRow(row, next, row)) {
+            if (firstChanged < 0)
+                firstChanged = row;
+            lastChanged = row;
+        }
+    }
+    m_page = std::move(page);
+    if (firstChanged >= 0)
+        emit dataChanged(index(firstChanged, 0), index(lastChanged, COLUMN_COUNT - 1));
+}
+
+void TaskTableModel::updateTask(int row, const QString &description, const QString &details,
+                                const QVariant &completionDt, int statusId, const QString &statusName)
+{
+    int pageRow = -1;
+    TaskPage *page = pageForRow(row, &pageRow);
+    if (!page)
+        return;
+
+    page->setTask(pageRow, description, details, completionDt, statusId, statusName);
+    emit dataChanged(index(row, COL_DESC), index(row, COL_STATUS));
+}
+
+void TaskTableModel::updateStatus(int row, const QVariant &completionDt, int statusId, const QString &statusName)
+{
+    int pageRow = -1;
+    TaskPage *page = pageForRow(row, &pageRow);
+    if (!page)
+        return;
+
+    page->setStatus(pageRow, completionDt, statusId, statusName);
+    emit dataChanged(index(row, COL_COMPLETION_DT), index(row, COL_STATUS));
+}
+
+void TaskTableModel::markRemoved(int row)
+{
+    int pageRow = -1;
+    TaskPage *page = pageForRow(row, &pageRow);
+    if (!page)
+        return;
+
+    page->setRemoved(pageRow);
+    emit dataChanged(index(row, 0), index(row, COLUMN_COUNT - 1));
+}
+
+void TaskTableModel::insertTask(int row, const TaskPage &source, int sourceRow)
+{
+    row = qBound(0, row, m_page->rowCount());
+    beginInsertRows(QModelIndex(), row, row);
+    m_page->insertRow(row, source, sourceRow);
+    endInsertRows();
+}
+
+void TaskTableModel::setTaskId(int row, int id)
+{
+    int pageRow = -1;
+    TaskPage *page = pageForRow(row, &pageRow);
+    if (!page)
+        return;
+
+    page->setTaskId(pageRow, id);
+    emit dataChanged(index(row, COL_ID), index(row, COL_ID));
+}
+
+int TaskTableModel::taskId(int row) const
+{
+    int pageRow = -1;
+    const TaskPage *page = pageForRow(row, &pageRow);
+    return page ? page->taskId(pageRow) : -1;
+}
+
+int TaskTableModel::statusId(int row) const
+{
+    int pageRow = -1;
+    const TaskPage *page = pageForRow(row, &pageRow);
+    return page ? page->statusId(pageRow) : -1;
+}
+
+int TaskTableModel::rowForId(int id) const
+{
+    return m_page->rowForId(id);
+}
+
+QString TaskTableModel::text(int row, int column) const
+{
+    int pageRow = -1;
+    const TaskPage *page = pageForRow(row, &pageRow);
+    return page ? page->text(pageRow, column) : QString();
+}
+
+QString TaskTableModel::statusName(int row) const
+{
+    int pageRow = -1;
+    const TaskPage *page = pageForRow(row, &pageRow);
+    return page ? page->statusName(pageRow) : QString();
+}
+
+bool TaskTableModel::hasMoreDetails(int row) const
+{
+    int pageRow = -1;
+    const TaskPage *page = pageForRow(row, &pageRow);
+    return page && page->hasMoreDetails(pageRow);
+}
+
+TaskPage *TaskTableModel::pageForRow(int row, int *pageRow) const
+{
+    if (row < 0 || row >= m_page->rowCount())
+        return nullptr;
+    *pageRow = row;
+    return m_page.get();
+}
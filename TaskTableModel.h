@@ -0,0 +1,92 @@
+#ifndef TASKTABLEMODEL_H
+#define TASKTABLEMODEL_H
+
+#include "TimestampFormat.h"
+
+#include <QAbstractTableModel>
+#include <QString>
+#include <QVariant>
+
+#include <memory>
+
+class TaskPage;
+
+// Модель видимой страницы задач.
+// В отличие от QSqlQueryModel не хранит QVariant на каждую ячейку: данные лежат в колоночной
+// TaskPage (id/status_id — массивы int, тексты — в арене, имена статусов интернированы).
+// data() копирует текст только запрошенных (видимых) ячеек.
+class TaskTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    // Именованные индексы столбцов таблицы
+    enum Column {
+        COL_ID = 0,
+        COL_DESC = 1,
+        COL_DETAILS = 2,
+        COL_CREATION_DT = 3,
+        COL_COMPLETION_DT = 4,
+        COL_STATUS = 5,
+        COL_IS_DELETED = 6,
+        COLUMN_COUNT = 7
+    };
+
+    // Дополнительные роли data()
+    enum Role {
+        StatusIdRole = Qt::UserRole + 1 // id статуса строки (для делегата: цвет по id, без сравнения строк)
+    };
+
+    explicit TaskTableModel(QObject *parent = nullptr);
+    ~TaskTableModel() override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    // Показывает новую страницу (собранную в потоке БД)
+    void setPage(std::shared_ptr<TaskPage> page);
+    // Та же выборка перечитана (после записи): вместо сброса модели — точные rowsRemoved/
+    // rowsInserted по id и dataChanged только для изменившихся строк; выделение и прокрутка
+    // представления остаются на месте. Если общие строки сменили порядок — обычный setPage().
+    void updatePage(std::shared_ptr<TaskPage> page);
+    const TaskPage *page() const { return m_page.get(); }
+
+    // Точечное обновление строки после редактирования — без перечитывания страницы.
+    // details — полный текст из диалога (см. TaskPage::setTask()).
+    virtual void updateTask(int row, const QString &description, const QString &details,
+                    const QVariant &completionDt, int statusId, const QString &statusName);
+    // Смена статуса: текст строки (в странице — возможно, только начало "Описания") не трогается
+    void updateStatus(int row, const QVariant &completionDt, int statusId, const QString &statusName);
+    // Строка удалена (или восстановлена из корзины), но журнал правок ещё не зафиксирован
+    // и страница не перечитана: показывается зачёркнутой.
+    void markRemoved(int row);
+    // Новая задача показывается сразу, до фиксации журнала: копия строки sourceRow вставляется
+    // перед row (rowsInserted). Пока задача не записана, у строки временный id < -1 —
+    // setTaskId() заменяет его настоящим.
+    void insertTask(int row, const TaskPage &source, int sourceRow);
+    void setTaskId(int row, int id);
+
+    // Значения строки в виде самостоятельных копий (не ссылаются на внутренний буфер),
+    // их можно хранить и передавать в диалоги.
+    int taskId(int row) const;
+    int statusId(int row) const;
+    virtual int rowForId(int id) const; // -1, если строки нет среди загруженных
+    QString text(int row, int column) const; // COL_DESC, COL_DETAILS, COL_CREATION_DT, COL_COMPLETION_DT
+    QString statusName(int row) const;
+    // text(row, COL_DETAILS) — только начало длинного "Описания"; полный текст — TaskDataService::loadDetails()
+    bool hasMoreDetails(int row) const;
+
+protected:
+    // Страница, в которой лежит строка модели, и номер строки в ней; nullptr — строка
+    // не загружена. Подклассы (TaskScrollModel) собирают строки из нескольких страниц.
+    virtual TaskPage *pageForRow(int row, int *pageRow) const;
+
+private:
+    std::shared_ptr<TaskPage> m_page;
+    // Даты переводятся в локальное время только для запрошенных (видимых) ячеек, с кэшем
+    TimestampFormat m_dateFormat;
+};
+
+#endif // TASKTABLEMODEL_H
@@ -0,0 +1,50 @@
+#include "TaskTableView.h"
+#include "Trace.h"
+
+#include <QDebug>
+#include <QEvent>
+
+#include <algorithm>
+
+namespace {
+// Сколько кадров копить перед выводом статистики
+constexpr int FrameStatsWindow = 120;
+}
+
+TaskTableView::TaskTableView(QWidget *parent)
+    : QTableView(parent)
+    , m_statsEnabled(qEnvironmentVariableIsSet("TRACKER_FRAME_STATS"))
+{
+    m_frameNs.reserve(FrameStatsWindow);
+}
+
+bool TaskTableView::viewportEvent(QEvent *event)
+{
+    if (event->type() != QEvent::Paint)
+        return QTableView::viewportEvent(event);
+    TraceSpan span("ui.paint");
+    if (!m_statsEnabled)
+        return QTableView::viewportEvent(event);
+
+    m_timer.start();
+    const bool result = QTableView::viewportEvent(event);
+    m_frameNs.append(m_timer.nsecsElapsed());
+    if (m_frameNs.size() >= FrameStatsWindow)
+        reportFrames();
+    return result;
+}
+
+void TaskTableView::reportFrames()
+{
+    std::sort(m_frameNs.begin(), m_frameNs.end());
+    qint64 sum = 0;
+    for (qint64 ns : m_frameNs)
+        sum += ns;
+    const auto ms = [](qint64 ns) { return double(ns) / 1e6; };
+    qDebug().nospace() << "frame stats: " << m_frameNs.size() << " frames, rows " << model()->rowCount()
+                       << ", avg " << ms(sum / m_frameNs.size()) << " ms"
+                       << ", p50 " << ms(m_frameNs[m_frameNs.size() / 2]) << " ms"
+                       << ", p95 " << ms(m_frameNs[m_frameNs.size() * 95 / 100]) << " ms"
+                       << ", max " << ms(m_frameNs.last()) << " ms";
+    m_frameNs.clear();
+}
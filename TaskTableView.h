@@ -0,0 +1,29 @@
+#ifndef TASKTABLEVIEW_H
+#define TASKTABLEVIEW_H
+
+#include <QElapsedTimer>
+#include <QTableView>
+
+// Таблица задач с замером времени кадра: сколько занимает перерисовка viewport
+// (отрисовка всех видимых ячеек делегатами). Статистика пишется в лог раз в
+// FrameStatsWindow кадров, если задана переменная окружения TRACKER_FRAME_STATS —
+// так сравниваются варианты отрисовки на одной и той же странице.
+class TaskTableView : public QTableView
+{
+    Q_OBJECT
+
+public:
+    explicit TaskTableView(QWidget *parent = nullptr);
+
+protected:
+    bool viewportEvent(QEvent *event) override;
+
+private:
+    void reportFrames();
+
+    bool m_statsEnabled;
+    QElapsedTimer m_timer;
+    QVector<qint64> m_frameNs; // времена кадров текущего окна
+};
+
+#endif // TASKTABLEVIEW_H
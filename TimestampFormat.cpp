@@ -0,0 +1,65 @@
+#include "TimestampFormat.h"
+
+#include <QDateTime>
+#include <QTimeZone>
+
+namespace {
+// Предел кэша: видимых дат немного, а при прокрутке ленты старые вытесняются разом
+constexpr int DisplayCacheLimit = 4096;
+}
+
+qint64 TimestampFormat::now()
+{
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+QString TimestampFormat::toDisplay(qint64 ms)
+{
+    if (ms == Null)
+        return QString();
+    return QDateTime::fromMSecsSinceEpoch(ms).toString(QStringLiteral("yyyy-MM-dd HH:mm:ss"));
+}
+
+QString TimestampFormat::toIso(qint64 ms)
+{
+    if (ms == Null)
+        return QString();
+    return QDateTime::fromMSecsSinceEpoch(ms, QTimeZone::UTC).toString(Qt::ISODateWithMs);
+}
+
+bool TimestampFormat::parse(const QString &text, qint64 *ms)
+{
+    const QString trimmed = text.trimmed();
+    if (trimmed.isEmpty())
+        return false;
+
+    bool isNumber = false;
+    const qint64 number = trimmed.toLongLong(&isNumber);
+    if (isNumber) {
+        *ms = number;
+        return true;
+    }
+
+    // Без указания зоны QDateTime считает время локальным — так записывали прежние версии
+    QDateTime dt = QDateTime::fromString(trimmed, Qt::ISODateWithMs);
+    if (!dt.isValid())
+        dt = QDateTime::fromString(trimmed, QStringLiteral("yyyy-MM-dd HH:mm:ss"));
+    if (!dt.isValid())
+        return false;
+    *ms = dt.toMSecsSinceEpoch();
+    return true;
+}
+
+QString TimestampFormat::display(qint64 ms) const
+{
+    if (ms == Null)
+        return QString();
+    // На экране секунды — миллисекунды в ключ не входят
+    const qint64 key = ms / 1000;
+    auto it = m_cache.constFind(key);
+    if (it != m_cache.constEnd())
+        return it.value();
+    if (m_cache.size() >= DisplayCacheLimit)
+        m_cache.clear();
+    return m_cache.insert(key, toDisplay(key * 1000)).value();
+}
@@ -0,0 +1,34 @@
+#ifndef TIMESTAMPFORMAT_H
+#define TIMESTAMPFORMAT_H
+
+#include <QHash>
+#include <QString>
+
+#include <limits>
+
+// Даты задач (creation_dt, completion_dt) хранятся в БД как INTEGER — миллисекунды от эпохи
+// в UTC: компактно, сравнение и индексы — по числу. В локальное время переводится только то,
+// что показывается на экране; результат кэшируется (см. display()).
+class TimestampFormat
+{
+public:
+    static constexpr qint64 Null = std::numeric_limits<qint64>::min(); // нет даты (NULL в БД)
+
+    static qint64 now();
+    // Локальное время "yyyy-MM-dd HH:mm:ss" для таблицы; пустая строка для Null
+    static QString toDisplay(qint64 ms);
+    // ISO 8601 в UTC с миллисекундами ("2024-05-01T09:30:00.000Z") — для экспорта и консоли
+    static QString toIso(qint64 ms);
+    // Принимает ISO 8601 (с зоной или без — тогда локальное время), прежний формат
+    // "yyyy-MM-dd HH:mm:ss" (локальное время) или число миллисекунд. false — не разобрано.
+    static bool parse(const QString &text, qint64 *ms);
+
+    // toDisplay() с кэшем по секундам; строка общая (счётчик ссылок), повторный вызов без аллокаций
+    QString display(qint64 ms) const;
+    void clear() { m_cache.clear(); }
+
+private:
+    mutable QHash<qint64, QString> m_cache;
+};
+
+#endif // TIMESTAMPFORMAT_H
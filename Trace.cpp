@@ -0,0 +1,164 @@
+#include "Trace.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+// Ёмкость буфера (степень двойки): при переполнении затираются самые старые интервалы
+constexpr quint64 Capacity = 1u << 14;
+
+// Слот буфера. seq — номер записи (index + 1), пока слот дописывается — 0: читатель
+// проверяет seq до и после копирования и пропускает слот, который меняли в это время.
+// Поля атомарные (relaxed), чтобы одновременные чтение и запись не были гонкой данных.
+struct Slot {
+    std::atomic<quint64> seq{0};
+    std::atomic<const char *> name{nullptr};
+    std::atomic<qint64> start{0};
+    std::atomic<qint64> duration{0};
+    std::atomic<qint64> rows{-1};
+    std::atomic<int> thread{0};
+};
+
+struct Event {
+    const char *name;
+    qint64 start;
+    qint64 duration;
+    qint64 rows;
+    int thread;
+};
+
+Slot g_slots[Capacity];
+std::atomic<quint64> g_head{0};
+std::atomic<int> g_nextThread{1};
+
+// Короткий номер потока для tid в Chrome trace
+int threadNumber()
+{
+    thread_local const int number = g_nextThread.fetch_add(1, std::memory_order_relaxed);
+    return number;
+}
+
+QVector<Event> snapshot()
+{
+    QVector<Event> events;
+    const quint64 head = g_head.load(std::memory_order_acquire);
+    const quint64 first = head > Capacity ? head - Capacity : 0;
+    events.reserve(int(head - first));
+    for (quint64 index = first; index < head; ++index) {
+        const Slot &slot = g_slots[index & (Capacity - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != index + 1)
+            continue;
+        Event e{ slot.name.load(std::memory_order_relaxed), slot.start.load(std::memory_order_relaxed),
+                 slot.duration.load(std::memory_order_relaxed), slot.rows.load(std::memory_order_relaxed),
+                 slot.thread.load(std::memory_order_relaxed) };
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != index + 1 || !e.name)
+            continue;
+        events.append(e);
+    }
+    return events;
+}
+}
+
+std::atomic<bool> Trace::s_enabled{ qEnvironmentVariableIntValue("TRACKER_TRACE") != 0 };
+
+void Trace::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Trace::clear()
+{
+    for (Slot &slot : g_slots)
+        slot.seq.store(0, std::memory_order_relaxed);
+}
+
+qint64 Trace::nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::record(const char *name, qint64 startNs, qint64 durationNs, qint64 rows)
+{
+    const quint64 index = g_head.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = g_slots[index & (Capacity - 1)];
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(startNs, std::memory_order_relaxed);
+    slot.duration.store(durationNs, std::memory_order_relaxed);
+    slot.rows.store(rows, std::memory_order_relaxed);
+    slot.thread.store(threadNumber(), std::memory_order_relaxed);
+    slot.seq.store(index + 1, std::memory_order_release);
+}
+
+QVector<Trace::SpanStats> Trace::stats()
+{
+    QHash<const char *, QVector<qint64>> durations;
+    for (const Event &e : snapshot())
+        durations[e.name].append(e.duration);
+
+    QVector<SpanStats> result;
+    result.reserve(durations.size());
+    for (auto it = durations.begin(); it != durations.end(); ++it) {
+        QVector<qint64> &ns = it.value();
+        std::sort(ns.begin(), ns.end());
+        const int n = int(ns.size());
+        SpanStats s;
+        s.name = it.key();
+        s.count = n;
+        s.p50Ns = ns.at(n / 2);
+        s.p99Ns = ns.at(qBound(0, (n * 99 + 99) / 100 - 1, n - 1));
+        s.maxNs = ns.last();
+        result.append(s);
+    }
+    std::sort(result.begin(), result.end(), [](const SpanStats &a, const SpanStats &b) {
+        return qstrcmp(a.name, b.name) < 0;
+    });
+    return result;
+}
+
+bool Trace::exportChromeTrace(const QString &path, QString *error)
+{
+    const QVector<Event> events = snapshot();
+    const qint64 origin = events.isEmpty() ? 0 : std::min_element(events.begin(), events.end(),
+        [](const Event &a, const Event &b) { return a.start < b.start; })->start;
+
+    // Имена интервалов — литералы без кавычек и обратных слэшей, экранировать нечего
+    QByteArray json;
+    json.reserve(events.size() * 96 + 64);
+    json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (int i = 0; i < events.size(); ++i) {
+        const Event &e = events.at(i);
+        if (i > 0)
+            json += ',';
+        json += "\n{\"name\":\"";
+        json += e.name;
+        json += "\",\"cat\":\"tracker\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+        json += QByteArray::number(e.thread);
+        json += ",\"ts\":";
+        json += QByteArray::number(double(e.start - origin) / 1000.0, 'f', 3);
+        json += ",\"dur\":";
+        json += QByteArray::number(double(e.duration) / 1000.0, 'f', 3);
+        if (e.rows >= 0) {
+            json += ",\"args\":{\"rows\":";
+            json += QByteArray::number(e.rows);
+            json += '}';
+        }
+        json += '}';
+    }
+    json += "\n]}\n";
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+    return true;
+}
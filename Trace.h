@@ -0,0 +1,76 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+// Трассировка горячих путей: интервалы (TraceSpan) пишутся в кольцевой буфер фиксированного
+// размера без блокировок — из потока GUI и потоков БД одновременно. Буфер выгружается в
+// формате Chrome trace (chrome://tracing, Perfetto) и сводится в p50/p99 для оверлея (PerfOverlay).
+//
+// Выключенная трассировка стоит одного атомарного чтения на интервал. Включается переменной
+// окружения TRACKER_TRACE=1 или из меню (Вид → Производительность).
+class Trace
+{
+public:
+    // Сводка по интервалам одного имени за то, что сейчас лежит в буфере
+    struct SpanStats {
+        const char *name = nullptr;
+        int count = 0;
+        qint64 p50Ns = 0;
+        qint64 p99Ns = 0;
+        qint64 maxNs = 0;
+    };
+
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+    // Забывает записанные интервалы
+    static void clear();
+
+    // name — строковый литерал (хранится указатель); rows < 0 — без числа строк
+    static void record(const char *name, qint64 startNs, qint64 durationNs, qint64 rows);
+    static qint64 nowNs();
+
+    static QVector<SpanStats> stats();
+    // JSON для chrome://tracing: события "X" с длительностью, args.rows — число строк
+    static bool exportChromeTrace(const QString &path, QString *error = nullptr);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+// Интервал от конструктора до деструктора. Пример:
+//   TraceSpan span("sql.page");
+//   ...
+//   span.setRows(page.rowCount());
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name)
+        : m_name(name)
+        , m_start(Trace::isEnabled() ? Trace::nowNs() : -1)
+        , m_rows(-1)
+    {
+    }
+    ~TraceSpan() { finish(); }
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    void setRows(qint64 rows) { m_rows = rows; }
+    // Закрывает интервал раньше конца области видимости
+    void finish()
+    {
+        if (m_start >= 0)
+            Trace::record(m_name, m_start, Trace::nowNs() - m_start, m_rows);
+        m_start = -1;
+    }
+
+private:
+    const char *m_name;
+    qint64 m_start; // -1 — трассировка была выключена при входе
+    qint64 m_rows;
+};
+
+#endif // TRACE_H